@@ -12,29 +12,64 @@
 
 #include "buffer/buffer_pool_manager_instance.h"
 
+#include <algorithm>
+#include <new>
+#include <vector>
+
 #include "common/macros.h"
 
 namespace bustub {
 
 BufferPoolManagerInstance::BufferPoolManagerInstance(size_t pool_size, DiskManager *disk_manager,
-                                                     LogManager *log_manager)
-    : BufferPoolManagerInstance(pool_size, 1, 0, disk_manager, log_manager) {}
+                                                     LogManager *log_manager, Replacer *replacer)
+    : BufferPoolManagerInstance(pool_size, 1, 0, disk_manager, log_manager, replacer) {}
+
+/** @return log2 of the number of frames per chunk of a pool that starts with pool_size frames */
+static uint32_t ChunkShift(size_t pool_size) {
+  uint32_t shift = 6;
+  while ((static_cast<size_t>(1) << shift) < pool_size) {
+    shift++;
+  }
+  return shift;
+}
+
+BufferPoolManagerInstance::FrameChunk::FrameChunk(size_t num_frames, bool huge_pages)
+    : num_frames_(num_frames), arena_(num_frames, huge_pages), descriptors_(num_frames) {
+  // Frame data lives in the arena and the book-keeping information in the descriptor table. Pages tie them together.
+  pages_ = static_cast<Page *>(::operator new[](num_frames_ * sizeof(Page)));
+  for (size_t i = 0; i < num_frames_; ++i) {
+    auto frame_id = static_cast<frame_id_t>(i);
+    new (&pages_[i]) Page(arena_.GetFrame(frame_id), &descriptors_, frame_id);
+    descriptors_.PinCount(frame_id) = NOT_PINNABLE;
+  }
+}
+
+BufferPoolManagerInstance::FrameChunk::~FrameChunk() {
+  for (size_t i = 0; i < num_frames_; ++i) {
+    pages_[i].~Page();
+  }
+  ::operator delete[](pages_);
+}
 
 BufferPoolManagerInstance::BufferPoolManagerInstance(size_t pool_size, uint32_t num_instances, uint32_t instance_index,
-                                                     DiskManager *disk_manager, LogManager *log_manager)
+                                                     DiskManager *disk_manager, LogManager *log_manager,
+                                                     Replacer *replacer)
     : pool_size_(pool_size),
       num_instances_(num_instances),
       instance_index_(instance_index),
-      next_page_id_(instance_index),
+      chunk_shift_(ChunkShift(pool_size)),
+      chunk_mask_((1 << chunk_shift_) - 1),
+      chunks_(std::make_unique<std::unique_ptr<FrameChunk>[]>(MAX_FRAME_CHUNKS)),
       disk_manager_(disk_manager),
-      log_manager_(log_manager) {
+      log_manager_(log_manager),
+      page_table_(pool_size) {
   BUSTUB_ASSERT(num_instances > 0, "If BPI is not part of a pool, then the pool size should just be 1");
   BUSTUB_ASSERT(
       instance_index < num_instances,
       "BPI index cannot be greater than the number of BPIs in the pool. In non-parallel case, index should just be 1.");
-  // We allocate a consecutive memory space for the buffer pool.
-  pages_ = new Page[pool_size_];
-  replacer_ = new LRUReplacer(pool_size);
+  // The initial pool always fits into the first chunk.
+  chunks_[num_chunks_++] = std::make_unique<FrameChunk>(static_cast<size_t>(1) << chunk_shift_, enable_huge_pages);
+  replacer_ = replacer != nullptr ? replacer : new LRUReplacer(pool_size);
 
   // Initially, every page is in the free list.
   for (size_t i = 0; i < pool_size_; ++i) {
@@ -43,55 +78,594 @@ BufferPoolManagerInstance::BufferPoolManagerInstance(size_t pool_size, uint32_t
 }
 
 BufferPoolManagerInstance::~BufferPoolManagerInstance() {
-  delete[] pages_;
+  ShutDownPrefetcher();
+  StopBackgroundWriter();
   delete replacer_;
 }
 
+size_t BufferPoolManagerInstance::Resize(size_t pool_size) {
+  std::unique_lock lock(latch_);
+  pool_size = std::min(pool_size, MAX_FRAME_CHUNKS << chunk_shift_);
+  size_t old_pool_size = pool_size_;
+  if (pool_size > old_pool_size) {
+    // Make room for the new frames everywhere before handing any of them out.
+    while ((num_chunks_ << chunk_shift_) < pool_size) {
+      chunks_[num_chunks_++] = std::make_unique<FrameChunk>(static_cast<size_t>(1) << chunk_shift_, enable_huge_pages);
+    }
+    replacer_->Grow(num_chunks_ << chunk_shift_);
+    page_table_.Reserve(pool_size);
+  }
+  pool_size_ = pool_size;
+
+  if (pool_size > old_pool_size) {
+    // Frames that were still draining stay with their pinned pages; the others are free.
+    for (size_t i = old_pool_size; i < pool_size; i++) {
+      auto frame_id = static_cast<frame_id_t>(i);
+      if (FramePage(frame_id)->page_id_ == INVALID_PAGE_ID) {
+        free_list_.push_back(frame_id);
+      }
+    }
+  } else {
+    free_list_.remove_if([pool_size](frame_id_t frame_id) { return static_cast<size_t>(frame_id) >= pool_size; });
+  }
+
+  std::vector<page_id_t> draining;
+  for (size_t i = pool_size; i < (num_chunks_ << chunk_shift_); i++) {
+    auto frame_id = static_cast<frame_id_t>(i);
+    Page *page = FramePage(frame_id);
+    if (page->page_id_ == INVALID_PAGE_ID) {
+      continue;
+    }
+    if (ClaimFrame(frame_id)) {
+      RetireFrame(frame_id);
+    } else {
+      draining.push_back(page->page_id_);
+    }
+  }
+  if (draining.empty()) {
+    return 0;
+  }
+
+  // Pin caches may be all that keeps a draining frame pinned. Their last unpin retires the frame.
+  lock.unlock();
+  bool released = false;
+  for (page_id_t page_id : draining) {
+    released = ReleaseCachedPins(page_id) || released;
+  }
+  if (!released) {
+    return draining.size();
+  }
+  lock.lock();
+  size_t still_draining = 0;
+  for (size_t i = pool_size_; i < (num_chunks_ << chunk_shift_); i++) {
+    if (FramePage(static_cast<frame_id_t>(i))->page_id_ != INVALID_PAGE_ID) {
+      still_draining++;
+    }
+  }
+  return still_draining;
+}
+
+BufferPoolStatsSnapshot BufferPoolManagerInstance::GetStatsSnapshot() {
+  BufferPoolStatsSnapshot snapshot = stats_.Snapshot();
+  snapshot.pool_size_ = pool_size_.load(std::memory_order_relaxed);
+  snapshot.pinned_frames_ = pinned_frames_.load(std::memory_order_relaxed);
+  return snapshot;
+}
+
+void BufferPoolManagerInstance::StartBackgroundWriter(size_t max_pages_per_round) {
+  if (bg_writer_.joinable()) {
+    return;
+  }
+  bg_writer_stop_ = false;
+  bg_writer_ = std::thread([this, max_pages_per_round] {
+    std::unique_lock lock(bg_writer_latch_);
+    while (!bg_writer_cv_.wait_for(lock, bg_writer_delay, [this] { return bg_writer_stop_; })) {
+      lock.unlock();
+      CleanVictimPages(max_pages_per_round);
+      lock.lock();
+    }
+  });
+}
+
+void BufferPoolManagerInstance::StopBackgroundWriter() {
+  if (!bg_writer_.joinable()) {
+    return;
+  }
+  {
+    std::scoped_lock lock(bg_writer_latch_);
+    bg_writer_stop_ = true;
+  }
+  bg_writer_cv_.notify_all();
+  bg_writer_.join();
+}
+
+size_t BufferPoolManagerInstance::CleanVictimPages(size_t max_pages) {
+  size_t written = 0;
+  for (frame_id_t frame_id : replacer_->PeekVictims(max_pages)) {
+    Page *page = FramePage(frame_id);
+    page_id_t page_id;
+    {
+      std::scoped_lock lock(latch_);
+      // The frame may have been pinned or reassigned since it was listed.
+      if (page->pin_count_ != 0 || page->page_id_ == INVALID_PAGE_ID || !page->is_dirty_) {
+        continue;
+      }
+      // WAL: the log records describing the page must reach disk before the page does.
+      if (enable_logging && log_manager_ != nullptr && page->GetLSN() > log_manager_->GetPersistentLSN()) {
+        continue;
+      }
+      // The pin keeps the page in its frame while it is written. Unlike a fetch, it does not count as a reference.
+      TryPin(frame_id, false);
+      page_id = page->page_id_;
+    }
+    // Pages are pinned without latch_, so a writer may hold the page latch by now; wait for it with latch_ released.
+    // The read latch keeps writers out while the page is written, so the page stays dirty until the write is done.
+    page->RLatch();
+    if (disk_manager_->WritePage(page_id, page->GetData())) {
+      page->is_dirty_ = false;
+      stats_.background_writes_.Add();
+      written++;
+    }
+    page->RUnlatch();
+    ReleasePin(frame_id);
+  }
+  return written;
+}
+
 bool BufferPoolManagerInstance::FlushPgImp(page_id_t page_id) {
-  // Make sure you call DiskManager::WritePage!
-  return false;
+  std::scoped_lock lock(latch_);
+  frame_id_t frame_id;
+  if (page_id == INVALID_PAGE_ID || !page_table_.Find(page_id, &frame_id)) {
+    return false;
+  }
+  Page *page = FramePage(frame_id);
+  if (page->pin_count_ == NOT_PINNABLE) {
+    // The page is still being read, so it is clean and its frame holds no data yet.
+    return true;
+  }
+  if (disk_manager_->WritePage(page_id, page->GetData())) {
+    page->is_dirty_ = false;
+    stats_.flushed_pages_.Add();
+  }
+  return true;
 }
 
-void BufferPoolManagerInstance::FlushAllPgsImp() {
-  // You can do it!
+void BufferPoolManagerInstance::FlushAllPgsImp() { FlushAllPgsBatched({this}); }
+
+void BufferPoolManagerInstance::FlushAllPgsBatched(const std::vector<BufferPoolManagerInstance *> &instances) {
+  if (instances.empty()) {
+    return;
+  }
+  struct FlushedPage {
+    BufferPoolManagerInstance *instance_;
+    Page *page_;
+    page_id_t page_id_;
+    /** Page version when the page was collected; only valid if versioned_. */
+    uint64_t version_;
+    bool versioned_;
+    /** True if the page was written and synced. */
+    bool written_;
+  };
+  std::vector<FlushedPage> flushed;
+  std::vector<std::pair<page_id_t, const char *>> dirty_pages;
+  for (auto *instance : instances) {
+    BUSTUB_ASSERT(instance->disk_manager_ == instances[0]->disk_manager_, "batched flush needs a shared disk manager");
+    auto lock = instance->LockLatch();
+    // Frames beyond the pool size may still hold pages that were pinned when the pool shrank, so sweep every chunk.
+    for (size_t c = 0; c < instance->num_chunks_; c++) {
+      FrameChunk *chunk = instance->chunks_[c].get();
+      auto &descriptors = chunk->descriptors_;
+      for (size_t i = 0; i < chunk->num_frames_; i++) {
+        auto frame_id = static_cast<frame_id_t>(i);
+        // Only the dense dirty flags are read for clean frames.
+        if (!descriptors.Dirty(frame_id) || descriptors.PageId(frame_id) == INVALID_PAGE_ID) {
+          continue;
+        }
+        Page *page = &chunk->pages_[i];
+        // The pin keeps the page in its frame while it is written. Unlike a fetch, it does not count as a reference.
+        // Pages are pinned without latch_, so their users may hold the page latch; take it only after the write.
+        if (instance->TryPin(static_cast<frame_id_t>((c << instance->chunk_shift_) | i), false) == NOT_PINNABLE) {
+          continue;
+        }
+        FlushedPage entry{instance, page, page->page_id_, 0, false, false};
+        entry.versioned_ = page->TryOptimisticRead(&entry.version_);
+        flushed.push_back(entry);
+        dirty_pages.emplace_back(entry.page_id_, page->GetData());
+      }
+    }
+  }
+  // On return, dirty_pages only holds the pages that were written and synced. The others stay dirty.
+  instances[0]->disk_manager_->WritePages(&dirty_pages);
+  auto written = [&dirty_pages](page_id_t page_id) {
+    auto it = std::lower_bound(dirty_pages.begin(), dirty_pages.end(), page_id,
+                               [](const auto &page, page_id_t id) { return page.first < id; });
+    return it != dirty_pages.end() && it->first == page_id;
+  };
+  for (auto &entry : flushed) {
+    entry.written_ = written(entry.page_id_);
+    if (entry.written_) {
+      entry.instance_->stats_.flushed_pages_.Add();
+    }
+  }
+
+  for (auto &entry : flushed) {
+    // Writers bump the version under the write latch and mark the page dirty after they release it, so a page whose
+    // version is unchanged under the read latch was written as it is.
+    entry.page_->RLatch();
+    if (entry.written_ && entry.versioned_ && entry.page_->ValidateOptimisticRead(entry.version_)) {
+      entry.page_->is_dirty_ = false;
+    }
+    entry.page_->RUnlatch();
+    entry.instance_->UnpinPgImp(entry.page_id_, false);
+  }
 }
 
-Page *BufferPoolManagerInstance::NewPgImp(page_id_t *page_id) {
-  // 0.   Make sure you call AllocatePage!
-  // 1.   If all the pages in the buffer pool are pinned, return nullptr.
-  // 2.   Pick a victim page P from either the free list or the replacer. Always pick from the free list first.
-  // 3.   Update P's metadata, zero out memory and add P to the page table.
-  // 4.   Set the page ID output parameter. Return a pointer to P.
-  return nullptr;
+Page *BufferPoolManagerInstance::NewPgImp(page_id_t *page_id) { return NewPgImp(page_id, DEFAULT_TABLESPACE_ID); }
+
+Page *BufferPoolManagerInstance::NewPgImp(page_id_t *page_id, tablespace_id_t space_id) {
+  auto lock = LockLatch();
+  frame_id_t frame_id;
+  if (!GetVictimFrame(&frame_id)) {
+    stats_.no_frame_failures_.Add();
+    return nullptr;
+  }
+  Page *page = FramePage(frame_id);
+  *page_id = AllocatePage(space_id);
+  if (*page_id == INVALID_PAGE_ID) {
+    page->page_id_.store(INVALID_PAGE_ID, std::memory_order_release);
+    free_list_.push_back(frame_id);
+    return nullptr;
+  }
+  page->is_dirty_ = false;
+  page->ResetMemory();
+  // Publish the frame only once its data is ready: a lock-free fetch holding a stale page table entry for this frame
+  // can pin it as soon as the pin count is no longer NOT_PINNABLE.
+  page->page_id_.store(*page_id, std::memory_order_release);
+  page->pin_count_.store(1, std::memory_order_release);
+  page_table_.Insert(*page_id, frame_id);
+  replacer_->Load(frame_id, *page_id);
+  OnPinned(frame_id);
+  stats_.new_pages_.Add();
+  return page;
 }
 
-Page *BufferPoolManagerInstance::FetchPgImp(page_id_t page_id) {
-  // 1.     Search the page table for the requested page (P).
-  // 1.1    If P exists, pin it and return it immediately.
-  // 1.2    If P does not exist, find a replacement page (R) from either the free list or the replacer.
-  //        Note that pages are always found from the free list first.
-  // 2.     If R is dirty, write it back to the disk.
-  // 3.     Delete R from the page table and insert P.
-  // 4.     Update P's metadata, read in the page content from disk, and then return a pointer to P.
-  return nullptr;
+Page *BufferPoolManagerInstance::FetchPgImp(page_id_t page_id) { return FetchPgImp(page_id, nullptr); }
+
+Page *BufferPoolManagerInstance::FetchPgImp(page_id_t page_id, BufferAccessStrategy *strategy) {
+  if (strategy != nullptr && strategy->GetHint() == AccessHint::NORMAL) {
+    strategy = nullptr;
+  }
+
+  // Fast path: the page is resident. Pinning it does not take latch_, even if it is the first pin.
+  frame_id_t frame_id;
+  if (page_table_.Find(page_id, &frame_id) && TryPin(frame_id, true) != NOT_PINNABLE) {
+    // The lookup was lock-free, so the frame may have been reassigned in between. Our pin now keeps it stable.
+    Page *page = FramePage(frame_id);
+    if (page->page_id_.load(std::memory_order_acquire) == page_id) {
+      stats_.fetch_hits_.Add();
+      return page;
+    }
+    ReleasePin(frame_id);
+  }
+
+  // The page is not resident, or its frame is being evicted or read.
+  auto lock = LockLatch();
+  while (page_table_.Find(page_id, &frame_id)) {
+    // Under latch_, every frame in the page table holds its page, unless the page is still being read.
+    if (TryPin(frame_id, true) != NOT_PINNABLE) {
+      stats_.fetch_hits_.Add();
+      return FramePage(frame_id);
+    }
+    // Wait for the read instead of reading the page a second time. If it fails, the page leaves the page table.
+    io_cv_.wait(lock);
+  }
+  ScopedLatencyTimer miss_timer(&stats_.fetch_miss_latency_);
+  if (!ReserveFrame(page_id, strategy, &frame_id)) {
+    stats_.no_frame_failures_.Add();
+    return nullptr;
+  }
+  stats_.fetch_misses_.Add();
+  Page *page = FramePage(frame_id);
+  // The reserved frame cannot be pinned, evicted or reassigned, so the read runs without latch_.
+  lock.unlock();
+  bool read_ok = disk_manager_->ReadPageAsync(page_id, page->GetData()).get();
+  lock = LockLatch();
+  if (!FinishLoad(frame_id, read_ok, 1)) {
+    return nullptr;
+  }
+  if (strategy != nullptr) {
+    strategy->AddPage(instance_index_, RingCapacity(strategy), page_id);
+  }
+  return page;
+}
+
+std::future<bool> BufferPoolManagerInstance::StartPrefetchPgImp(page_id_t page_id) {
+  frame_id_t frame_id;
+  {
+    auto lock = LockLatch();
+    if (page_table_.Find(page_id, &frame_id) || !ReserveFrame(page_id, nullptr, &frame_id)) {
+      return {};
+    }
+  }
+  stats_.fetch_misses_.Add();
+  return disk_manager_->ReadPageAsync(page_id, FramePage(frame_id)->GetData());
+}
+
+void BufferPoolManagerInstance::FinishPrefetchPgImp(page_id_t page_id, std::future<bool> read) {
+  bool read_ok = read.get();
+  auto lock = LockLatch();
+  frame_id_t frame_id;
+  // Nothing can take a reserved frame out of the page table.
+  [[maybe_unused]] bool found = page_table_.Find(page_id, &frame_id);
+  BUSTUB_ASSERT(found, "prefetched page must keep its frame");
+  FinishLoad(frame_id, read_ok, 0);
+}
+
+bool BufferPoolManagerInstance::ReserveFrame(page_id_t page_id, BufferAccessStrategy *strategy, frame_id_t *frame_id) {
+  if (!GetVictimFrame(frame_id, strategy)) {
+    return false;
+  }
+  Page *page = FramePage(*frame_id);
+  page->is_dirty_ = false;
+  page->page_id_.store(page_id, std::memory_order_release);
+  page_table_.Insert(page_id, *frame_id);
+  return true;
+}
+
+bool BufferPoolManagerInstance::FinishLoad(frame_id_t frame_id, bool read_ok, int pin_count) {
+  Page *page = FramePage(frame_id);
+  page_id_t page_id = page->page_id_;
+  io_cv_.notify_all();
+  if (!read_ok) {
+    if (static_cast<size_t>(frame_id) < pool_size_) {
+      DropFrame(frame_id);
+    } else {
+      RetireFrame(frame_id);
+    }
+    return false;
+  }
+  if (pin_count == 0 && static_cast<size_t>(frame_id) >= pool_size_) {
+    // The pool shrank during the read, and nobody waits for the page yet.
+    RetireFrame(frame_id);
+    return true;
+  }
+  // Loading a page counts as its first reference for replacers that keep access history.
+  replacer_->Load(frame_id, page_id);
+  if (pin_count == 0) {
+    replacer_->Unpin(frame_id);
+    page->pin_count_.store(0, std::memory_order_release);
+    return true;
+  }
+  // Publish the frame only once its data is ready: lock-free fetches of the page may pin it from now on.
+  page->pin_count_.store(pin_count, std::memory_order_release);
+  OnPinned(frame_id);
+  return true;
 }
 
 bool BufferPoolManagerInstance::DeletePgImp(page_id_t page_id) {
-  // 0.   Make sure you call DeallocatePage!
-  // 1.   Search the page table for the requested page (P).
-  // 1.   If P does not exist, return true.
-  // 2.   If P exists, but has a non-zero pin-count, return false. Someone is using the page.
-  // 3.   Otherwise, P can be deleted. Remove P from the page table, reset its metadata and return it to the free list.
+  auto try_delete = [this, page_id] {
+    std::scoped_lock lock(latch_);
+    frame_id_t frame_id;
+    if (!page_table_.Find(page_id, &frame_id)) {
+      DeallocatePage(page_id);
+      return true;
+    }
+    if (!ClaimFrame(frame_id)) {
+      return false;
+    }
+    DeallocatePage(page_id);
+    DropFrame(frame_id);
+    return true;
+  };
+  // A pin cache may be all that keeps the page pinned.
+  return try_delete() || (ReleaseCachedPins(page_id) && try_delete());
+}
+
+bool BufferPoolManagerInstance::DiscardTablespacePgsImp(tablespace_id_t space_id) {
+  auto try_discard = [this, space_id] {
+    auto lock = LockLatch();
+    std::vector<frame_id_t> frame_ids;
+    // Like a batched flush, sweep every chunk, not just the frames within the pool size.
+    for (size_t c = 0; c < num_chunks_; c++) {
+      FrameChunk *chunk = chunks_[c].get();
+      auto &descriptors = chunk->descriptors_;
+      for (size_t i = 0; i < chunk->num_frames_; i++) {
+        auto frame_id = static_cast<frame_id_t>(i);
+        page_id_t page_id = descriptors.PageId(frame_id);
+        if (page_id == INVALID_PAGE_ID || TablespaceOf(page_id) != space_id) {
+          continue;
+        }
+        frame_ids.push_back(static_cast<frame_id_t>((c << chunk_shift_) | i));
+        if (!ClaimFrame(frame_ids.back())) {
+          // Pinned; give the frames claimed so far back.
+          frame_ids.pop_back();
+          for (auto claimed : frame_ids) {
+            FramePage(claimed)->pin_count_ = 0;
+          }
+          return false;
+        }
+      }
+    }
+    for (auto frame_id : frame_ids) {
+      DropFrame(frame_id);
+    }
+    return true;
+  };
+  // Pin caches may be all that keeps pages of the tablespace pinned.
+  return try_discard() || (ReleaseCachedPins() && try_discard());
+}
+
+void BufferPoolManagerInstance::DropFrame(frame_id_t frame_id) {
+  Page *page = FramePage(frame_id);
+  page_table_.Remove(page->page_id_);
+  replacer_->Remove(frame_id);
+  page->page_id_.store(INVALID_PAGE_ID, std::memory_order_release);
+  page->is_dirty_ = false;
+  page->ResetMemory();
+  free_list_.push_back(frame_id);
+}
+
+bool BufferPoolManagerInstance::UnpinPgImp(page_id_t page_id, bool is_dirty) {
+  // The caller's pin keeps the frame from being reassigned, so this does not need latch_.
+  frame_id_t frame_id;
+  if (!page_table_.Find(page_id, &frame_id) ||
+      FramePage(frame_id)->page_id_.load(std::memory_order_acquire) != page_id) {
+    // A lock-free lookup may miss an entry that Compact is moving, or see a stale one. Only a latched one is final.
+    std::scoped_lock lock(latch_);
+    if (!page_table_.Find(page_id, &frame_id)) {
+      return false;
+    }
+  }
+  Page *page = FramePage(frame_id);
+  int pin_count = page->pin_count_.load();
+  do {
+    if (pin_count <= 0) {
+      return false;
+    }
+    if (is_dirty) {
+      page->is_dirty_.store(true, std::memory_order_release);
+    }
+  } while (!page->pin_count_.compare_exchange_weak(pin_count, pin_count - 1));
+  if (pin_count == 1) {
+    OnUnpinned(frame_id);
+  }
+  return true;
+}
+
+int BufferPoolManagerInstance::TryPin(frame_id_t frame_id, bool reference) {
+  Page *page = FramePage(frame_id);
+  int pin_count = page->pin_count_.load();
+  if (pin_count == 0 && reference) {
+    // Tell the replacer before the pin count changes, so that its unpin, which follows the pin count dropping to 0,
+    // cannot come first and leave an unpinned frame out of the replacer. The replacer may list a pinned frame for a
+    // while instead; ClaimVictim skips those.
+    replacer_->Pin(frame_id);
+  }
+  while (pin_count != NOT_PINNABLE) {
+    if (page->pin_count_.compare_exchange_weak(pin_count, pin_count + 1, std::memory_order_acq_rel)) {
+      if (pin_count == 0) {
+        pinned_frames_.fetch_add(1, std::memory_order_relaxed);
+      }
+      return pin_count;
+    }
+  }
+  return NOT_PINNABLE;
+}
+
+void BufferPoolManagerInstance::ReleasePin(frame_id_t frame_id) {
+  if (FramePage(frame_id)->pin_count_.fetch_sub(1) == 1) {
+    OnUnpinned(frame_id);
+  }
+}
+
+bool BufferPoolManagerInstance::ClaimFrame(frame_id_t frame_id) {
+  int unpinned = 0;
+  return FramePage(frame_id)->pin_count_.compare_exchange_strong(unpinned, NOT_PINNABLE);
+}
+
+bool BufferPoolManagerInstance::ClaimVictim(frame_id_t *frame_id) {
+  while (replacer_->Victim(frame_id)) {
+    if (!ClaimFrame(*frame_id)) {
+      // Pinned since it was unpinned; its next unpin gives it back to the replacer.
+      continue;
+    }
+    if (static_cast<size_t>(*frame_id) >= pool_size_) {
+      // The pool shrank while the frame was listed.
+      RetireFrame(*frame_id);
+      continue;
+    }
+    return true;
+  }
   return false;
 }
 
-bool BufferPoolManagerInstance::UnpinPgImp(page_id_t page_id, bool is_dirty) { return false; }
+bool BufferPoolManagerInstance::GetVictimFrame(frame_id_t *frame_id, BufferAccessStrategy *strategy) {
+  ScopedLatencyTimer timer(&stats_.victim_search_latency_);
+  if (strategy != nullptr) {
+    // Recycle the ring's oldest frame if it still holds the page the strategy loaded into it and nobody uses it.
+    page_id_t ring_page_id = strategy->GetReusablePage(instance_index_, RingCapacity(strategy));
+    if (ring_page_id != INVALID_PAGE_ID && page_table_.Find(ring_page_id, frame_id) &&
+        static_cast<size_t>(*frame_id) < pool_size_ && ClaimFrame(*frame_id)) {
+      replacer_->Remove(*frame_id);
+      EvictFrame(*frame_id);
+      return true;
+    }
+  }
+  if (!free_list_.empty()) {
+    *frame_id = free_list_.front();
+    free_list_.pop_front();
+    return true;
+  }
+  if (!ClaimVictim(frame_id)) {
+    return false;
+  }
+  EvictFrame(*frame_id);
+  return true;
+}
+
+void BufferPoolManagerInstance::EvictFrame(frame_id_t frame_id) {
+  Page *page = FramePage(frame_id);
+  BUSTUB_ASSERT(page->pin_count_ == NOT_PINNABLE, "victim frame must be claimed");
+  if (page->is_dirty_) {
+    ScopedLatencyTimer timer(&stats_.write_back_latency_);
+    disk_manager_->WritePage(page->page_id_, page->GetData());
+    page->is_dirty_ = false;
+    stats_.dirty_evictions_.Add();
+  }
+  page_table_.Remove(page->page_id_);
+  stats_.evictions_.Add();
+}
+
+std::unique_lock<std::mutex> BufferPoolManagerInstance::LockLatch() {
+  std::unique_lock lock(latch_, std::try_to_lock);
+  if (!lock.owns_lock()) {
+    stats_.latch_contentions_.Add();
+    ScopedLatencyTimer timer(&stats_.latch_wait_latency_);
+    lock.lock();
+  }
+  return lock;
+}
+
+void BufferPoolManagerInstance::OnPinned(frame_id_t frame_id) {
+  pinned_frames_.fetch_add(1, std::memory_order_relaxed);
+  replacer_->Pin(frame_id);
+}
+
+void BufferPoolManagerInstance::OnUnpinned(frame_id_t frame_id) {
+  pinned_frames_.fetch_sub(1, std::memory_order_relaxed);
+  if (static_cast<size_t>(frame_id) >= pool_size_) {
+    // The pool shrank while the page was pinned. Unless somebody pinned it again meanwhile, retire the frame.
+    auto lock = LockLatch();
+    if (ClaimFrame(frame_id)) {
+      RetireFrame(frame_id);
+    }
+    return;
+  }
+  // The frame may have been pinned again, dropped or even reassigned since its pin count dropped to 0, so the replacer
+  // may list a frame that is pinned or free. ClaimVictim skips those.
+  replacer_->Unpin(frame_id);
+}
+
+void BufferPoolManagerInstance::RetireFrame(frame_id_t frame_id) {
+  Page *page = FramePage(frame_id);
+  replacer_->Remove(frame_id);
+  EvictFrame(frame_id);
+  page->page_id_.store(INVALID_PAGE_ID, std::memory_order_release);
+  chunks_[frame_id >> chunk_shift_]->arena_.Release(frame_id & chunk_mask_);
+}
+
+page_id_t BufferPoolManagerInstance::AllocatePage(tablespace_id_t space_id) {
+  // The disk manager only hands out page ids that mod back to this BPI.
+  const page_id_t page_id = disk_manager_->AllocatePage(num_instances_, instance_index_, space_id);
+  if (page_id != INVALID_PAGE_ID) {
+    ValidatePageId(page_id);
+  }
+  return page_id;
+}
 
-page_id_t BufferPoolManagerInstance::AllocatePage() {
-  const page_id_t next_page_id = next_page_id_;
-  next_page_id_ += num_instances_;
-  ValidatePageId(next_page_id);
-  return next_page_id;
+void BufferPoolManagerInstance::DeallocatePage(page_id_t page_id) {
+  ValidatePageId(page_id);
+  disk_manager_->DeallocatePage(page_id);
 }
 
 void BufferPoolManagerInstance::ValidatePageId(const page_id_t page_id) const {
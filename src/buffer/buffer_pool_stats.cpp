@@ -0,0 +1,162 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// buffer_pool_stats.cpp
+//
+// Identification: src/buffer/buffer_pool_stats.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "buffer/buffer_pool_stats.h"
+
+#include <algorithm>
+#include <cmath>
+#include <sstream>
+
+namespace bustub {
+
+size_t ShardedCounter::ShardIndex() {
+  static std::atomic<size_t> next_shard{0};
+  thread_local size_t shard = next_shard.fetch_add(1, std::memory_order_relaxed) % NUM_SHARDS;
+  return shard;
+}
+
+void HistogramSnapshot::Merge(const HistogramSnapshot &other) {
+  for (size_t i = 0; i < NUM_BUCKETS; i++) {
+    buckets_[i] += other.buckets_[i];
+  }
+  count_ += other.count_;
+  sum_ns_ += other.sum_ns_;
+}
+
+uint64_t HistogramSnapshot::PercentileNs(double percentile) const {
+  if (count_ == 0) {
+    return 0;
+  }
+  auto rank = static_cast<uint64_t>(std::ceil(percentile / 100 * static_cast<double>(count_)));
+  rank = std::clamp<uint64_t>(rank, 1, count_);
+  uint64_t seen = 0;
+  for (size_t i = 0; i < NUM_BUCKETS; i++) {
+    seen += buckets_[i];
+    if (seen >= rank) {
+      return (static_cast<uint64_t>(1) << (i + 1)) - 1;
+    }
+  }
+  return (static_cast<uint64_t>(1) << NUM_BUCKETS) - 1;
+}
+
+void LatencyHistogram::Record(std::chrono::nanoseconds latency) {
+  auto ns = static_cast<uint64_t>(std::max<int64_t>(latency.count(), 0));
+  size_t bucket = 0;
+  while (bucket + 1 < HistogramSnapshot::NUM_BUCKETS && (ns >> (bucket + 1)) != 0) {
+    bucket++;
+  }
+  buckets_[bucket].fetch_add(1, std::memory_order_relaxed);
+  sum_ns_.fetch_add(ns, std::memory_order_relaxed);
+}
+
+HistogramSnapshot LatencyHistogram::Snapshot() const {
+  HistogramSnapshot snapshot;
+  for (size_t i = 0; i < HistogramSnapshot::NUM_BUCKETS; i++) {
+    snapshot.buckets_[i] = buckets_[i].load(std::memory_order_relaxed);
+    snapshot.count_ += snapshot.buckets_[i];
+  }
+  snapshot.sum_ns_ = sum_ns_.load(std::memory_order_relaxed);
+  return snapshot;
+}
+
+void BufferPoolStatsSnapshot::Merge(const BufferPoolStatsSnapshot &other) {
+  pool_size_ += other.pool_size_;
+  pinned_frames_ += other.pinned_frames_;
+  fetch_hits_ += other.fetch_hits_;
+  fetch_misses_ += other.fetch_misses_;
+  no_frame_failures_ += other.no_frame_failures_;
+  new_pages_ += other.new_pages_;
+  evictions_ += other.evictions_;
+  dirty_evictions_ += other.dirty_evictions_;
+  background_writes_ += other.background_writes_;
+  flushed_pages_ += other.flushed_pages_;
+  latch_contentions_ += other.latch_contentions_;
+  fetch_miss_latency_.Merge(other.fetch_miss_latency_);
+  victim_search_latency_.Merge(other.victim_search_latency_);
+  write_back_latency_.Merge(other.write_back_latency_);
+  latch_wait_latency_.Merge(other.latch_wait_latency_);
+}
+
+static void HistogramToString(std::ostringstream *os, const char *name, const HistogramSnapshot &histogram) {
+  *os << name << ": count=" << histogram.count_ << " mean=" << histogram.MeanNs()
+      << "ns p50<=" << histogram.PercentileNs(50) << "ns p99<=" << histogram.PercentileNs(99) << "ns\n";
+}
+
+std::string BufferPoolStatsSnapshot::ToString() const {
+  std::ostringstream os;
+  os << "pool_size=" << pool_size_ << " pinned_frames=" << pinned_frames_ << "\n";
+  os << "fetch_hits=" << fetch_hits_ << " fetch_misses=" << fetch_misses_ << " hit_ratio=" << HitRatio()
+     << " no_frame_failures=" << no_frame_failures_ << " new_pages=" << new_pages_ << "\n";
+  os << "evictions=" << evictions_ << " dirty_evictions=" << dirty_evictions_
+     << " background_writes=" << background_writes_ << " flushed_pages=" << flushed_pages_
+     << " latch_contentions=" << latch_contentions_ << "\n";
+  HistogramToString(&os, "fetch_miss_latency", fetch_miss_latency_);
+  HistogramToString(&os, "victim_search_latency", victim_search_latency_);
+  HistogramToString(&os, "write_back_latency", write_back_latency_);
+  HistogramToString(&os, "latch_wait_latency", latch_wait_latency_);
+  return os.str();
+}
+
+static void HistogramToJson(std::ostringstream *os, const char *name, const HistogramSnapshot &histogram) {
+  *os << "\"" << name << "\":{\"count\":" << histogram.count_ << ",\"sum_ns\":" << histogram.sum_ns_
+      << ",\"mean_ns\":" << histogram.MeanNs() << ",\"p50_ns\":" << histogram.PercentileNs(50)
+      << ",\"p99_ns\":" << histogram.PercentileNs(99) << ",\"buckets\":{";
+  // Keyed by the lower bound of the bucket in nanoseconds; empty buckets are left out.
+  bool first = true;
+  for (size_t i = 0; i < HistogramSnapshot::NUM_BUCKETS; i++) {
+    if (histogram.buckets_[i] == 0) {
+      continue;
+    }
+    *os << (first ? "" : ",") << "\"" << (i == 0 ? 0 : static_cast<uint64_t>(1) << i) << "\":" << histogram.buckets_[i];
+    first = false;
+  }
+  *os << "}}";
+}
+
+std::string BufferPoolStatsSnapshot::ToJson() const {
+  std::ostringstream os;
+  os << "{\"pool_size\":" << pool_size_ << ",\"pinned_frames\":" << pinned_frames_ << ",\"fetch_hits\":" << fetch_hits_
+     << ",\"fetch_misses\":" << fetch_misses_ << ",\"hit_ratio\":" << HitRatio()
+     << ",\"no_frame_failures\":" << no_frame_failures_ << ",\"new_pages\":" << new_pages_
+     << ",\"evictions\":" << evictions_ << ",\"dirty_evictions\":" << dirty_evictions_
+     << ",\"background_writes\":" << background_writes_ << ",\"flushed_pages\":" << flushed_pages_
+     << ",\"latch_contentions\":" << latch_contentions_ << ",";
+  HistogramToJson(&os, "fetch_miss_latency", fetch_miss_latency_);
+  os << ",";
+  HistogramToJson(&os, "victim_search_latency", victim_search_latency_);
+  os << ",";
+  HistogramToJson(&os, "write_back_latency", write_back_latency_);
+  os << ",";
+  HistogramToJson(&os, "latch_wait_latency", latch_wait_latency_);
+  os << "}";
+  return os.str();
+}
+
+BufferPoolStatsSnapshot BufferPoolStats::Snapshot() const {
+  BufferPoolStatsSnapshot snapshot;
+  snapshot.fetch_hits_ = fetch_hits_.Sum();
+  snapshot.fetch_misses_ = fetch_misses_.Sum();
+  snapshot.no_frame_failures_ = no_frame_failures_.Sum();
+  snapshot.new_pages_ = new_pages_.Sum();
+  snapshot.evictions_ = evictions_.Sum();
+  snapshot.dirty_evictions_ = dirty_evictions_.Sum();
+  snapshot.background_writes_ = background_writes_.Sum();
+  snapshot.flushed_pages_ = flushed_pages_.Sum();
+  snapshot.latch_contentions_ = latch_contentions_.Sum();
+  snapshot.fetch_miss_latency_ = fetch_miss_latency_.Snapshot();
+  snapshot.victim_search_latency_ = victim_search_latency_.Snapshot();
+  snapshot.write_back_latency_ = write_back_latency_.Snapshot();
+  snapshot.latch_wait_latency_ = latch_wait_latency_.Snapshot();
+  return snapshot;
+}
+
+}  // namespace bustub
@@ -14,16 +14,75 @@
 
 namespace bustub {
 
-ClockReplacer::ClockReplacer(size_t num_pages) {}
+ClockReplacer::ClockReplacer(size_t num_pages) : in_clock_(num_pages, false), ref_(num_pages, false) {}
 
 ClockReplacer::~ClockReplacer() = default;
 
-bool ClockReplacer::Victim(frame_id_t *frame_id) { return false; }
+bool ClockReplacer::Victim(frame_id_t *frame_id) {
+  std::scoped_lock lock(latch_);
+  if (size_ == 0) {
+    return false;
+  }
+  // At most two sweeps: the first one may only clear reference bits.
+  while (true) {
+    if (in_clock_[hand_]) {
+      if (ref_[hand_]) {
+        ref_[hand_] = false;
+      } else {
+        *frame_id = static_cast<frame_id_t>(hand_);
+        in_clock_[hand_] = false;
+        size_--;
+        hand_ = (hand_ + 1) % in_clock_.size();
+        return true;
+      }
+    }
+    hand_ = (hand_ + 1) % in_clock_.size();
+  }
+}
 
-void ClockReplacer::Pin(frame_id_t frame_id) {}
+void ClockReplacer::Pin(frame_id_t frame_id) {
+  std::scoped_lock lock(latch_);
+  if (in_clock_[frame_id]) {
+    in_clock_[frame_id] = false;
+    size_--;
+  }
+}
 
-void ClockReplacer::Unpin(frame_id_t frame_id) {}
+void ClockReplacer::Unpin(frame_id_t frame_id) {
+  std::scoped_lock lock(latch_);
+  if (!in_clock_[frame_id]) {
+    in_clock_[frame_id] = true;
+    size_++;
+  }
+  ref_[frame_id] = true;
+}
 
-size_t ClockReplacer::Size() { return 0; }
+std::vector<frame_id_t> ClockReplacer::PeekVictims(size_t max_frames) {
+  std::scoped_lock lock(latch_);
+  // Frames without a reference bit go on the hand's first sweep, the others on its second.
+  std::vector<frame_id_t> victims;
+  for (bool referenced : {false, true}) {
+    for (size_t i = 0; i < in_clock_.size() && victims.size() < max_frames; i++) {
+      size_t frame = (hand_ + i) % in_clock_.size();
+      if (in_clock_[frame] && ref_[frame] == referenced) {
+        victims.push_back(static_cast<frame_id_t>(frame));
+      }
+    }
+  }
+  return victims;
+}
+
+void ClockReplacer::Grow(size_t num_pages) {
+  std::scoped_lock lock(latch_);
+  if (num_pages > in_clock_.size()) {
+    in_clock_.resize(num_pages, false);
+    ref_.resize(num_pages, false);
+  }
+}
+
+size_t ClockReplacer::Size() {
+  std::scoped_lock lock(latch_);
+  return size_;
+}
 
 }  // namespace bustub
@@ -0,0 +1,66 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// frame_arena.cpp
+//
+// Identification: src/buffer/frame_arena.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "buffer/frame_arena.h"
+
+#include <sys/mman.h>
+
+#include <algorithm>
+#include <cstdint>
+
+#include "common/exception.h"
+
+namespace bustub {
+
+FrameArena::FrameArena(size_t num_frames, bool huge_pages) {
+  size_t size = std::max<size_t>(num_frames, 1) * PAGE_SIZE;
+  huge_pages = huge_pages && size >= HUGE_PAGE_SIZE;
+  if (huge_pages) {
+    size_t huge_size = (size + HUGE_PAGE_SIZE - 1) / HUGE_PAGE_SIZE * HUGE_PAGE_SIZE;
+    mapping_ = mmap(nullptr, huge_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+    if (mapping_ != MAP_FAILED) {
+      mapping_size_ = huge_size;
+      base_ = static_cast<char *>(mapping_);
+      explicit_huge_pages_ = true;
+      return;
+    }
+    // No huge pages reserved: over-allocate so that the frames can start on a huge page boundary, and ask for
+    // transparent huge pages.
+    mapping_size_ = huge_size + HUGE_PAGE_SIZE;
+  } else {
+    // Mappings are only aligned to the OS page size, which may be smaller than PAGE_SIZE.
+    mapping_size_ = size + PAGE_SIZE;
+  }
+  mapping_ = mmap(nullptr, mapping_size_, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (mapping_ == MAP_FAILED) {
+    throw Exception(ExceptionType::OUT_OF_MEMORY, "can't map buffer pool frames");
+  }
+  base_ = static_cast<char *>(mapping_);
+  auto addr = reinterpret_cast<uintptr_t>(mapping_);
+  if (huge_pages) {
+    base_ += (HUGE_PAGE_SIZE - addr % HUGE_PAGE_SIZE) % HUGE_PAGE_SIZE;
+    madvise(base_, mapping_size_ - HUGE_PAGE_SIZE, MADV_HUGEPAGE);
+  } else {
+    base_ += (PAGE_SIZE - addr % PAGE_SIZE) % PAGE_SIZE;
+  }
+}
+
+FrameArena::~FrameArena() { munmap(mapping_, mapping_size_); }
+
+void FrameArena::Release(frame_id_t frame_id) {
+  // Explicit huge pages can only be released as a whole, so those frames simply keep their memory.
+  if (!explicit_huge_pages_) {
+    madvise(GetFrame(frame_id), PAGE_SIZE, MADV_DONTNEED);
+  }
+}
+
+}  // namespace bustub
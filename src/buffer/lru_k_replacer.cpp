@@ -0,0 +1,120 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// lru_k_replacer.cpp
+//
+// Identification: src/buffer/lru_k_replacer.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "buffer/lru_k_replacer.h"
+
+#include "common/macros.h"
+
+namespace bustub {
+
+LRUKReplacer::LRUKReplacer(size_t num_pages, size_t k, size_t correlated_reference_period)
+    : k_(k), correlated_reference_period_(correlated_reference_period), frames_(num_pages) {
+  BUSTUB_ASSERT(k > 0, "LRU-K needs to remember at least one reference");
+}
+
+LRUKReplacer::~LRUKReplacer() = default;
+
+LRUKReplacer::EvictionKey LRUKReplacer::KeyOf(frame_id_t frame_id) const {
+  const auto &history = frames_[frame_id].history_;
+  uint64_t oldest = history.empty() ? 0 : history.front();
+  return {history.size() >= k_, oldest, frame_id};
+}
+
+bool LRUKReplacer::Victim(frame_id_t *frame_id) {
+  std::scoped_lock lock(latch_);
+  if (evictable_.empty()) {
+    return false;
+  }
+  auto victim = evictable_.begin();
+  for (auto it = evictable_.begin(); it != evictable_.end(); ++it) {
+    if (!InCorrelatedPeriod(frames_[std::get<2>(*it)])) {
+      victim = it;
+      break;
+    }
+  }
+  *frame_id = std::get<2>(*victim);
+  evictable_.erase(victim);
+  frames_[*frame_id].evictable_ = false;
+  frames_[*frame_id].history_.clear();
+  return true;
+}
+
+void LRUKReplacer::Pin(frame_id_t frame_id) {
+  std::scoped_lock lock(latch_);
+  auto &frame = frames_[frame_id];
+  if (frame.evictable_) {
+    evictable_.erase(KeyOf(frame_id));
+    frame.evictable_ = false;
+  }
+  uint64_t now = current_timestamp_++;
+  if (frame.history_.empty() || now - frame.last_ >= correlated_reference_period_) {
+    // An uncorrelated reference. The burst before it counts as a single reference at its start, so the older
+    // references move up by the length of the burst (O'Neil et al.).
+    uint64_t burst = frame.history_.empty() ? 0 : frame.last_ - frame.history_.back();
+    for (auto &timestamp : frame.history_) {
+      timestamp += burst;
+    }
+    frame.history_.push_back(now);
+    if (frame.history_.size() > k_) {
+      frame.history_.pop_front();
+    }
+  }
+  frame.last_ = now;
+}
+
+void LRUKReplacer::Unpin(frame_id_t frame_id) {
+  std::scoped_lock lock(latch_);
+  auto &frame = frames_[frame_id];
+  if (frame.evictable_) {
+    return;
+  }
+  frame.evictable_ = true;
+  evictable_.insert(KeyOf(frame_id));
+}
+
+void LRUKReplacer::Remove(frame_id_t frame_id) {
+  std::scoped_lock lock(latch_);
+  auto &frame = frames_[frame_id];
+  if (frame.evictable_) {
+    evictable_.erase(KeyOf(frame_id));
+    frame.evictable_ = false;
+  }
+  frame.history_.clear();
+}
+
+std::vector<frame_id_t> LRUKReplacer::PeekVictims(size_t max_frames) {
+  std::scoped_lock lock(latch_);
+  // Same order as successive calls to Victim: frames outside their correlated reference period go first.
+  std::vector<frame_id_t> victims;
+  for (bool correlated : {false, true}) {
+    for (auto it = evictable_.begin(); it != evictable_.end() && victims.size() < max_frames; ++it) {
+      if (InCorrelatedPeriod(frames_[std::get<2>(*it)]) == correlated) {
+        victims.push_back(std::get<2>(*it));
+      }
+    }
+  }
+  return victims;
+}
+
+void LRUKReplacer::Grow(size_t num_pages) {
+  std::scoped_lock lock(latch_);
+  if (num_pages > frames_.size()) {
+    frames_.resize(num_pages);
+  }
+}
+
+size_t LRUKReplacer::Size() {
+  std::scoped_lock lock(latch_);
+  return evictable_.size();
+}
+
+}  // namespace bustub
@@ -0,0 +1,138 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// page_table.cpp
+//
+// Identification: src/buffer/page_table.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "buffer/page_table.h"
+
+#include <utility>
+#include <vector>
+
+namespace bustub {
+
+PageTable::Slots::Slots(size_t max_entries) {
+  // Keep the load factor at or below 1/2 so that probe sequences stay short.
+  capacity_ = 2;
+  uint32_t log2 = 1;
+  while (capacity_ < 2 * max_entries) {
+    capacity_ <<= 1;
+    log2++;
+  }
+  shift_ = 64 - log2;
+  slots_ = std::make_unique<std::atomic<uint64_t>[]>(capacity_);
+  for (size_t i = 0; i < capacity_; i++) {
+    slots_[i].store(EMPTY, std::memory_order_relaxed);
+  }
+}
+
+PageTable::PageTable(size_t max_entries) {
+  slots_.push_back(std::make_unique<Slots>(max_entries));
+  current_.store(slots_.back().get(), std::memory_order_release);
+}
+
+bool PageTable::Find(page_id_t page_id, frame_id_t *frame_id) const {
+  const Slots &slots = *current_.load(std::memory_order_acquire);
+  size_t mask = slots.capacity_ - 1;
+  size_t idx = HomeSlot(slots, page_id);
+  for (size_t probes = 0; probes < slots.capacity_; probes++, idx = (idx + 1) & mask) {
+    uint64_t slot = slots.slots_[idx].load(std::memory_order_acquire);
+    if (slot == EMPTY) {
+      return false;
+    }
+    if (slot != TOMBSTONE && UnpackPageId(slot) == page_id) {
+      *frame_id = UnpackFrameId(slot);
+      return true;
+    }
+  }
+  return false;
+}
+
+void PageTable::Insert(page_id_t page_id, frame_id_t frame_id) {
+  Slots *slots = current_.load(std::memory_order_relaxed);
+  if (size_ + tombstones_ + 1 > slots->capacity_ / 2) {
+    Compact();
+  }
+  size_t mask = slots->capacity_ - 1;
+  size_t idx = HomeSlot(*slots, page_id);
+  uint64_t slot = slots->slots_[idx].load(std::memory_order_relaxed);
+  while (slot != EMPTY && slot != TOMBSTONE) {
+    BUSTUB_ASSERT(UnpackPageId(slot) != page_id, "page is already in the page table");
+    idx = (idx + 1) & mask;
+    slot = slots->slots_[idx].load(std::memory_order_relaxed);
+  }
+  tombstones_ -= slot == TOMBSTONE ? 1 : 0;
+  slots->slots_[idx].store(Pack(page_id, frame_id), std::memory_order_release);
+  size_++;
+}
+
+void PageTable::InsertInto(Slots *slots, page_id_t page_id, frame_id_t frame_id) {
+  size_t mask = slots->capacity_ - 1;
+  size_t idx = HomeSlot(*slots, page_id);
+  while (slots->slots_[idx].load(std::memory_order_relaxed) != EMPTY) {
+    idx = (idx + 1) & mask;
+  }
+  slots->slots_[idx].store(Pack(page_id, frame_id), std::memory_order_release);
+}
+
+bool PageTable::Remove(page_id_t page_id) {
+  Slots *slots = current_.load(std::memory_order_relaxed);
+  size_t mask = slots->capacity_ - 1;
+  size_t idx = HomeSlot(*slots, page_id);
+  for (size_t probes = 0; probes < slots->capacity_; probes++, idx = (idx + 1) & mask) {
+    uint64_t slot = slots->slots_[idx].load(std::memory_order_relaxed);
+    if (slot == EMPTY) {
+      return false;
+    }
+    if (slot != TOMBSTONE && UnpackPageId(slot) == page_id) {
+      // Readers must keep probing past this slot, so leave a tombstone rather than an empty slot.
+      slots->slots_[idx].store(TOMBSTONE, std::memory_order_release);
+      size_--;
+      tombstones_++;
+      return true;
+    }
+  }
+  return false;
+}
+
+void PageTable::Reserve(size_t max_entries) {
+  Slots *old_slots = current_.load(std::memory_order_relaxed);
+  if (2 * max_entries <= old_slots->capacity_) {
+    return;
+  }
+  auto new_slots = std::make_unique<Slots>(max_entries);
+  for (size_t i = 0; i < old_slots->capacity_; i++) {
+    uint64_t slot = old_slots->slots_[i].load(std::memory_order_relaxed);
+    if (slot != EMPTY && slot != TOMBSTONE) {
+      InsertInto(new_slots.get(), UnpackPageId(slot), UnpackFrameId(slot));
+    }
+  }
+  tombstones_ = 0;
+  current_.store(new_slots.get(), std::memory_order_release);
+  slots_.push_back(std::move(new_slots));
+}
+
+void PageTable::Compact() {
+  Slots *slots = current_.load(std::memory_order_relaxed);
+  std::vector<uint64_t> live;
+  live.reserve(size_);
+  for (size_t i = 0; i < slots->capacity_; i++) {
+    uint64_t slot = slots->slots_[i].load(std::memory_order_relaxed);
+    if (slot != EMPTY && slot != TOMBSTONE) {
+      live.push_back(slot);
+    }
+    slots->slots_[i].store(EMPTY, std::memory_order_release);
+  }
+  tombstones_ = 0;
+  for (auto slot : live) {
+    InsertInto(slots, UnpackPageId(slot), UnpackFrameId(slot));
+  }
+}
+
+}  // namespace bustub
@@ -12,58 +12,210 @@
 
 #include "buffer/parallel_buffer_pool_manager.h"
 
+#include <algorithm>
+
 namespace bustub {
 
 ParallelBufferPoolManager::ParallelBufferPoolManager(size_t num_instances, size_t pool_size, DiskManager *disk_manager,
                                                      LogManager *log_manager) {
   // Allocate and create individual BufferPoolManagerInstances
+  for (size_t i = 0; i < num_instances; i++) {
+    instances_.push_back(new BufferPoolManagerInstance(pool_size, num_instances, i, disk_manager, log_manager));
+  }
 }
 
 // Update constructor to destruct all BufferPoolManagerInstances and deallocate any associated memory
-ParallelBufferPoolManager::~ParallelBufferPoolManager() = default;
+ParallelBufferPoolManager::~ParallelBufferPoolManager() {
+  ShutDownPrefetcher();
+  for (auto *instance : instances_) {
+    delete instance;
+  }
+}
+
+size_t ParallelBufferPoolManager::Resize(size_t pool_size) {
+  size_t draining = 0;
+  for (auto *instance : instances_) {
+    draining += instance->Resize(pool_size);
+  }
+  return draining;
+}
+
+size_t ParallelBufferPoolManager::ResizeInstance(size_t instance_index, size_t pool_size) {
+  return instances_[instance_index]->Resize(pool_size);
+}
+
+void ParallelBufferPoolManager::StartBackgroundWriter(size_t max_pages_per_round) {
+  for (auto *instance : instances_) {
+    instance->StartBackgroundWriter(max_pages_per_round);
+  }
+}
+
+void ParallelBufferPoolManager::StopBackgroundWriter() {
+  for (auto *instance : instances_) {
+    instance->StopBackgroundWriter();
+  }
+}
 
 size_t ParallelBufferPoolManager::GetPoolSize() {
   // Get size of all BufferPoolManagerInstances
-  return 0;
+  size_t pool_size = 0;
+  for (auto *instance : instances_) {
+    pool_size += instance->GetPoolSize();
+  }
+  return pool_size;
+}
+
+void ParallelBufferPoolManager::RegisterPinCache(PinCache *cache) {
+  for (auto *instance : instances_) {
+    instance->RegisterPinCache(cache);
+  }
+}
+
+void ParallelBufferPoolManager::UnregisterPinCache(PinCache *cache) {
+  for (auto *instance : instances_) {
+    instance->UnregisterPinCache(cache);
+  }
 }
 
 BufferPoolManager *ParallelBufferPoolManager::GetBufferPoolManager(page_id_t page_id) {
   // Get BufferPoolManager responsible for handling given page id. You can use this method in your other methods.
-  return nullptr;
+  return instances_[page_id % instances_.size()];
 }
 
 Page *ParallelBufferPoolManager::FetchPgImp(page_id_t page_id) {
   // Fetch page for page_id from responsible BufferPoolManagerInstance
-  return nullptr;
+  return GetBufferPoolManager(page_id)->FetchPage(page_id);
+}
+
+Page *ParallelBufferPoolManager::FetchPgImp(page_id_t page_id, BufferAccessStrategy *strategy) {
+  return GetBufferPoolManager(page_id)->FetchPage(page_id, strategy);
+}
+
+std::future<bool> ParallelBufferPoolManager::StartPrefetchPgImp(page_id_t page_id) {
+  return GetBufferPoolManager(page_id)->StartPrefetch(page_id);
+}
+
+void ParallelBufferPoolManager::FinishPrefetchPgImp(page_id_t page_id, std::future<bool> read) {
+  GetBufferPoolManager(page_id)->FinishPrefetch(page_id, std::move(read));
 }
 
 bool ParallelBufferPoolManager::UnpinPgImp(page_id_t page_id, bool is_dirty) {
   // Unpin page_id from responsible BufferPoolManagerInstance
-  return false;
+  return GetBufferPoolManager(page_id)->UnpinPage(page_id, is_dirty);
 }
 
 bool ParallelBufferPoolManager::FlushPgImp(page_id_t page_id) {
   // Flush page_id from responsible BufferPoolManagerInstance
-  return false;
+  return GetBufferPoolManager(page_id)->FlushPage(page_id);
 }
 
-Page *ParallelBufferPoolManager::NewPgImp(page_id_t *page_id) {
-  // create new page. We will request page allocation in a round robin manner from the underlying
-  // BufferPoolManagerInstances
-  // 1.   From a starting index of the BPMIs, call NewPageImpl until either 1) success and return 2) looped around to
-  // starting index and return nullptr
-  // 2.   Bump the starting index (mod number of instances) to start search at a different BPMI each time this function
-  // is called
+Page *ParallelBufferPoolManager::NewPgImp(page_id_t *page_id) { return NewPgImp(page_id, DEFAULT_TABLESPACE_ID); }
+
+Page *ParallelBufferPoolManager::NewPgImp(page_id_t *page_id, tablespace_id_t space_id) {
+  // New pages can go to any instance, so place them where there is room instead of strictly round robin: a
+  // saturated instance would otherwise take every n-th request, only to fail it. Start the search at a different
+  // instance each time so that equally loaded instances share the work.
+  size_t start;
+  {
+    std::scoped_lock lock(latch_);
+    start = next_instance_;
+    next_instance_ = (next_instance_ + 1) % instances_.size();
+  }
+  size_t picked = PickInstance(start);
+  Page *page = instances_[picked]->NewPage(page_id, space_id);
+  if (page != nullptr) {
+    return page;
+  }
+  // The stats are read without latching, so the pick may be stale. Fall back to trying every instance.
+  for (size_t i = 0; i < instances_.size(); i++) {
+    size_t index = (start + i) % instances_.size();
+    if (index == picked) {
+      continue;
+    }
+    page = instances_[index]->NewPage(page_id, space_id);
+    if (page != nullptr) {
+      return page;
+    }
+  }
   return nullptr;
 }
 
+size_t ParallelBufferPoolManager::PickInstance(size_t start) const {
+  size_t best = start;
+  BufferPoolInstanceStats best_stats = instances_[start]->GetStats();
+  for (size_t i = 1; i < instances_.size(); i++) {
+    size_t index = (start + i) % instances_.size();
+    BufferPoolInstanceStats stats = instances_[index]->GetStats();
+    if (stats.AvailableFrames() > best_stats.AvailableFrames() ||
+        (stats.AvailableFrames() == best_stats.AvailableFrames() &&
+         stats.latch_contentions_ < best_stats.latch_contentions_)) {
+      best = index;
+      best_stats = stats;
+    }
+  }
+  return best;
+}
+
+std::vector<BufferPoolInstanceStats> ParallelBufferPoolManager::GetInstanceStats() const {
+  std::vector<BufferPoolInstanceStats> stats;
+  stats.reserve(instances_.size());
+  for (auto *instance : instances_) {
+    stats.push_back(instance->GetStats());
+  }
+  return stats;
+}
+
+BufferPoolStatsSnapshot ParallelBufferPoolManager::GetStatsSnapshot() {
+  BufferPoolStatsSnapshot snapshot;
+  for (auto *instance : instances_) {
+    snapshot.Merge(instance->GetStatsSnapshot());
+  }
+  return snapshot;
+}
+
+size_t ParallelBufferPoolManager::Rebalance(size_t max_frames) {
+  std::scoped_lock lock(rebalance_latch_);
+  auto stats = GetInstanceStats();
+  size_t donor = 0;
+  size_t needy = 0;
+  for (size_t i = 1; i < stats.size(); i++) {
+    if (stats[i].AvailableFrames() > stats[donor].AvailableFrames()) {
+      donor = i;
+    }
+    if (stats[i].AvailableFrames() < stats[needy].AvailableFrames()) {
+      needy = i;
+    }
+  }
+  // Even out the available frames of the two, but keep at least one frame in the donor.
+  size_t frames = (stats[donor].AvailableFrames() - stats[needy].AvailableFrames()) / 2;
+  frames = std::min({frames, max_frames, stats[donor].pool_size_ - 1});
+  if (donor == needy || frames == 0) {
+    return 0;
+  }
+  // Grow first, so that the total never drops; the target may be capped at its maximum size.
+  size_t needy_size = instances_[needy]->GetPoolSize();
+  instances_[needy]->Resize(needy_size + frames);
+  frames = instances_[needy]->GetPoolSize() - needy_size;
+  instances_[donor]->Resize(instances_[donor]->GetPoolSize() - frames);
+  return frames;
+}
+
 bool ParallelBufferPoolManager::DeletePgImp(page_id_t page_id) {
   // Delete page_id from responsible BufferPoolManagerInstance
-  return false;
+  return GetBufferPoolManager(page_id)->DeletePage(page_id);
+}
+
+bool ParallelBufferPoolManager::DiscardTablespacePgsImp(tablespace_id_t space_id) {
+  bool discarded = true;
+  for (auto *instance : instances_) {
+    discarded = instance->DiscardTablespace(space_id) && discarded;
+  }
+  return discarded;
 }
 
 void ParallelBufferPoolManager::FlushAllPgsImp() {
-  // flush all pages from all BufferPoolManagerInstances
+  // flush all pages from all BufferPoolManagerInstances as one batch, so that the writes are sequential across them
+  BufferPoolManagerInstance::FlushAllPgsBatched(instances_);
 }
 
 }  // namespace bustub
@@ -0,0 +1,154 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// pin_cache.cpp
+//
+// Identification: src/buffer/pin_cache.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "buffer/pin_cache.h"
+
+#include "buffer/buffer_pool_manager.h"
+
+namespace bustub {
+
+PinCache::PinCache(BufferPoolManager *buffer_pool_manager, size_t capacity, uint64_t max_idle_epochs)
+    : buffer_pool_manager_(buffer_pool_manager), capacity_(capacity), max_idle_epochs_(max_idle_epochs) {
+  entries_.reserve(capacity_);
+  buffer_pool_manager_->RegisterPinCache(this);
+}
+
+PinCache::~PinCache() {
+  // Once unregistered, no release hook can reach the cache any more.
+  buffer_pool_manager_->UnregisterPinCache(this);
+  while (!entries_.empty()) {
+    ReleaseAt(entries_.size() - 1);
+  }
+}
+
+Page *PinCache::FetchPage(page_id_t page_id) {
+  std::scoped_lock lock(latch_);
+  Entry *entry = Find(page_id);
+  if (entry != nullptr) {
+    hits_++;
+    entry->ref_count_++;
+    entry->last_epoch_ = epoch_;
+    return entry->page_;
+  }
+  misses_++;
+  Page *page = buffer_pool_manager_->FetchPage(page_id);
+  if (page == nullptr && !entries_.empty()) {
+    // Our own idle pins may be what fills the buffer pool.
+    for (size_t i = entries_.size(); i-- > 0;) {
+      if (entries_[i].ref_count_ == 0) {
+        ReleaseAt(i);
+      }
+    }
+    page = buffer_pool_manager_->FetchPage(page_id);
+  }
+  if (page == nullptr) {
+    return nullptr;
+  }
+  if (entries_.size() >= capacity_) {
+    // If every cached page is in use, the cache goes over capacity until the next epoch.
+    ReleaseOldest();
+  }
+  entries_.push_back({page_id, page, 1, epoch_, false});
+  return page;
+}
+
+bool PinCache::UnpinPage(page_id_t page_id, bool is_dirty) {
+  std::scoped_lock lock(latch_);
+  Entry *entry = Find(page_id);
+  if (entry == nullptr) {
+    return buffer_pool_manager_->UnpinPage(page_id, is_dirty);
+  }
+  if (entry->ref_count_ == 0) {
+    return false;
+  }
+  if (is_dirty) {
+    // The cache's pin keeps the page in its frame, so the flag can be set on the page directly. Like an unpin, this
+    // comes after the caller released the page latch, which is what a batched flush relies on.
+    entry->page_->is_dirty_.store(true, std::memory_order_release);
+  }
+  if (--entry->ref_count_ == 0 && entry->release_) {
+    ReleaseAt(entry - entries_.data());
+  }
+  return true;
+}
+
+void PinCache::AdvanceEpoch() {
+  std::scoped_lock lock(latch_);
+  epoch_++;
+  for (size_t i = entries_.size(); i-- > 0;) {
+    if (entries_[i].ref_count_ == 0 && epoch_ - entries_[i].last_epoch_ > max_idle_epochs_) {
+      ReleaseAt(i);
+    }
+  }
+  while (entries_.size() > capacity_) {
+    if (!ReleaseOldest()) {
+      break;
+    }
+  }
+}
+
+void PinCache::Release(page_id_t page_id) {
+  std::scoped_lock lock(latch_);
+  Entry *entry = Find(page_id);
+  if (entry != nullptr) {
+    ReleaseOrDefer(entry - entries_.data());
+  }
+}
+
+void PinCache::ReleaseAll() {
+  std::scoped_lock lock(latch_);
+  for (size_t i = entries_.size(); i-- > 0;) {
+    ReleaseOrDefer(i);
+  }
+}
+
+PinCache::Entry *PinCache::Find(page_id_t page_id) {
+  for (auto &entry : entries_) {
+    if (entry.page_id_ == page_id) {
+      return &entry;
+    }
+  }
+  return nullptr;
+}
+
+void PinCache::ReleaseOrDefer(size_t index) {
+  if (entries_[index].ref_count_ == 0) {
+    ReleaseAt(index);
+  } else {
+    entries_[index].release_ = true;
+  }
+}
+
+void PinCache::ReleaseAt(size_t index) {
+  buffer_pool_manager_->UnpinPage(entries_[index].page_id_, false);
+  entries_[index] = entries_.back();
+  entries_.pop_back();
+}
+
+bool PinCache::ReleaseOldest() {
+  size_t oldest = entries_.size();
+  for (size_t i = 0; i < entries_.size(); i++) {
+    if (entries_[i].ref_count_ != 0) {
+      continue;
+    }
+    if (oldest == entries_.size() || entries_[i].last_epoch_ < entries_[oldest].last_epoch_) {
+      oldest = i;
+    }
+  }
+  if (oldest == entries_.size()) {
+    return false;
+  }
+  ReleaseAt(oldest);
+  return true;
+}
+
+}  // namespace bustub
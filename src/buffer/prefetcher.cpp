@@ -0,0 +1,100 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// prefetcher.cpp
+//
+// Identification: src/buffer/prefetcher.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "buffer/prefetcher.h"
+
+#include "buffer/buffer_pool_manager.h"
+
+namespace bustub {
+
+Prefetcher::Prefetcher(BufferPoolManager *buffer_pool_manager, size_t num_threads, size_t max_pending,
+                       size_t max_in_flight)
+    : buffer_pool_manager_(buffer_pool_manager), max_pending_(max_pending), max_in_flight_(max_in_flight) {
+  for (size_t i = 0; i < num_threads; i++) {
+    threads_.emplace_back(&Prefetcher::Run, this);
+  }
+}
+
+Prefetcher::~Prefetcher() {
+  {
+    std::scoped_lock lock(latch_);
+    shutdown_ = true;
+  }
+  cv_.notify_all();
+  for (auto &thread : threads_) {
+    thread.join();
+  }
+}
+
+void Prefetcher::Schedule(page_id_t page_id, size_t depth, prefetch_next_fn next_fn) {
+  if (page_id == INVALID_PAGE_ID) {
+    return;
+  }
+  {
+    std::scoped_lock lock(latch_);
+    if (shutdown_ || queue_.size() >= max_pending_ || queued_.count(page_id) != 0) {
+      return;
+    }
+    queue_.push_back({page_id, depth, next_fn});
+    queued_.insert(page_id);
+  }
+  cv_.notify_one();
+}
+
+void Prefetcher::Run() {
+  std::vector<Request> batch;
+  std::vector<std::future<bool>> reads;
+  while (true) {
+    {
+      std::unique_lock lock(latch_);
+      cv_.wait(lock, [&] { return shutdown_ || !queue_.empty(); });
+      if (shutdown_) {
+        return;
+      }
+      while (!queue_.empty() && batch.size() < max_in_flight_) {
+        batch.push_back(queue_.front());
+        queue_.pop_front();
+        queued_.erase(batch.back().page_id_);
+      }
+    }
+
+    // Submit every read of the batch before waiting for the first one, so that the reads overlap.
+    for (const auto &request : batch) {
+      reads.push_back(buffer_pool_manager_->StartPrefetch(request.page_id_));
+    }
+    for (size_t i = 0; i < batch.size(); i++) {
+      const Request &request = batch[i];
+      if (reads[i].valid()) {
+        buffer_pool_manager_->FinishPrefetch(request.page_id_, std::move(reads[i]));
+      }
+      if (request.depth_ == 0 || request.next_fn_ == nullptr) {
+        continue;
+      }
+      // The page is normally resident by now, so this fetch is a hit.
+      Page *page = buffer_pool_manager_->FetchPage(request.page_id_);
+      if (page == nullptr) {
+        continue;
+      }
+      page->RLatch();
+      page_id_t next_page_id = request.next_fn_(page);
+      page->RUnlatch();
+      buffer_pool_manager_->UnpinPage(request.page_id_, false);
+      if (next_page_id != INVALID_PAGE_ID) {
+        Schedule(next_page_id, request.depth_ - 1, request.next_fn_);
+      }
+    }
+    batch.clear();
+    reads.clear();
+  }
+}
+
+}  // namespace bustub
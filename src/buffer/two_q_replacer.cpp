@@ -0,0 +1,170 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// two_q_replacer.cpp
+//
+// Identification: src/buffer/two_q_replacer.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "buffer/two_q_replacer.h"
+
+#include <algorithm>
+
+namespace bustub {
+
+TwoQReplacer::TwoQReplacer(size_t num_pages, size_t a1_size, size_t a1out_size)
+    : a1_size_(a1_size == 0 ? std::max<size_t>(num_pages / 4, 1) : a1_size),
+      a1out_size_(a1out_size == 0 ? std::max<size_t>(num_pages / 2, 1) : a1out_size),
+      frames_(num_pages) {}
+
+TwoQReplacer::~TwoQReplacer() = default;
+
+bool TwoQReplacer::VictimFrom(std::list<frame_id_t> *queue, frame_id_t *frame_id) {
+  for (auto it = queue->begin(); it != queue->end(); ++it) {
+    if (frames_[*it].evictable_) {
+      *frame_id = *it;
+      auto &frame = frames_[*frame_id];
+      if (frame.queue_ == Queue::A1 && frame.page_id_ != INVALID_PAGE_ID) {
+        RememberEvicted(frame.page_id_);
+      }
+      Erase(*frame_id);
+      frame.page_id_ = INVALID_PAGE_ID;
+      return true;
+    }
+  }
+  return false;
+}
+
+void TwoQReplacer::Erase(frame_id_t frame_id) {
+  auto &frame = frames_[frame_id];
+  if (frame.queue_ == Queue::A1) {
+    a1_.erase(frame.pos_);
+  } else if (frame.queue_ == Queue::AM) {
+    am_.erase(frame.pos_);
+  }
+  if (frame.evictable_) {
+    size_--;
+  }
+  frame.queue_ = Queue::NONE;
+  frame.evictable_ = false;
+}
+
+void TwoQReplacer::RememberEvicted(page_id_t page_id) {
+  if (a1out_index_.count(page_id) != 0) {
+    return;
+  }
+  a1out_index_[page_id] = a1out_.insert(a1out_.end(), page_id);
+  if (a1out_.size() > a1out_size_) {
+    a1out_index_.erase(a1out_.front());
+    a1out_.pop_front();
+  }
+}
+
+bool TwoQReplacer::Victim(frame_id_t *frame_id) {
+  std::scoped_lock lock(latch_);
+  if (size_ == 0) {
+    return false;
+  }
+  if (a1_.size() > a1_size_) {
+    return VictimFrom(&a1_, frame_id) || VictimFrom(&am_, frame_id);
+  }
+  return VictimFrom(&am_, frame_id) || VictimFrom(&a1_, frame_id);
+}
+
+void TwoQReplacer::Pin(frame_id_t frame_id) {
+  std::scoped_lock lock(latch_);
+  auto &frame = frames_[frame_id];
+  if (frame.evictable_) {
+    frame.evictable_ = false;
+    size_--;
+  }
+  switch (frame.queue_) {
+    case Queue::NONE:
+      if (frame.ghost_hit_) {
+        frame.pos_ = am_.insert(am_.end(), frame_id);
+        frame.queue_ = Queue::AM;
+      } else {
+        frame.pos_ = a1_.insert(a1_.end(), frame_id);
+        frame.queue_ = Queue::A1;
+      }
+      frame.ghost_hit_ = false;
+      break;
+    case Queue::A1:
+      // Correlated reference: the page keeps its place in the FIFO.
+      break;
+    case Queue::AM:
+      am_.splice(am_.end(), am_, frame.pos_);
+      break;
+  }
+}
+
+void TwoQReplacer::Load(frame_id_t frame_id, page_id_t page_id) {
+  std::scoped_lock lock(latch_);
+  auto &frame = frames_[frame_id];
+  frame.page_id_ = page_id;
+  auto ghost = a1out_index_.find(page_id);
+  frame.ghost_hit_ = ghost != a1out_index_.end();
+  if (frame.ghost_hit_) {
+    a1out_.erase(ghost->second);
+    a1out_index_.erase(ghost);
+  }
+}
+
+void TwoQReplacer::Unpin(frame_id_t frame_id) {
+  std::scoped_lock lock(latch_);
+  auto &frame = frames_[frame_id];
+  if (frame.evictable_) {
+    return;
+  }
+  if (frame.queue_ == Queue::NONE) {
+    frame.pos_ = a1_.insert(a1_.end(), frame_id);
+    frame.queue_ = Queue::A1;
+  }
+  frame.evictable_ = true;
+  size_++;
+}
+
+void TwoQReplacer::Remove(frame_id_t frame_id) {
+  std::scoped_lock lock(latch_);
+  Erase(frame_id);
+  frames_[frame_id].page_id_ = INVALID_PAGE_ID;
+  frames_[frame_id].ghost_hit_ = false;
+}
+
+std::vector<frame_id_t> TwoQReplacer::PeekVictims(size_t max_frames) {
+  std::scoped_lock lock(latch_);
+  std::vector<frame_id_t> victims;
+  auto collect = [&](const std::list<frame_id_t> &queue) {
+    for (auto it = queue.begin(); it != queue.end() && victims.size() < max_frames; ++it) {
+      if (frames_[*it].evictable_) {
+        victims.push_back(*it);
+      }
+    }
+  };
+  if (a1_.size() > a1_size_) {
+    collect(a1_);
+    collect(am_);
+  } else {
+    collect(am_);
+    collect(a1_);
+  }
+  return victims;
+}
+
+void TwoQReplacer::Grow(size_t num_pages) {
+  std::scoped_lock lock(latch_);
+  if (num_pages > frames_.size()) {
+    frames_.resize(num_pages);
+  }
+}
+
+size_t TwoQReplacer::Size() {
+  std::scoped_lock lock(latch_);
+  return size_;
+}
+
+}  // namespace bustub
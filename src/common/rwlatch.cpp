@@ -0,0 +1,132 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// rwlatch.cpp
+//
+// Identification: src/common/rwlatch.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "common/rwlatch.h"
+
+#include <condition_variable>  // NOLINT
+#include <functional>
+#include <mutex>   // NOLINT
+#include <thread>  // NOLINT
+
+namespace bustub {
+
+namespace {
+
+/** Parked threads of all latches whose word hashes to the bucket. */
+struct alignas(64) ParkingBucket {
+  std::mutex mutex_;
+  std::condition_variable cv_;
+};
+
+constexpr size_t NUM_PARKING_BUCKETS = 64;
+
+ParkingBucket *GetParkingBucket(const std::atomic<uint32_t> *word) {
+  static std::array<ParkingBucket, NUM_PARKING_BUCKETS> buckets;
+  return &buckets[std::hash<const void *>()(word) / alignof(std::atomic<uint32_t>) % NUM_PARKING_BUCKETS];
+}
+
+}  // namespace
+
+void LatchParking::Pause() { std::this_thread::yield(); }
+
+bool LatchParking::ParkOnce(std::atomic<uint32_t> *word, predicate_fn can_proceed, const void *arg) {
+  ParkingBucket *bucket = GetParkingBucket(word);
+  std::unique_lock lock(bucket->mutex_);
+  // Once PARKED is visible, whoever changes the word next takes the bucket mutex before waking us, so the change
+  // cannot slip in between the check below and the wait.
+  uint32_t value = word->fetch_or(PARKED) | PARKED;
+  if (can_proceed(arg, value)) {
+    return true;
+  }
+  bucket->cv_.wait(lock);
+  return can_proceed(arg, word->load());
+}
+
+void LatchParking::UnparkAllSlow(std::atomic<uint32_t> *word) {
+  ParkingBucket *bucket = GetParkingBucket(word);
+  std::scoped_lock lock(bucket->mutex_);
+  // Threads that park again set the bit again. The bucket is shared, so unrelated latches see spurious wake-ups.
+  word->fetch_and(~PARKED);
+  bucket->cv_.notify_all();
+}
+
+size_t ShardedReaderWriterLatch::SlotIndex() {
+  static std::atomic<size_t> next_slot{0};
+  thread_local size_t slot = next_slot.fetch_add(1, std::memory_order_relaxed) % NUM_SLOTS;
+  return slot;
+}
+
+#ifndef NDEBUG
+int &ShardedReaderWriterLatch::HeldReadLatches() {
+  thread_local int held = 0;
+  return held;
+}
+#endif
+
+bool ShardedReaderWriterLatch::NoReaders() const {
+  for (const auto &slot : slots_) {
+    if (slot.readers_.load() != 0) {
+      return false;
+    }
+  }
+  return true;
+}
+
+void ShardedReaderWriterLatch::WLock() {
+  for (int spins = 0;; spins++) {
+    uint32_t state = writer_.load(std::memory_order_relaxed);
+    if ((state & WRITER) == 0) {
+      if (writer_.compare_exchange_weak(state, state | WRITER)) {
+        break;
+      }
+      continue;
+    }
+    if (spins < LatchParking::SPIN_LIMIT) {
+      LatchParking::Pause();
+    } else {
+      LatchParking::Park(&writer_, [](uint32_t value) { return (value & WRITER) == 0; });
+    }
+  }
+  // Readers that counted themselves before seeing the writer bit either leave or back out.
+  for (int spins = 0; !NoReaders(); spins++) {
+    if (spins < LatchParking::SPIN_LIMIT) {
+      LatchParking::Pause();
+    } else {
+      LatchParking::Park(&writer_, [this](uint32_t /*value*/) { return NoReaders(); });
+    }
+  }
+}
+
+void ShardedReaderWriterLatch::RLock() {
+  Slot &slot = slots_[SlotIndex()];
+  for (int spins = 0;; spins++) {
+    if ((writer_.load() & WRITER) == 0) {
+      slot.readers_.fetch_add(1);
+      if ((writer_.load() & WRITER) == 0) {
+#ifndef NDEBUG
+        HeldReadLatches()++;
+#endif
+        return;
+      }
+      // A writer came in between; back out, and wake it in case it is waiting for us.
+      slot.readers_.fetch_sub(1);
+      LatchParking::UnparkAll(&writer_);
+    }
+    if (spins < LatchParking::SPIN_LIMIT) {
+      LatchParking::Pause();
+    } else {
+      LatchParking::Park(&writer_, [](uint32_t value) { return (value & WRITER) == 0; });
+    }
+  }
+}
+
+}  // namespace bustub
@@ -10,11 +10,16 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include <algorithm>
 #include <iostream>
+#include <iterator>
+#include <memory>
 #include <string>
+#include <unordered_map>
 #include <utility>
 #include <vector>
 
+#include "buffer/pin_cache.h"
 #include "common/exception.h"
 #include "common/logger.h"
 #include "common/rid.h"
@@ -26,7 +31,22 @@ template <typename KeyType, typename ValueType, typename KeyComparator>
 HASH_TABLE_TYPE::ExtendibleHashTable(const std::string &name, BufferPoolManager *buffer_pool_manager,
                                      const KeyComparator &comparator, HashFunction<KeyType> hash_fn)
     : buffer_pool_manager_(buffer_pool_manager), comparator_(comparator), hash_fn_(std::move(hash_fn)) {
-  //  implement me!
+  // A new table has a directory of global depth 0 with a single bucket.
+  Page *dir = buffer_pool_manager_->NewPage(&directory_page_id_);
+  if (dir == nullptr) {
+    throw Exception(ExceptionType::OUT_OF_MEMORY, "can't create the hash table directory");
+  }
+  page_id_t bucket_page_id;
+  if (NewBucketPage(&bucket_page_id) == nullptr) {
+    buffer_pool_manager_->UnpinPage(directory_page_id_, false);
+    throw Exception(ExceptionType::OUT_OF_MEMORY, "can't create the hash table bucket");
+  }
+  HashTableDirectoryPage *dir_page = DirectoryOf(dir);
+  dir_page->SetPageId(directory_page_id_);
+  dir_page->SetBucketPageId(0, bucket_page_id);
+  dir_page->SetLocalDepth(0, 0);
+  buffer_pool_manager_->UnpinPage(bucket_page_id, true);
+  buffer_pool_manager_->UnpinPage(directory_page_id_, true);
 }
 
 /*****************************************************************************
@@ -45,23 +65,86 @@ uint32_t HASH_TABLE_TYPE::Hash(KeyType key) {
 }
 
 template <typename KeyType, typename ValueType, typename KeyComparator>
-inline uint32_t HASH_TABLE_TYPE::KeyToDirectoryIndex(KeyType key, HashTableDirectoryPage *dir_page) {
-  return 0;
+inline uint32_t HASH_TABLE_TYPE::KeyToDirectoryIndex(KeyType key, HashTableDirectory *dir) {
+  return Hash(key) & dir->GetGlobalDepthMask();
 }
 
 template <typename KeyType, typename ValueType, typename KeyComparator>
-inline uint32_t HASH_TABLE_TYPE::KeyToPageId(KeyType key, HashTableDirectoryPage *dir_page) {
-  return 0;
+inline uint32_t HASH_TABLE_TYPE::KeyToPageId(KeyType key, HashTableDirectory *dir) {
+  return dir->GetBucketPageId(KeyToDirectoryIndex(key, dir));
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+page_id_t HASH_TABLE_TYPE::LookupBucketPageId(const KeyType &key, Page *dir) {
+  HashTableDirectory directory(buffer_pool_manager_, DirectoryOf(dir));
+  return KeyToPageId(key, &directory);
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+Page *HASH_TABLE_TYPE::FetchPage(page_id_t page_id) {
+  Page *page = buffer_pool_manager_->FetchPage(page_id);
+  if (page == nullptr) {
+    LOG_DEBUG("no free frame for hash table page %d", page_id);
+  }
+  return page;
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+Page *HASH_TABLE_TYPE::NewBucketPage(page_id_t *page_id) {
+  Page *page = buffer_pool_manager_->NewPage(page_id);
+  if (page != nullptr) {
+    BucketOf(page)->SetOverflow(INVALID_PAGE_ID, 0);
+  }
+  return page;
 }
 
 template <typename KeyType, typename ValueType, typename KeyComparator>
 HashTableDirectoryPage *HASH_TABLE_TYPE::FetchDirectoryPage() {
-  return nullptr;
+  Page *page = FetchPage(directory_page_id_);
+  return page != nullptr ? DirectoryOf(page) : nullptr;
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+PinCache *HASH_TABLE_TYPE::PinCacheOf(Transaction *transaction) {
+  PinCache *cache = transaction != nullptr ? transaction->GetPinCache() : nullptr;
+  return cache != nullptr && cache->GetBufferPoolManager() == buffer_pool_manager_ ? cache : nullptr;
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+void HASH_TABLE_TYPE::StartOperation(Transaction *transaction) {
+  PinCache *cache = PinCacheOf(transaction);
+  if (cache != nullptr) {
+    cache->AdvanceEpoch();
+  }
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+Page *HASH_TABLE_TYPE::FetchDirectory(Transaction *transaction) {
+  PinCache *cache = PinCacheOf(transaction);
+  if (cache == nullptr) {
+    return FetchPage(directory_page_id_);
+  }
+  Page *page = cache->FetchPage(directory_page_id_);
+  if (page == nullptr) {
+    LOG_DEBUG("no free frame for hash table page %d", directory_page_id_);
+  }
+  return page;
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+void HASH_TABLE_TYPE::UnpinDirectory(Transaction *transaction, bool is_dirty) {
+  PinCache *cache = PinCacheOf(transaction);
+  if (cache == nullptr) {
+    buffer_pool_manager_->UnpinPage(directory_page_id_, is_dirty);
+  } else {
+    cache->UnpinPage(directory_page_id_, is_dirty);
+  }
 }
 
 template <typename KeyType, typename ValueType, typename KeyComparator>
 HASH_TABLE_BUCKET_TYPE *HASH_TABLE_TYPE::FetchBucketPage(page_id_t bucket_page_id) {
-  return nullptr;
+  Page *page = FetchPage(bucket_page_id);
+  return page != nullptr ? BucketOf(page) : nullptr;
 }
 
 /*****************************************************************************
@@ -69,7 +152,31 @@ HASH_TABLE_BUCKET_TYPE *HASH_TABLE_TYPE::FetchBucketPage(page_id_t bucket_page_i
  *****************************************************************************/
 template <typename KeyType, typename ValueType, typename KeyComparator>
 bool HASH_TABLE_TYPE::GetValue(Transaction *transaction, const KeyType &key, std::vector<ValueType> *result) {
-  return false;
+  StartOperation(transaction);
+  table_latch_.RLock();
+  Page *dir = FetchDirectory(transaction);
+  if (dir == nullptr) {
+    table_latch_.RUnlock();
+    return false;
+  }
+  dir->RLatch();
+  page_id_t bucket_page_id = LookupBucketPageId(key, dir);
+  Page *bucket = bucket_page_id != INVALID_PAGE_ID ? FetchPage(bucket_page_id) : nullptr;
+  if (bucket != nullptr) {
+    bucket->RLatch();
+  }
+  dir->RUnlatch();
+  UnpinDirectory(transaction, false);
+  bool found = false;
+  if (bucket != nullptr) {
+    HASH_TABLE_BUCKET_TYPE *bucket_page = BucketOf(bucket);
+    found = IsChained(bucket_page, key) ? ChainGetValue(bucket_page, key, result)
+                                        : bucket_page->GetValue(key, comparator_, result);
+    bucket->RUnlatch();
+    buffer_pool_manager_->UnpinPage(bucket_page_id, false);
+  }
+  table_latch_.RUnlock();
+  return found;
 }
 
 /*****************************************************************************
@@ -77,12 +184,352 @@ bool HASH_TABLE_TYPE::GetValue(Transaction *transaction, const KeyType &key, std
  *****************************************************************************/
 template <typename KeyType, typename ValueType, typename KeyComparator>
 bool HASH_TABLE_TYPE::Insert(Transaction *transaction, const KeyType &key, const ValueType &value) {
-  return false;
+  StartOperation(transaction);
+  table_latch_.RLock();
+  Page *dir = FetchDirectory(transaction);
+  if (dir == nullptr) {
+    table_latch_.RUnlock();
+    return false;
+  }
+  dir->RLatch();
+  page_id_t bucket_page_id = LookupBucketPageId(key, dir);
+  Page *bucket = bucket_page_id != INVALID_PAGE_ID ? FetchPage(bucket_page_id) : nullptr;
+  if (bucket != nullptr) {
+    bucket->WLatch();
+  }
+  dir->RUnlatch();
+  UnpinDirectory(transaction, false);
+  if (bucket == nullptr) {
+    table_latch_.RUnlock();
+    return false;
+  }
+  HASH_TABLE_BUCKET_TYPE *bucket_page = BucketOf(bucket);
+  bool inserted = false;
+  bool split = false;
+  if (IsChained(bucket_page, key)) {
+    inserted = ChainInsert(bucket, key, value);
+  } else {
+    inserted = bucket_page->Insert(key, value, comparator_);
+    // A full bucket still rejects a duplicate pair without a split.
+    split = !inserted && bucket_page->IsFull() && !bucket_page->Contains(key, value, comparator_);
+  }
+  bucket->WUnlatch();
+  buffer_pool_manager_->UnpinPage(bucket_page_id, inserted);
+  table_latch_.RUnlock();
+  return split ? SplitInsert(transaction, key, value) : inserted;
 }
 
 template <typename KeyType, typename ValueType, typename KeyComparator>
 bool HASH_TABLE_TYPE::SplitInsert(Transaction *transaction, const KeyType &key, const ValueType &value) {
-  return false;
+  table_latch_.RLock();
+  Page *dir = FetchDirectory(transaction);
+  if (dir == nullptr) {
+    table_latch_.RUnlock();
+    return false;
+  }
+  dir->WLatch();
+  auto directory = std::make_unique<HashTableDirectory>(buffer_pool_manager_, DirectoryOf(dir));
+  uint32_t bucket_idx = KeyToDirectoryIndex(key, directory.get());
+  page_id_t bucket_page_id = directory->GetBucketPageId(bucket_idx);
+  uint32_t global_depth = directory->GetGlobalDepth();
+  // A bucket that has all the directory entries it can have needs a larger directory to split.
+  bool at_global_depth = directory->GetLocalDepth(bucket_idx) == global_depth;
+  if (directory->Failed()) {
+    directory.reset();
+    dir->WUnlatch();
+    UnpinDirectory(transaction, false);
+    table_latch_.RUnlock();
+    return false;
+  }
+  Page *bucket = FetchPage(bucket_page_id);
+  bool need_split = false;
+  bool chain = false;
+  bool chain_started = false;
+  if (bucket != nullptr) {
+    bucket->WLatch();
+    HASH_TABLE_BUCKET_TYPE *bucket_page = BucketOf(bucket);
+    // The bucket may have been split or drained since the caller found it full, or have started a chain for the key.
+    need_split = bucket_page->IsFull() && !IsChained(bucket_page, key);
+    // No split tells apart keys of the same hash. If one hash fills half of the bucket, its pairs move to an overflow
+    // chain instead, which frees at least as much room as a split would.
+    uint32_t hash;
+    if (need_split && bucket_page->GetOverflowPageId() == INVALID_PAGE_ID && DominantHash(bucket_page, &hash)) {
+      chain = true;
+      chain_started = StartChain(bucket, hash);
+    }
+  }
+  if (chain) {
+    bucket->WUnlatch();
+    buffer_pool_manager_->UnpinPage(bucket_page_id, chain_started);
+    directory.reset();
+    dir->WUnlatch();
+    UnpinDirectory(transaction, false);
+    table_latch_.RUnlock();
+    return chain_started && Insert(transaction, key, value);
+  }
+  page_id_t image_page_id = INVALID_PAGE_ID;
+  Page *image = need_split && !at_global_depth ? NewBucketPage(&image_page_id) : nullptr;
+  if (image == nullptr) {
+    if (bucket != nullptr) {
+      bucket->WUnlatch();
+      buffer_pool_manager_->UnpinPage(bucket_page_id, false);
+    }
+    directory.reset();
+    dir->WUnlatch();
+    UnpinDirectory(transaction, false);
+    table_latch_.RUnlock();
+    if (bucket == nullptr || (need_split && !at_global_depth)) {
+      // There was no frame for the bucket or its split image.
+      return false;
+    }
+    // Retry if the bucket has room now.
+    return (!need_split || GrowDirectory(transaction, global_depth)) && Insert(transaction, key, value);
+  }
+  image->WLatch();
+
+  // Entries of the bucket whose next hash bit is set now point to the split image. All of them change, or none.
+  uint32_t high_bit = directory->GetLocalHighBit(bucket_idx);
+  uint32_t first_idx = bucket_idx & directory->GetLocalDepthMask(bucket_idx);
+  if (!directory->PinEntries(first_idx, high_bit)) {
+    image->WUnlatch();
+    buffer_pool_manager_->UnpinPage(image_page_id, false);
+    buffer_pool_manager_->DeletePage(image_page_id);
+    bucket->WUnlatch();
+    buffer_pool_manager_->UnpinPage(bucket_page_id, false);
+    directory.reset();
+    dir->WUnlatch();
+    UnpinDirectory(transaction, false);
+    table_latch_.RUnlock();
+    return false;
+  }
+  uint32_t size = directory->Size();
+  for (uint32_t idx = first_idx; idx < size; idx += high_bit) {
+    directory->IncrLocalDepth(idx);
+    if ((idx & high_bit) != 0) {
+      directory->SetBucketPageId(idx, image_page_id);
+    }
+  }
+  // Lookups that reach either bucket wait for their latches, so the directory can be released before entries move.
+  directory.reset();
+  dir->WUnlatch();
+  UnpinDirectory(transaction, true);
+
+  HASH_TABLE_BUCKET_TYPE *bucket_page = BucketOf(bucket);
+  HASH_TABLE_BUCKET_TYPE *image_page = BucketOf(image);
+  for (uint32_t slot = 0; slot < BUCKET_ARRAY_SIZE; slot++) {
+    if (bucket_page->IsReadable(slot) && (Hash(bucket_page->KeyAt(slot)) & high_bit) != 0) {
+      image_page->Insert(bucket_page->KeyAt(slot), bucket_page->ValueAt(slot), comparator_);
+      bucket_page->RemoveAt(slot);
+    }
+  }
+  // The overflow chain holds a single hash, so it moves as a whole.
+  if (bucket_page->GetOverflowPageId() != INVALID_PAGE_ID && (bucket_page->GetOverflowHash() & high_bit) != 0) {
+    image_page->SetOverflow(bucket_page->GetOverflowPageId(), bucket_page->GetOverflowHash());
+    bucket_page->SetOverflow(INVALID_PAGE_ID, 0);
+  }
+  image->WUnlatch();
+  buffer_pool_manager_->UnpinPage(image_page_id, true);
+  bucket->WUnlatch();
+  buffer_pool_manager_->UnpinPage(bucket_page_id, true);
+  table_latch_.RUnlock();
+  // The key's bucket may still be full if all of its keys went to the same side.
+  return Insert(transaction, key, value);
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+bool HASH_TABLE_TYPE::GrowDirectory(Transaction *transaction, uint32_t global_depth) {
+  table_latch_.WLock();
+  Page *dir = FetchDirectory(transaction);
+  bool grown = false;
+  if (dir != nullptr) {
+    // Other threads hold no latches while this one holds table_latch_ exclusively.
+    HashTableDirectory directory(buffer_pool_manager_, DirectoryOf(dir));
+    if (directory.GetGlobalDepth() != global_depth) {
+      grown = true;
+    } else {
+      grown = directory.IncrGlobalDepth();
+    }
+    UnpinDirectory(transaction, grown);
+  }
+  table_latch_.WUnlock();
+  return grown;
+}
+
+/*****************************************************************************
+ * BULK LOAD
+ *****************************************************************************/
+template <typename KeyType, typename ValueType, typename KeyComparator>
+bool HASH_TABLE_TYPE::BulkLoad(Transaction *transaction, const std::vector<MappingType> &entries) {
+  StartOperation(transaction);
+  // (hash, index in entries) of each pair. A partition of the pairs is a range of it, all of whose hashes agree in
+  // their local_depth_ lowest bits. The pairs of its overflow chain, if it has one, are a range of their own.
+  struct Partition {
+    uint32_t prefix_;
+    uint32_t local_depth_;
+    size_t begin_;
+    size_t end_;
+    size_t chain_begin_;
+    size_t chain_end_;
+    uint32_t chain_hash_;
+  };
+  std::vector<std::pair<uint32_t, size_t>> hashes(entries.size());
+  for (size_t i = 0; i < entries.size(); i++) {
+    hashes[i] = {Hash(entries[i].first), i};
+  }
+
+  // Split partitions on their next hash bit until they fit into a bucket. As in SplitInsert, a hash that fills half a
+  // bucket moves to an overflow chain instead: splitting would only peel the other pairs off it, bit by bit. Pairs
+  // that still do not fit at the maximum depth are inserted afterwards.
+  const uint32_t max_depth = HashTableDirectory::MaxGlobalDepth();
+  uint32_t global_depth = 0;
+  std::vector<Partition> partitions;
+  std::vector<Partition> pending{{0, 0, 0, hashes.size(), 0, 0, 0}};
+  std::vector<uint32_t> part_hashes;
+  while (!pending.empty()) {
+    Partition part = pending.back();
+    pending.pop_back();
+    auto begin = hashes.begin() + part.begin_;
+    auto end = hashes.begin() + part.end_;
+    if (part.end_ - part.begin_ <= BUCKET_ARRAY_SIZE) {
+      global_depth = std::max(global_depth, part.local_depth_);
+      partitions.push_back(part);
+      continue;
+    }
+    if (part.chain_begin_ == part.chain_end_) {
+      part_hashes.clear();
+      std::transform(begin, end, std::back_inserter(part_hashes), [](const auto &hash) { return hash.first; });
+      uint32_t hash;
+      if (DominantHash(&part_hashes, &hash)) {
+        auto chained = std::partition(begin, end, [hash](const auto &entry) { return entry.first != hash; });
+        part.chain_begin_ = chained - hashes.begin();
+        part.chain_end_ = part.end_;
+        part.chain_hash_ = hash;
+        part.end_ = part.chain_begin_;
+        pending.push_back(part);
+        continue;
+      }
+    }
+    if (part.local_depth_ == max_depth) {
+      global_depth = std::max(global_depth, part.local_depth_);
+      partitions.push_back(part);
+      continue;
+    }
+    uint32_t bit = 1U << part.local_depth_;
+    auto mid = std::partition(begin, end, [bit](const auto &hash) { return (hash.first & bit) == 0; });
+    size_t mid_idx = mid - hashes.begin();
+    // The chain goes with the half its hash belongs to.
+    Partition low{part.prefix_, part.local_depth_ + 1, part.begin_, mid_idx, 0, 0, 0};
+    Partition high{part.prefix_ | bit, part.local_depth_ + 1, mid_idx, part.end_, 0, 0, 0};
+    Partition &chain_half = (part.chain_hash_ & bit) == 0 ? low : high;
+    chain_half.chain_begin_ = part.chain_begin_;
+    chain_half.chain_end_ = part.chain_end_;
+    chain_half.chain_hash_ = part.chain_hash_;
+    pending.push_back(high);
+    pending.push_back(low);
+  }
+
+  table_latch_.WLock();
+  Page *dir = FetchDirectory(transaction);
+  if (dir == nullptr) {
+    table_latch_.WUnlock();
+    return false;
+  }
+  HashTableDirectoryPage *dir_page = DirectoryOf(dir);
+  page_id_t old_bucket_page_id = dir_page->GetBucketPageId(0);
+  HASH_TABLE_BUCKET_TYPE *old_bucket = dir_page->GetGlobalDepth() == 0 ? FetchBucketPage(old_bucket_page_id) : nullptr;
+  bool empty = old_bucket != nullptr && old_bucket->IsEmpty() && old_bucket->GetOverflowPageId() == INVALID_PAGE_ID;
+  if (old_bucket != nullptr) {
+    buffer_pool_manager_->UnpinPage(old_bucket_page_id, false);
+  }
+
+  // Each bucket and chain page is filled once, and the directory is only touched once all of them exist.
+  std::vector<page_id_t> bucket_page_ids;
+  std::vector<page_id_t> chain_page_ids;
+  std::vector<size_t> excess;
+  bool loaded = empty;
+  for (size_t i = 0; i < partitions.size() && loaded; i++) {
+    const Partition &part = partitions[i];
+    page_id_t bucket_page_id;
+    Page *bucket = NewBucketPage(&bucket_page_id);
+    loaded = bucket != nullptr;
+    if (!loaded) {
+      LOG_DEBUG("no free frame for a hash table bucket");
+      break;
+    }
+    bucket_page_ids.push_back(bucket_page_id);
+    HASH_TABLE_BUCKET_TYPE *bucket_page = BucketOf(bucket);
+    for (size_t j = part.begin_; j < part.end_; j++) {
+      const MappingType &entry = entries[hashes[j].second];
+      // A full bucket leaves the pair for Insert. A bucket with room rejects only a pair it already holds; that repeat
+      // is dropped on purpose, as Insert would reject it too.
+      if (!bucket_page->Insert(entry.first, entry.second, comparator_) && bucket_page->IsFull()) {
+        excess.push_back(hashes[j].second);
+      }
+    }
+    if (part.chain_begin_ != part.chain_end_) {
+      size_t first = chain_page_ids.size();
+      loaded = BuildChain(entries, hashes, part.chain_begin_, part.chain_end_, part.chain_hash_, &chain_page_ids);
+      if (loaded) {
+        bucket_page->SetOverflow(chain_page_ids[first], part.chain_hash_);
+      } else {
+        LOG_DEBUG("no free frame for a hash table overflow page");
+      }
+    }
+    buffer_pool_manager_->UnpinPage(bucket_page_id, true);
+  }
+
+  {
+    HashTableDirectory directory(buffer_pool_manager_, dir_page);
+    while (loaded && directory.GetGlobalDepth() < global_depth) {
+      loaded = directory.IncrGlobalDepth();
+    }
+    // The whole directory is pinned first, so that it is written either completely or not at all.
+    loaded = loaded && directory.PinEntries(0, 1);
+    if (loaded) {
+      // Write the directory in index order, which visits each of its segments once.
+      std::vector<uint32_t> partition_of(directory.Size());
+      for (uint32_t i = 0; i < partitions.size(); i++) {
+        for (uint32_t idx = partitions[i].prefix_; idx < partition_of.size(); idx += 1U << partitions[i].local_depth_) {
+          partition_of[idx] = i;
+        }
+      }
+      for (uint32_t idx = 0; idx < partition_of.size(); idx++) {
+        directory.SetBucketPageId(idx, bucket_page_ids[partition_of[idx]]);
+        directory.SetLocalDepth(idx, partitions[partition_of[idx]].local_depth_);
+      }
+      buffer_pool_manager_->DeletePage(old_bucket_page_id);
+    } else if (empty) {
+      // A directory that grew part of the way still leads every entry to the old bucket.
+      while (directory.GetGlobalDepth() > 0) {
+        if (!directory.DecrGlobalDepth()) {
+          break;
+        }
+      }
+      for (page_id_t bucket_page_id : bucket_page_ids) {
+        buffer_pool_manager_->DeletePage(bucket_page_id);
+      }
+      for (page_id_t chain_page_id : chain_page_ids) {
+        buffer_pool_manager_->DeletePage(chain_page_id);
+      }
+    }
+  }
+  UnpinDirectory(transaction, loaded);
+  table_latch_.WUnlock();
+
+  if (!loaded) {
+    return false;
+  }
+  size_t dropped = 0;
+  for (size_t i : excess) {
+    if (!Insert(transaction, entries[i].first, entries[i].second)) {
+      dropped++;
+    }
+  }
+  if (dropped > 0) {
+    LOG_DEBUG("%zu pairs did not fit into the hash table", dropped);
+    return false;
+  }
+  return true;
 }
 
 /*****************************************************************************
@@ -90,6 +537,242 @@ bool HASH_TABLE_TYPE::SplitInsert(Transaction *transaction, const KeyType &key,
  *****************************************************************************/
 template <typename KeyType, typename ValueType, typename KeyComparator>
 bool HASH_TABLE_TYPE::Remove(Transaction *transaction, const KeyType &key, const ValueType &value) {
+  StartOperation(transaction);
+  table_latch_.RLock();
+  Page *dir = FetchDirectory(transaction);
+  if (dir == nullptr) {
+    table_latch_.RUnlock();
+    return false;
+  }
+  dir->RLatch();
+  page_id_t bucket_page_id = LookupBucketPageId(key, dir);
+  Page *bucket = bucket_page_id != INVALID_PAGE_ID ? FetchPage(bucket_page_id) : nullptr;
+  if (bucket != nullptr) {
+    bucket->WLatch();
+  }
+  dir->RUnlatch();
+  UnpinDirectory(transaction, false);
+  if (bucket == nullptr) {
+    table_latch_.RUnlock();
+    return false;
+  }
+  HASH_TABLE_BUCKET_TYPE *bucket_page = BucketOf(bucket);
+  bool removed = IsChained(bucket_page, key) ? ChainRemove(bucket, key, value)
+                                             : bucket_page->Remove(key, value, comparator_);
+  bool empty = removed && bucket_page->IsEmpty() && bucket_page->GetOverflowPageId() == INVALID_PAGE_ID;
+  bucket->WUnlatch();
+  buffer_pool_manager_->UnpinPage(bucket_page_id, removed);
+  table_latch_.RUnlock();
+  if (empty) {
+    Merge(transaction, key, value);
+  }
+  return removed;
+}
+
+/*****************************************************************************
+ * OVERFLOW CHAINS
+ *****************************************************************************/
+template <typename KeyType, typename ValueType, typename KeyComparator>
+bool HASH_TABLE_TYPE::IsChained(HASH_TABLE_BUCKET_TYPE *bucket_page, const KeyType &key) {
+  return bucket_page->GetOverflowPageId() != INVALID_PAGE_ID && bucket_page->GetOverflowHash() == Hash(key);
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+bool HASH_TABLE_TYPE::DominantHash(HASH_TABLE_BUCKET_TYPE *bucket_page, uint32_t *hash) {
+  std::vector<uint32_t> hashes;
+  for (uint32_t slot = 0; slot < BUCKET_ARRAY_SIZE && bucket_page->IsOccupied(slot); slot++) {
+    if (bucket_page->IsReadable(slot)) {
+      hashes.push_back(Hash(bucket_page->KeyAt(slot)));
+    }
+  }
+  return DominantHash(&hashes, hash);
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+bool HASH_TABLE_TYPE::DominantHash(std::vector<uint32_t> *hashes, uint32_t *hash) {
+  std::sort(hashes->begin(), hashes->end());
+  size_t max_count = 0;
+  for (size_t begin = 0, end = 0; begin < hashes->size(); begin = end) {
+    while (end < hashes->size() && (*hashes)[end] == (*hashes)[begin]) {
+      end++;
+    }
+    if (end - begin > max_count) {
+      max_count = end - begin;
+      *hash = (*hashes)[begin];
+    }
+  }
+  return 2 * max_count >= BUCKET_ARRAY_SIZE;
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+bool HASH_TABLE_TYPE::BuildChain(const std::vector<MappingType> &entries,
+                                 const std::vector<std::pair<uint32_t, size_t>> &hashes, size_t begin, size_t end,
+                                 uint32_t hash, std::vector<page_id_t> *page_ids) {
+  // A page only rejects a pair it holds itself, so repeated pairs are dropped here: the chain holds each pair once.
+  std::unordered_map<ValueType, std::vector<size_t>> loaded_by_value;
+  Page *page = nullptr;
+  page_id_t page_id = INVALID_PAGE_ID;
+  for (size_t j = begin; j < end; j++) {
+    const MappingType &entry = entries[hashes[j].second];
+    auto &same_value = loaded_by_value[entry.second];
+    if (std::any_of(same_value.begin(), same_value.end(),
+                    [&](size_t i) { return comparator_(entries[i].first, entry.first) == 0; })) {
+      continue;
+    }
+    same_value.push_back(hashes[j].second);
+    if (page == nullptr || BucketOf(page)->IsFull()) {
+      page_id_t next_page_id;
+      Page *next = NewBucketPage(&next_page_id);
+      if (next == nullptr) {
+        if (page != nullptr) {
+          buffer_pool_manager_->UnpinPage(page_id, true);
+        }
+        return false;
+      }
+      BucketOf(next)->SetOverflow(INVALID_PAGE_ID, hash);
+      page_ids->push_back(next_page_id);
+      if (page != nullptr) {
+        BucketOf(page)->SetOverflow(next_page_id, hash);
+        buffer_pool_manager_->UnpinPage(page_id, true);
+      }
+      page = next;
+      page_id = next_page_id;
+    }
+    BucketOf(page)->Insert(entry.first, entry.second, comparator_);
+  }
+  if (page != nullptr) {
+    buffer_pool_manager_->UnpinPage(page_id, true);
+  }
+  return true;
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+bool HASH_TABLE_TYPE::StartChain(Page *bucket, uint32_t hash) {
+  // The pairs came from one bucket, so they fit into one overflow page.
+  page_id_t page_id;
+  Page *page = NewBucketPage(&page_id);
+  if (page == nullptr) {
+    return false;
+  }
+  HASH_TABLE_BUCKET_TYPE *bucket_page = BucketOf(bucket);
+  HASH_TABLE_BUCKET_TYPE *overflow_page = BucketOf(page);
+  for (uint32_t slot = 0; slot < BUCKET_ARRAY_SIZE && bucket_page->IsOccupied(slot); slot++) {
+    if (bucket_page->IsReadable(slot) && Hash(bucket_page->KeyAt(slot)) == hash) {
+      overflow_page->Insert(bucket_page->KeyAt(slot), bucket_page->ValueAt(slot), comparator_);
+      bucket_page->RemoveAt(slot);
+    }
+  }
+  overflow_page->SetOverflow(INVALID_PAGE_ID, hash);
+  buffer_pool_manager_->UnpinPage(page_id, true);
+  bucket_page->SetOverflow(page_id, hash);
+  return true;
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+bool HASH_TABLE_TYPE::ChainGetValue(HASH_TABLE_BUCKET_TYPE *bucket_page, const KeyType &key,
+                                    std::vector<ValueType> *result) {
+  bool found = false;
+  page_id_t page_id = bucket_page->GetOverflowPageId();
+  while (page_id != INVALID_PAGE_ID) {
+    Page *page = FetchPage(page_id);
+    if (page == nullptr) {
+      break;
+    }
+    found = BucketOf(page)->GetValue(key, comparator_, result) || found;
+    page_id_t next_page_id = BucketOf(page)->GetOverflowPageId();
+    buffer_pool_manager_->UnpinPage(page_id, false);
+    page_id = next_page_id;
+  }
+  return found;
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+bool HASH_TABLE_TYPE::ChainInsert(Page *bucket, const KeyType &key, const ValueType &value) {
+  // The pair is rejected if it is anywhere in the chain. Otherwise the first page with room takes it.
+  page_id_t room_page_id = INVALID_PAGE_ID;
+  page_id_t last_page_id = INVALID_PAGE_ID;
+  for (page_id_t page_id = BucketOf(bucket)->GetOverflowPageId(); page_id != INVALID_PAGE_ID;) {
+    Page *page = FetchPage(page_id);
+    if (page == nullptr) {
+      return false;
+    }
+    HASH_TABLE_BUCKET_TYPE *overflow_page = BucketOf(page);
+    bool contains = overflow_page->Contains(key, value, comparator_);
+    if (room_page_id == INVALID_PAGE_ID && !overflow_page->IsFull()) {
+      room_page_id = page_id;
+    }
+    last_page_id = page_id;
+    page_id_t next_page_id = overflow_page->GetOverflowPageId();
+    buffer_pool_manager_->UnpinPage(page_id, false);
+    if (contains) {
+      return false;
+    }
+    page_id = next_page_id;
+  }
+  if (room_page_id != INVALID_PAGE_ID) {
+    Page *page = FetchPage(room_page_id);
+    bool inserted = page != nullptr && BucketOf(page)->Insert(key, value, comparator_);
+    if (page != nullptr) {
+      buffer_pool_manager_->UnpinPage(room_page_id, inserted);
+    }
+    return inserted;
+  }
+
+  // Every page is full: append one to the chain.
+  uint32_t hash = Hash(key);
+  page_id_t new_page_id;
+  Page *new_page = NewBucketPage(&new_page_id);
+  if (new_page == nullptr) {
+    return false;
+  }
+  BucketOf(new_page)->Insert(key, value, comparator_);
+  BucketOf(new_page)->SetOverflow(INVALID_PAGE_ID, hash);
+  buffer_pool_manager_->UnpinPage(new_page_id, true);
+  Page *last = FetchPage(last_page_id);
+  if (last == nullptr) {
+    buffer_pool_manager_->DeletePage(new_page_id);
+    return false;
+  }
+  BucketOf(last)->SetOverflow(new_page_id, hash);
+  buffer_pool_manager_->UnpinPage(last_page_id, true);
+  return true;
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+bool HASH_TABLE_TYPE::ChainRemove(Page *bucket, const KeyType &key, const ValueType &value) {
+  // prev is the page that links to the one at page_id; all but the bucket itself are pinned here.
+  Page *prev = bucket;
+  page_id_t page_id = BucketOf(bucket)->GetOverflowPageId();
+  while (page_id != INVALID_PAGE_ID) {
+    Page *page = FetchPage(page_id);
+    if (page == nullptr) {
+      break;
+    }
+    HASH_TABLE_BUCKET_TYPE *overflow_page = BucketOf(page);
+    bool removed = overflow_page->Remove(key, value, comparator_);
+    page_id_t next_page_id = overflow_page->GetOverflowPageId();
+    bool unlink = removed && overflow_page->IsEmpty();
+    if (unlink) {
+      // A chain has no empty pages. Nobody else is on the chain while this thread holds the bucket's latch.
+      BucketOf(prev)->SetOverflow(next_page_id, BucketOf(prev)->GetOverflowHash());
+      buffer_pool_manager_->UnpinPage(page_id, false);
+      buffer_pool_manager_->DeletePage(page_id);
+    }
+    if (prev != bucket) {
+      buffer_pool_manager_->UnpinPage(prev->GetPageId(), unlink);
+    }
+    if (removed) {
+      if (!unlink) {
+        buffer_pool_manager_->UnpinPage(page_id, true);
+      }
+      return true;
+    }
+    prev = page;
+    page_id = next_page_id;
+  }
+  if (prev != bucket) {
+    buffer_pool_manager_->UnpinPage(prev->GetPageId(), false);
+  }
   return false;
 }
 
@@ -97,7 +780,81 @@ bool HASH_TABLE_TYPE::Remove(Transaction *transaction, const KeyType &key, const
  * MERGE
  *****************************************************************************/
 template <typename KeyType, typename ValueType, typename KeyComparator>
-void HASH_TABLE_TYPE::Merge(Transaction *transaction, const KeyType &key, const ValueType &value) {}
+void HASH_TABLE_TYPE::Merge(Transaction *transaction, const KeyType &key, const ValueType &value) {
+  table_latch_.RLock();
+  Page *dir = FetchDirectory(transaction);
+  if (dir == nullptr) {
+    table_latch_.RUnlock();
+    return;
+  }
+  dir->WLatch();
+  auto directory = std::make_unique<HashTableDirectory>(buffer_pool_manager_, DirectoryOf(dir));
+  uint32_t bucket_idx = KeyToDirectoryIndex(key, directory.get());
+  bool merged = false;
+  // A merged bucket that is empty as well merges on with its own split image.
+  while (true) {
+    page_id_t bucket_page_id = directory->GetBucketPageId(bucket_idx);
+    uint32_t local_depth = directory->GetLocalDepth(bucket_idx);
+    uint32_t image_idx = directory->GetSplitImageIndex(bucket_idx);
+    uint32_t image_local_depth = directory->GetLocalDepth(image_idx);
+    if (directory->Failed() || local_depth == 0 || image_local_depth != local_depth) {
+      break;
+    }
+    Page *bucket = FetchPage(bucket_page_id);
+    if (bucket == nullptr) {
+      break;
+    }
+    bucket->WLatch();
+    bool empty = BucketOf(bucket)->IsEmpty() && BucketOf(bucket)->GetOverflowPageId() == INVALID_PAGE_ID;
+    bucket->WUnlatch();
+    buffer_pool_manager_->UnpinPage(bucket_page_id, false);
+    if (!empty) {
+      break;
+    }
+    // The entries of the bucket and its image are those that agree with bucket_idx below the bit that tells them apart.
+    page_id_t image_page_id = directory->GetBucketPageId(image_idx);
+    uint32_t image_bit = 1U << (local_depth - 1);
+    uint32_t first_idx = bucket_idx & (image_bit - 1);
+    // All of the entries change, or none.
+    if (directory->Failed() || !directory->PinEntries(first_idx, image_bit)) {
+      break;
+    }
+    uint32_t size = directory->Size();
+    for (uint32_t idx = first_idx; idx < size; idx += image_bit) {
+      directory->SetBucketPageId(idx, image_page_id);
+      directory->DecrLocalDepth(idx);
+    }
+    // The directory no longer leads to the bucket and nobody holds its latch. A thread that has yet to unpin it keeps
+    // the page from being deleted, which only leaves it unused.
+    buffer_pool_manager_->DeletePage(bucket_page_id);
+    merged = true;
+  }
+  bool can_shrink = merged && directory->CanShrink();
+  directory.reset();
+  dir->WUnlatch();
+  UnpinDirectory(transaction, merged);
+  table_latch_.RUnlock();
+  if (can_shrink) {
+    ShrinkDirectory(transaction);
+  }
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+void HASH_TABLE_TYPE::ShrinkDirectory(Transaction *transaction) {
+  table_latch_.WLock();
+  Page *dir = FetchDirectory(transaction);
+  if (dir != nullptr) {
+    bool shrunk = false;
+    {
+      HashTableDirectory directory(buffer_pool_manager_, DirectoryOf(dir));
+      while (directory.CanShrink() && directory.DecrGlobalDepth()) {
+        shrunk = true;
+      }
+    }
+    UnpinDirectory(transaction, shrunk);
+  }
+  table_latch_.WUnlock();
+}
 
 /*****************************************************************************
  * GETGLOBALDEPTH - DO NOT TOUCH
@@ -118,8 +875,7 @@ uint32_t HASH_TABLE_TYPE::GetGlobalDepth() {
 template <typename KeyType, typename ValueType, typename KeyComparator>
 void HASH_TABLE_TYPE::VerifyIntegrity() {
   table_latch_.RLock();
-  HashTableDirectoryPage *dir_page = FetchDirectoryPage();
-  dir_page->VerifyIntegrity();
+  HashTableDirectory(buffer_pool_manager_, FetchDirectoryPage()).VerifyIntegrity();
   assert(buffer_pool_manager_->UnpinPage(directory_page_id_, false, nullptr));
   table_latch_.RUnlock();
 }
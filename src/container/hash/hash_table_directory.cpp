@@ -0,0 +1,437 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// hash_table_directory.cpp
+//
+// Identification: src/container/hash/hash_table_directory.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "container/hash/hash_table_directory.h"
+
+#include <algorithm>
+#include <cassert>
+#include <unordered_map>
+#include <vector>
+
+#include "common/logger.h"
+
+namespace bustub {
+
+namespace {
+
+HashTableDirectorySegmentPage *SegmentPageOf(Page *page) {
+  return reinterpret_cast<HashTableDirectorySegmentPage *>(page->GetData());
+}
+
+HashTableDirectoryTablePage *TablePageOf(Page *page) {
+  return reinterpret_cast<HashTableDirectoryTablePage *>(page->GetData());
+}
+
+}  // namespace
+
+HashTableDirectory::HashTableDirectory(BufferPoolManager *buffer_pool_manager, HashTableDirectoryPage *dir_page)
+    : buffer_pool_manager_(buffer_pool_manager), dir_page_(dir_page) {}
+
+HashTableDirectory::~HashTableDirectory() { ReleaseSegments(); }
+
+uint32_t HashTableDirectory::MaxGlobalDepth() {
+  uint64_t max_size = static_cast<uint64_t>(DIRECTORY_SEGMENT_SIZE) * DIRECTORY_TABLE_SIZE * DIRECTORY_ROOT_TABLE_SIZE;
+  uint32_t max_depth = 0;
+  while (max_depth < 31 && (uint64_t{2} << max_depth) <= max_size) {
+    max_depth++;
+  }
+  return max_depth;
+}
+
+uint32_t HashTableDirectory::NumSegments(uint32_t size) {
+  return size <= DIRECTORY_ARRAY_SIZE ? 0 : (size + DIRECTORY_SEGMENT_SIZE - 1) / DIRECTORY_SEGMENT_SIZE;
+}
+
+bool HashTableDirectory::PinEntries(uint32_t start, uint32_t step) {
+  if (!IsSegmented()) {
+    return true;
+  }
+  // The segment visited last stays pinned along with the others.
+  if (segment_ != nullptr) {
+    pinned_segments_.emplace(segment_idx_, std::make_pair(segment_, segment_dirty_));
+    segment_ = nullptr;
+    segment_dirty_ = false;
+  }
+  auto pin = [this](uint32_t segment_idx) {
+    if (pinned_segments_.count(segment_idx) == 0) {
+      Page *segment = FetchSegment(segment_idx);
+      if (segment == nullptr) {
+        return false;
+      }
+      pinned_segments_.emplace(segment_idx, std::make_pair(segment, false));
+    }
+    return true;
+  };
+  uint32_t size = Size();
+  if (step < DIRECTORY_SEGMENT_SIZE) {
+    // Entries closer together than a segment have one in every segment from the first on.
+    for (uint32_t segment_idx = start / DIRECTORY_SEGMENT_SIZE; segment_idx < NumSegments(size); segment_idx++) {
+      if (!pin(segment_idx)) {
+        return false;
+      }
+    }
+    return true;
+  }
+  for (uint32_t idx = start; idx < size; idx += step) {
+    if (!pin(idx / DIRECTORY_SEGMENT_SIZE)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+page_id_t HashTableDirectory::GetBucketPageId(uint32_t bucket_idx) {
+  if (!IsSegmented()) {
+    return dir_page_->GetBucketPageId(bucket_idx);
+  }
+  HashTableDirectorySegmentPage *segment = SegmentOf(bucket_idx, false);
+  return segment != nullptr ? segment->GetBucketPageId(bucket_idx % DIRECTORY_SEGMENT_SIZE) : INVALID_PAGE_ID;
+}
+
+void HashTableDirectory::SetBucketPageId(uint32_t bucket_idx, page_id_t bucket_page_id) {
+  if (!IsSegmented()) {
+    dir_page_->SetBucketPageId(bucket_idx, bucket_page_id);
+    return;
+  }
+  HashTableDirectorySegmentPage *segment = SegmentOf(bucket_idx, true);
+  if (segment != nullptr) {
+    segment->SetBucketPageId(bucket_idx % DIRECTORY_SEGMENT_SIZE, bucket_page_id);
+  }
+}
+
+uint32_t HashTableDirectory::GetLocalDepth(uint32_t bucket_idx) {
+  if (!IsSegmented()) {
+    return dir_page_->GetLocalDepth(bucket_idx);
+  }
+  HashTableDirectorySegmentPage *segment = SegmentOf(bucket_idx, false);
+  return segment != nullptr ? segment->GetLocalDepth(bucket_idx % DIRECTORY_SEGMENT_SIZE) : 0;
+}
+
+void HashTableDirectory::SetLocalDepth(uint32_t bucket_idx, uint8_t local_depth) {
+  if (!IsSegmented()) {
+    dir_page_->SetLocalDepth(bucket_idx, local_depth);
+    return;
+  }
+  // CanShrink of a segmented directory reads the count rather than scanning every segment.
+  HashTableDirectorySegmentPage *segment = SegmentOf(bucket_idx, true);
+  if (segment == nullptr) {
+    return;
+  }
+  uint32_t offset = bucket_idx % DIRECTORY_SEGMENT_SIZE;
+  uint32_t global_depth = GetGlobalDepth();
+  uint32_t num_entries = dir_page_->GetNumGlobalDepthEntries();
+  if (segment->GetLocalDepth(offset) == global_depth) {
+    num_entries--;
+  }
+  if (local_depth == global_depth) {
+    num_entries++;
+  }
+  dir_page_->SetNumGlobalDepthEntries(num_entries);
+  segment->SetLocalDepth(offset, local_depth);
+}
+
+uint32_t HashTableDirectory::GetSplitImageIndex(uint32_t bucket_idx) {
+  uint32_t local_depth = GetLocalDepth(bucket_idx);
+  return local_depth == 0 ? bucket_idx : bucket_idx ^ (1U << (local_depth - 1));
+}
+
+bool HashTableDirectory::CanShrink() {
+  if (!IsSegmented()) {
+    return dir_page_->CanShrink();
+  }
+  return dir_page_->GetNumGlobalDepthEntries() == 0;
+}
+
+bool HashTableDirectory::IncrGlobalDepth() {
+  uint32_t global_depth = GetGlobalDepth();
+  if (global_depth == MaxGlobalDepth()) {
+    return false;
+  }
+  uint32_t size = Size();
+  if (size * 2 <= DIRECTORY_ARRAY_SIZE) {
+    dir_page_->IncrGlobalDepth();
+    return true;
+  }
+  ReleaseSegments();
+  if (!AllocateSegments(NumSegments(size), NumSegments(size * 2))) {
+    return false;
+  }
+
+  // Until the global depth changes, everything written below lies beyond the directory, so giving up leaves it as it
+  // was.
+  bool copied = true;
+  if (!IsSegmented()) {
+    // The entries move out of the directory page, into the first segment.
+    Page *page = FetchSegment(0);
+    copied = page != nullptr;
+    if (copied) {
+      HashTableDirectorySegmentPage *segment = SegmentPageOf(page);
+      for (uint32_t idx = 0; idx < size; idx++) {
+        segment->SetBucketPageId(idx, dir_page_->GetBucketPageId(idx));
+        segment->SetLocalDepth(idx, dir_page_->GetLocalDepth(idx));
+      }
+      buffer_pool_manager_->UnpinPage(page->GetPageId(), true);
+    }
+  }
+  if (!copied || !MirrorEntries(size)) {
+    FreeSegments(size, size * 2);
+    return false;
+  }
+
+  dir_page_->SetGlobalDepth(global_depth + 1);
+  // No bucket has a local depth of the new global depth yet.
+  dir_page_->SetNumGlobalDepthEntries(0);
+  return true;
+}
+
+bool HashTableDirectory::MirrorEntries(uint32_t size) {
+  // The new upper half mirrors the lower half, copied a segment at a time; a half smaller than a segment is copied
+  // within the same one.
+  uint32_t chunk = std::min<uint32_t>(size, DIRECTORY_SEGMENT_SIZE);
+  for (uint32_t from = 0; from < size; from += chunk) {
+    uint32_t to = from + size;
+    uint32_t src_idx = from / DIRECTORY_SEGMENT_SIZE;
+    uint32_t dst_idx = to / DIRECTORY_SEGMENT_SIZE;
+    Page *src = FetchSegment(src_idx);
+    if (src == nullptr) {
+      return false;
+    }
+    Page *dst = dst_idx == src_idx ? src : FetchSegment(dst_idx);
+    if (dst == nullptr) {
+      buffer_pool_manager_->UnpinPage(src->GetPageId(), false);
+      return false;
+    }
+    HashTableDirectorySegmentPage *src_segment = SegmentPageOf(src);
+    HashTableDirectorySegmentPage *dst_segment = SegmentPageOf(dst);
+    for (uint32_t i = 0; i < chunk; i++) {
+      uint32_t src_offset = (from + i) % DIRECTORY_SEGMENT_SIZE;
+      uint32_t dst_offset = (to + i) % DIRECTORY_SEGMENT_SIZE;
+      dst_segment->SetBucketPageId(dst_offset, src_segment->GetBucketPageId(src_offset));
+      dst_segment->SetLocalDepth(dst_offset, src_segment->GetLocalDepth(src_offset));
+    }
+    if (dst != src) {
+      buffer_pool_manager_->UnpinPage(dst->GetPageId(), true);
+    }
+    buffer_pool_manager_->UnpinPage(src->GetPageId(), dst == src);
+  }
+  return true;
+}
+
+bool HashTableDirectory::DecrGlobalDepth() {
+  assert(CanShrink());
+  uint32_t global_depth = GetGlobalDepth();
+  uint32_t size = Size();
+  if (size <= DIRECTORY_ARRAY_SIZE) {
+    dir_page_->DecrGlobalDepth();
+    return true;
+  }
+  ReleaseSegments();
+  // Everything that can fail comes first, so that giving up leaves the directory as it was.
+  uint32_t num_entries = 0;
+  if (size / 2 > DIRECTORY_ARRAY_SIZE && !CountEntriesAtDepth(size / 2, global_depth - 1, &num_entries)) {
+    return false;
+  }
+  if (size / 2 <= DIRECTORY_ARRAY_SIZE) {
+    // The entries move back into the directory page.
+    Page *page = FetchSegment(0);
+    if (page == nullptr) {
+      return false;
+    }
+    HashTableDirectorySegmentPage *segment = SegmentPageOf(page);
+    for (uint32_t idx = 0; idx < size / 2; idx++) {
+      dir_page_->SetBucketPageId(idx, segment->GetBucketPageId(idx));
+      dir_page_->SetLocalDepth(idx, segment->GetLocalDepth(idx));
+    }
+    buffer_pool_manager_->UnpinPage(page->GetPageId(), false);
+  }
+  FreeSegments(size / 2, size);
+  dir_page_->SetGlobalDepth(global_depth - 1);
+  if (IsSegmented()) {
+    dir_page_->SetNumGlobalDepthEntries(num_entries);
+  }
+  return true;
+}
+
+void HashTableDirectory::VerifyIntegrity() {
+  if (!IsSegmented()) {
+    dir_page_->VerifyIntegrity();
+    return;
+  }
+  // The invariants of HashTableDirectoryPage::VerifyIntegrity, and the count of entries at the global depth.
+  std::unordered_map<page_id_t, uint32_t> page_id_to_count;
+  std::unordered_map<page_id_t, uint32_t> page_id_to_ld;
+  uint32_t global_depth = GetGlobalDepth();
+  uint32_t num_global_depth_entries = 0;
+  for (uint32_t idx = 0; idx < Size(); idx++) {
+    page_id_t page_id = GetBucketPageId(idx);
+    uint32_t local_depth = GetLocalDepth(idx);
+    if (Failed()) {
+      LOG_WARN("Verify Integrity: no free frame for a directory segment");
+      return;
+    }
+    assert(local_depth <= global_depth);
+    ++page_id_to_count[page_id];
+    if (page_id_to_ld.count(page_id) > 0 && local_depth != page_id_to_ld[page_id]) {
+      LOG_WARN("Verify Integrity: curr_local_depth: %u, old_local_depth %u, for page_id: %u", local_depth,
+               page_id_to_ld[page_id], page_id);
+      assert(local_depth == page_id_to_ld[page_id]);
+    }
+    page_id_to_ld[page_id] = local_depth;
+    if (local_depth == global_depth) {
+      num_global_depth_entries++;
+    }
+  }
+  for (const auto &[page_id, count] : page_id_to_count) {
+    uint32_t required_count = 1U << (global_depth - page_id_to_ld[page_id]);
+    if (count != required_count) {
+      LOG_WARN("Verify Integrity: curr_count: %u, required_count %u, for page_id: %u", count, required_count, page_id);
+      assert(count == required_count);
+    }
+  }
+  assert(num_global_depth_entries == dir_page_->GetNumGlobalDepthEntries());
+}
+
+HashTableDirectorySegmentPage *HashTableDirectory::SegmentOf(uint32_t bucket_idx, bool dirty) {
+  uint32_t segment_idx = bucket_idx / DIRECTORY_SEGMENT_SIZE;
+  auto pinned = pinned_segments_.find(segment_idx);
+  if (pinned != pinned_segments_.end()) {
+    pinned->second.second = pinned->second.second || dirty;
+    return SegmentPageOf(pinned->second.first);
+  }
+  if (segment_ == nullptr || segment_idx_ != segment_idx) {
+    ReleaseSegment();
+    segment_ = FetchSegment(segment_idx);
+    if (segment_ == nullptr) {
+      return nullptr;
+    }
+    segment_idx_ = segment_idx;
+  }
+  segment_dirty_ = segment_dirty_ || dirty;
+  return SegmentPageOf(segment_);
+}
+
+void HashTableDirectory::ReleaseSegment() {
+  if (segment_ != nullptr) {
+    buffer_pool_manager_->UnpinPage(segment_->GetPageId(), segment_dirty_);
+    segment_ = nullptr;
+    segment_dirty_ = false;
+  }
+}
+
+void HashTableDirectory::ReleaseSegments() {
+  ReleaseSegment();
+  for (const auto &[segment_idx, segment] : pinned_segments_) {
+    buffer_pool_manager_->UnpinPage(segment.first->GetPageId(), segment.second);
+  }
+  pinned_segments_.clear();
+}
+
+Page *HashTableDirectory::FetchSegment(uint32_t segment_idx) {
+  Page *table = Fetch(dir_page_->GetSegmentTablePageId(segment_idx / DIRECTORY_TABLE_SIZE));
+  if (table == nullptr) {
+    return nullptr;
+  }
+  page_id_t segment_page_id = TablePageOf(table)->GetSegmentPageId(segment_idx % DIRECTORY_TABLE_SIZE);
+  buffer_pool_manager_->UnpinPage(table->GetPageId(), false);
+  return Fetch(segment_page_id);
+}
+
+Page *HashTableDirectory::Fetch(page_id_t page_id) {
+  Page *page = buffer_pool_manager_->FetchPage(page_id);
+  if (page == nullptr) {
+    LOG_DEBUG("no free frame for hash table directory page %d", page_id);
+    failed_ = true;
+  }
+  return page;
+}
+
+bool HashTableDirectory::AllocateSegments(uint32_t from, uint32_t to) {
+  std::vector<page_id_t> allocated;
+  Page *table = nullptr;
+  bool ok = true;
+  for (uint32_t segment_idx = from; segment_idx < to && ok; segment_idx++) {
+    uint32_t table_idx = segment_idx / DIRECTORY_TABLE_SIZE;
+    if (segment_idx % DIRECTORY_TABLE_SIZE == 0) {
+      // The segment starts a new table.
+      if (table != nullptr) {
+        buffer_pool_manager_->UnpinPage(table->GetPageId(), true);
+      }
+      page_id_t table_page_id;
+      table = buffer_pool_manager_->NewPage(&table_page_id);
+      if (table != nullptr) {
+        allocated.push_back(table_page_id);
+        dir_page_->SetSegmentTablePageId(table_idx, table_page_id);
+      }
+    } else if (table == nullptr) {
+      table = buffer_pool_manager_->FetchPage(dir_page_->GetSegmentTablePageId(table_idx));
+    }
+    page_id_t segment_page_id;
+    ok = table != nullptr && buffer_pool_manager_->NewPage(&segment_page_id) != nullptr;
+    if (ok) {
+      allocated.push_back(segment_page_id);
+      buffer_pool_manager_->UnpinPage(segment_page_id, true);
+      TablePageOf(table)->SetSegmentPageId(segment_idx % DIRECTORY_TABLE_SIZE, segment_page_id);
+    }
+  }
+  if (table != nullptr) {
+    buffer_pool_manager_->UnpinPage(table->GetPageId(), true);
+  }
+  if (!ok) {
+    LOG_DEBUG("no free frame for a hash table directory segment");
+    // Ids the failed attempt wrote lie beyond the directory's segments, where nothing reads them.
+    for (page_id_t page_id : allocated) {
+      buffer_pool_manager_->DeletePage(page_id);
+    }
+  }
+  return ok;
+}
+
+void HashTableDirectory::FreeSegments(uint32_t keep_size, uint32_t size) {
+  uint32_t keep = NumSegments(keep_size);
+  uint32_t num_segments = NumSegments(size);
+  uint32_t keep_tables = (keep + DIRECTORY_TABLE_SIZE - 1) / DIRECTORY_TABLE_SIZE;
+  uint32_t num_tables = (num_segments + DIRECTORY_TABLE_SIZE - 1) / DIRECTORY_TABLE_SIZE;
+  for (uint32_t table_idx = keep / DIRECTORY_TABLE_SIZE; table_idx < num_tables; table_idx++) {
+    page_id_t table_page_id = dir_page_->GetSegmentTablePageId(table_idx);
+    Page *table = Fetch(table_page_id);
+    if (table == nullptr) {
+      // Nothing leads to the segments any more; without a frame to find them, their pages are only left unused.
+      continue;
+    }
+    uint32_t first = std::max(keep, table_idx * DIRECTORY_TABLE_SIZE);
+    uint32_t last = std::min(num_segments, (table_idx + 1) * DIRECTORY_TABLE_SIZE);
+    for (uint32_t segment_idx = first; segment_idx < last; segment_idx++) {
+      buffer_pool_manager_->DeletePage(TablePageOf(table)->GetSegmentPageId(segment_idx % DIRECTORY_TABLE_SIZE));
+    }
+    buffer_pool_manager_->UnpinPage(table_page_id, false);
+    if (table_idx >= keep_tables) {
+      buffer_pool_manager_->DeletePage(table_page_id);
+      dir_page_->SetSegmentTablePageId(table_idx, INVALID_PAGE_ID);
+    }
+  }
+}
+
+bool HashTableDirectory::CountEntriesAtDepth(uint32_t size, uint32_t depth, uint32_t *count) {
+  *count = 0;
+  for (uint32_t idx = 0; idx < size; idx++) {
+    HashTableDirectorySegmentPage *segment = SegmentOf(idx, false);
+    if (segment == nullptr) {
+      return false;
+    }
+    if (segment->GetLocalDepth(idx % DIRECTORY_SEGMENT_SIZE) == depth) {
+      (*count)++;
+    }
+  }
+  return true;
+}
+
+}  // namespace bustub
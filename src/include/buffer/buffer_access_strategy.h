@@ -0,0 +1,110 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// buffer_access_strategy.h
+//
+// Identification: src/include/buffer/buffer_access_strategy.h
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <unordered_map>
+#include <vector>
+
+#include "common/config.h"
+
+namespace bustub {
+
+/** How an operation is going to access the pages it fetches. */
+enum class AccessHint {
+  /** Random access, e.g. point lookups. Pages compete for the whole buffer pool. */
+  NORMAL,
+  /** A large sequential read, e.g. a table scan or an index back-fill. */
+  BULK_READ,
+  /** A large sequential write, e.g. a bulk load. */
+  BULK_WRITE,
+};
+
+/**
+ * BufferAccessStrategy confines the pages that one sequential operation reads into the buffer pool to a small ring of
+ * frames, so that a scan over a large table does not evict the working set of concurrent point queries.
+ *
+ * The strategy remembers the pages it has loaded, separately for every buffer pool instance. Once a ring is full, a
+ * buffer pool miss made through the strategy reuses the frame of the page loaded ring-size misses ago, provided
+ * nobody has it pinned; otherwise the instance picks a victim as usual. A strategy belongs to a single operation and
+ * must not be shared between threads.
+ */
+class BufferAccessStrategy {
+ public:
+  /**
+   * Creates a new BufferAccessStrategy.
+   * @param hint the access pattern of the operation
+   * @param ring_size the number of frames per buffer pool instance the operation may cycle through, 0 = default for
+   * the hint. Buffer pool instances cap it at an eighth of their size.
+   */
+  explicit BufferAccessStrategy(AccessHint hint, size_t ring_size = 0)
+      : hint_(hint), ring_size_(ring_size != 0 ? ring_size : DefaultRingSize(hint)) {}
+
+  /** @return the access pattern of the operation */
+  AccessHint GetHint() const { return hint_; }
+
+  /** @return the requested number of frames per ring */
+  size_t GetRingSize() const { return ring_size_; }
+
+  /**
+   * @param instance_index the buffer pool instance asking
+   * @param capacity the ring size the instance allows
+   * @return the page whose frame should be reused for the next miss, INVALID_PAGE_ID if the ring is not full yet
+   */
+  page_id_t GetReusablePage(uint32_t instance_index, size_t capacity) {
+    auto &ring = rings_[instance_index];
+    if (ring.pages_.size() < capacity) {
+      return INVALID_PAGE_ID;
+    }
+    return ring.pages_[ring.next_ % ring.pages_.size()];
+  }
+
+  /**
+   * Records a page that was loaded through this strategy.
+   * @param instance_index the buffer pool instance that loaded the page
+   * @param capacity the ring size the instance allows
+   * @param page_id the page that was loaded
+   */
+  void AddPage(uint32_t instance_index, size_t capacity, page_id_t page_id) {
+    auto &ring = rings_[instance_index];
+    if (ring.pages_.size() < capacity) {
+      ring.pages_.push_back(page_id);
+      return;
+    }
+    ring.pages_[ring.next_ % ring.pages_.size()] = page_id;
+    ring.next_ = (ring.next_ + 1) % ring.pages_.size();
+  }
+
+ private:
+  struct Ring {
+    std::vector<page_id_t> pages_;
+    /** Slot that is reused next once the ring is full. */
+    size_t next_{0};
+  };
+
+  static size_t DefaultRingSize(AccessHint hint) {
+    switch (hint) {
+      case AccessHint::BULK_READ:
+        return BULK_READ_RING_SIZE;
+      case AccessHint::BULK_WRITE:
+        return BULK_WRITE_RING_SIZE;
+      default:
+        return 0;
+    }
+  }
+
+  AccessHint hint_;
+  size_t ring_size_;
+  std::unordered_map<uint32_t, Ring> rings_;
+};
+
+}  // namespace bustub
@@ -12,11 +12,19 @@
 
 #pragma once
 
+#include <algorithm>
+#include <future>  // NOLINT
 #include <list>
+#include <memory>
 #include <mutex>  // NOLINT
 #include <unordered_map>
+#include <vector>
 
+#include "buffer/buffer_access_strategy.h"
+#include "buffer/buffer_pool_stats.h"
 #include "buffer/lru_replacer.h"
+#include "buffer/pin_cache.h"
+#include "buffer/prefetcher.h"
 #include "recovery/log_manager.h"
 #include "storage/disk/disk_manager.h"
 #include "storage/page/page.h"
@@ -45,6 +53,14 @@ class BufferPoolManager {
     return result;
   }
 
+  /**
+   * Fetch a page on behalf of an operation with a known access pattern.
+   * @param page_id id of page to be fetched
+   * @param strategy the access strategy of the operation, nullptr = normal access
+   * @return the requested page, nullptr if no frame could be found
+   */
+  Page *FetchPage(page_id_t page_id, BufferAccessStrategy *strategy) { return FetchPgImp(page_id, strategy); }
+
   /** Grading function. Do not modify! */
   bool UnpinPage(page_id_t page_id, bool is_dirty, bufferpool_callback_fn callback = nullptr) {
     GradingCallback(callback, CallbackType::BEFORE, page_id);
@@ -69,6 +85,22 @@ class BufferPoolManager {
     return result;
   }
 
+  /**
+   * Create a new page in a tablespace.
+   * @param[out] page_id id of the created page
+   * @param space_id the tablespace to create the page in
+   * @return the new page, nullptr if no frame could be found or the tablespace has no room
+   */
+  Page *NewPage(page_id_t *page_id, tablespace_id_t space_id) { return NewPgImp(page_id, space_id); }
+
+  /**
+   * Drop all pages of a tablespace from the buffer pool without writing them back, e.g. before the tablespace is
+   * dropped.
+   * @param space_id the tablespace
+   * @return false if a page of the tablespace is pinned, in which case no page is dropped from that buffer pool instance
+   */
+  bool DiscardTablespace(tablespace_id_t space_id) { return DiscardTablespacePgsImp(space_id); }
+
   /** Grading function. Do not modify! */
   bool DeletePage(page_id_t page_id, bufferpool_callback_fn callback = nullptr) {
     GradingCallback(callback, CallbackType::BEFORE, page_id);
@@ -84,10 +116,96 @@ class BufferPoolManager {
     GradingCallback(callback, CallbackType::AFTER, INVALID_PAGE_ID);
   }
 
+  /**
+   * Hint that a page will be fetched soon. The page is loaded into the buffer pool, unpinned, by a background thread.
+   * @param page_id id of page to prefetch
+   * @param depth number of pages to read ahead beyond page_id by following next_fn
+   * @param next_fn finds the next page of a page chain, nullptr if depth is 0
+   */
+  void PrefetchPage(page_id_t page_id, size_t depth = 0, prefetch_next_fn next_fn = nullptr) {
+    std::call_once(prefetcher_init_, [this] {
+      prefetcher_ = std::make_unique<Prefetcher>(this, PREFETCH_THREADS, PREFETCH_QUEUE_SIZE, PREFETCH_IO_DEPTH);
+    });
+    prefetcher_->Schedule(page_id, depth, next_fn);
+  }
+
+  /**
+   * Starts reading a page into the buffer pool without pinning it. Until FinishPrefetch is called with the returned
+   * read, the page's frame stays reserved and fetches of the page wait for the read instead of issuing their own.
+   * @param page_id id of page to read
+   * @return the read in flight; not valid if the page is resident or being read already, or no frame could be found
+   */
+  std::future<bool> StartPrefetch(page_id_t page_id) { return StartPrefetchPgImp(page_id); }
+
+  /**
+   * Waits for a read started by StartPrefetch. The page is then left in the buffer pool unpinned; if the read failed,
+   * its frame is freed instead.
+   * @param page_id id of the page that is being read
+   * @param read the read returned by StartPrefetch
+   */
+  void FinishPrefetch(page_id_t page_id, std::future<bool> read) { FinishPrefetchPgImp(page_id, std::move(read)); }
+
+  /**
+   * Hint that a range of consecutive pages will be fetched soon.
+   * @param first_page_id id of the first page to prefetch
+   * @param count number of pages to prefetch
+   */
+  void PrefetchRange(page_id_t first_page_id, size_t count) {
+    for (size_t i = 0; i < count; i++) {
+      PrefetchPage(first_page_id + static_cast<page_id_t>(i));
+    }
+  }
+
+  /**
+   * Registers a pin cache that fetches pages from this buffer pool, so that the buffer pool can ask it to drop its
+   * pins when it needs to delete, discard or retire a pinned page. PinCache registers itself.
+   * @param cache the pin cache
+   */
+  virtual void RegisterPinCache(PinCache *cache) {
+    std::scoped_lock lock(pin_caches_latch_);
+    pin_caches_.push_back(cache);
+  }
+
+  /**
+   * Unregisters a pin cache registered with RegisterPinCache.
+   * @param cache the pin cache
+   */
+  virtual void UnregisterPinCache(PinCache *cache) {
+    std::scoped_lock lock(pin_caches_latch_);
+    pin_caches_.erase(std::remove(pin_caches_.begin(), pin_caches_.end(), cache), pin_caches_.end());
+  }
+
   /** @return size of the buffer pool */
   virtual size_t GetPoolSize() = 0;
 
+  /** @return the statistics of the buffer pool, e.g. for a benchmark harness to dump; empty if it keeps none */
+  virtual BufferPoolStatsSnapshot GetStatsSnapshot() { return {}; }
+
  protected:
+  /**
+   * Stops the prefetch threads. Every subclass must call this first thing in its destructor, since the threads call
+   * back into the subclass.
+   */
+  void ShutDownPrefetcher() { prefetcher_.reset(); }
+
+  /**
+   * Asks the registered pin caches to drop their pins on a page. A cache that is using the page right now drops its
+   * pin when it is done. The caches unpin through the buffer pool, so the caller must not hold an instance latch.
+   * @param page_id the page, INVALID_PAGE_ID = all pages
+   * @return false if no pin cache is registered, i.e. there is no point in trying again
+   */
+  bool ReleaseCachedPins(page_id_t page_id = INVALID_PAGE_ID) {
+    std::scoped_lock lock(pin_caches_latch_);
+    for (auto *cache : pin_caches_) {
+      if (page_id == INVALID_PAGE_ID) {
+        cache->ReleaseAll();
+      } else {
+        cache->Release(page_id);
+      }
+    }
+    return !pin_caches_.empty();
+  }
+
   /**
    * Grading function. Do not modify!
    * Invokes the callback function if it is not null.
@@ -108,6 +226,28 @@ class BufferPoolManager {
    */
   virtual Page *FetchPgImp(page_id_t page_id) = 0;
 
+  /**
+   * Fetch the requested page from the buffer pool, recycling frames of the given access strategy on a miss.
+   * @param page_id id of page to be fetched
+   * @param strategy the access strategy of the caller, nullptr = normal access
+   * @return the requested page
+   */
+  virtual Page *FetchPgImp(page_id_t page_id, BufferAccessStrategy *strategy) = 0;
+
+  /**
+   * Starts reading a page into a reserved frame without pinning it.
+   * @param page_id id of page to read
+   * @return the read in flight, not valid if there is nothing to read or no frame to read into
+   */
+  virtual std::future<bool> StartPrefetchPgImp(page_id_t page_id) = 0;
+
+  /**
+   * Waits for a read started by StartPrefetchPgImp and publishes the page unpinned, or frees its frame.
+   * @param page_id id of the page that is being read
+   * @param read the read in flight
+   */
+  virtual void FinishPrefetchPgImp(page_id_t page_id, std::future<bool> read) = 0;
+
   /**
    * Unpin the target page from the buffer pool.
    * @param page_id id of page to be unpinned
@@ -130,6 +270,21 @@ class BufferPoolManager {
    */
   virtual Page *NewPgImp(page_id_t *page_id) = 0;
 
+  /**
+   * Creates a new page of a tablespace in the buffer pool.
+   * @param[out] page_id id of created page
+   * @param space_id the tablespace to allocate the page in
+   * @return nullptr if no new pages could be created, otherwise pointer to new page
+   */
+  virtual Page *NewPgImp(page_id_t *page_id, tablespace_id_t space_id) = 0;
+
+  /**
+   * Drops the pages of a tablespace from the buffer pool without writing them back.
+   * @param space_id the tablespace
+   * @return false if a page of the tablespace is pinned
+   */
+  virtual bool DiscardTablespacePgsImp(tablespace_id_t space_id) = 0;
+
   /**
    * Deletes a page from the buffer pool.
    * @param page_id id of page to be deleted
@@ -141,5 +296,13 @@ class BufferPoolManager {
    * Flushes all the pages in the buffer pool to disk.
    */
   virtual void FlushAllPgsImp() = 0;
+
+ private:
+  /** Background read-ahead threads, started by the first PrefetchPage. */
+  std::unique_ptr<Prefetcher> prefetcher_;
+  std::once_flag prefetcher_init_;
+  /** Pin caches that hold pins on pages of this buffer pool. */
+  std::vector<PinCache *> pin_caches_;
+  std::mutex pin_caches_latch_;
 };
 }  // namespace bustub
@@ -12,18 +12,40 @@
 
 #pragma once
 
+#include <algorithm>
+#include <condition_variable>  // NOLINT
 #include <list>
-#include <mutex>  // NOLINT
+#include <memory>
+#include <mutex>   // NOLINT
+#include <thread>  // NOLINT
 #include <unordered_map>
+#include <vector>
 
 #include "buffer/buffer_pool_manager.h"
+#include "buffer/frame_arena.h"
 #include "buffer/lru_replacer.h"
+#include "buffer/page_table.h"
 #include "recovery/log_manager.h"
 #include "storage/disk/disk_manager.h"
 #include "storage/page/page.h"
 
 namespace bustub {
 
+/** Occupancy and contention counters of one buffer pool instance, read without latching it. */
+struct BufferPoolInstanceStats {
+  /** Number of frames in use. */
+  size_t pool_size_;
+  /** Number of frames holding a pinned page, including frames beyond the pool size that are still draining. */
+  size_t pinned_frames_;
+  /** Number of times a caller found latch_ taken and had to wait for it. */
+  uint64_t latch_contentions_;
+  /** Number of pages created by NewPage. */
+  uint64_t new_pages_;
+
+  /** @return the number of frames that are free or hold an unpinned page, i.e. could take a new page */
+  size_t AvailableFrames() const { return pool_size_ > pinned_frames_ ? pool_size_ - pinned_frames_ : 0; }
+};
+
 /**
  * BufferPoolManager reads disk pages to and from its internal buffer pool.
  */
@@ -34,8 +56,10 @@ class BufferPoolManagerInstance : public BufferPoolManager {
    * @param pool_size the size of the buffer pool
    * @param disk_manager the disk manager
    * @param log_manager the log manager (for testing only: nullptr = disable logging)
+   * @param replacer the replacement policy sized for pool_size frames, owned by the instance (nullptr = LRUReplacer)
    */
-  BufferPoolManagerInstance(size_t pool_size, DiskManager *disk_manager, LogManager *log_manager = nullptr);
+  BufferPoolManagerInstance(size_t pool_size, DiskManager *disk_manager, LogManager *log_manager = nullptr,
+                            Replacer *replacer = nullptr);
   /**
    * Creates a new BufferPoolManagerInstance.
    * @param pool_size the size of the buffer pool
@@ -43,9 +67,10 @@ class BufferPoolManagerInstance : public BufferPoolManager {
    * @param instance_index index of this BPI in the parallel BPM
    * @param disk_manager the disk manager
    * @param log_manager the log manager (for testing only: nullptr = disable logging)
+   * @param replacer the replacement policy sized for pool_size frames, owned by the instance (nullptr = LRUReplacer)
    */
   BufferPoolManagerInstance(size_t pool_size, uint32_t num_instances, uint32_t instance_index,
-                            DiskManager *disk_manager, LogManager *log_manager = nullptr);
+                            DiskManager *disk_manager, LogManager *log_manager = nullptr, Replacer *replacer = nullptr);
 
   /**
    * Destroys an existing BufferPoolManagerInstance.
@@ -55,8 +80,58 @@ class BufferPoolManagerInstance : public BufferPoolManager {
   /** @return size of the buffer pool */
   size_t GetPoolSize() override { return pool_size_; }
 
-  /** @return pointer to all the pages in the buffer pool */
-  Page *GetPages() { return pages_; }
+  /** @return pointer to the pages of the frames the buffer pool started with */
+  Page *GetPages() { return chunks_[0]->pages_; }
+
+  /**
+   * Changes the number of frames while the buffer pool is in use.
+   *
+   * Growing first reuses frames given up earlier, then appends chunks of frames; a chunk is as large as the initial
+   * pool size rounded up to a power of two, and a pool grows to at most MAX_FRAME_CHUNKS chunks. Shrinking stops
+   * handing out the frames beyond the new size, writes back and evicts their unpinned pages right away, and evicts the
+   * pinned ones as soon as they are unpinned; pin caches are asked to drop their pins on those. The memory of evicted
+   * frames goes back to the operating system.
+   * @param pool_size the new number of frames
+   * @return the number of frames beyond the new size that still hold pinned pages
+   */
+  size_t Resize(size_t pool_size);
+
+  /** @return a snapshot of the occupancy and contention counters, taken without latching the instance */
+  BufferPoolInstanceStats GetStats() const {
+    return {pool_size_.load(std::memory_order_relaxed), pinned_frames_.load(std::memory_order_relaxed),
+            stats_.latch_contentions_.Sum(), stats_.new_pages_.Sum()};
+  }
+
+  /** @return the hit, eviction and write-back counters and latency histograms of the instance */
+  BufferPoolStatsSnapshot GetStatsSnapshot() override;
+
+  /**
+   * Starts a background thread that writes back the dirty pages the replacer would evict next, every
+   * bg_writer_delay, so that foreground fetches rarely have to write a dirty victim themselves.
+   * @param max_pages_per_round the maximum number of pages to write back per round
+   */
+  void StartBackgroundWriter(size_t max_pages_per_round = BG_WRITER_MAX_PAGES);
+
+  /** Stops the background writer, if it is running. */
+  void StopBackgroundWriter();
+
+  /**
+   * Writes back the dirty, unpinned pages among the next victims of the replacer. With logging enabled, a page is
+   * only written once the log is persistent up to the page LSN. This is one round of the background writer.
+   * @param max_pages the number of upcoming victims to look at
+   * @return the number of pages written back
+   */
+  size_t CleanVictimPages(size_t max_pages);
+
+  /**
+   * Flushes the dirty pages of several instances that share a disk manager as one batch: sorted by page id, with
+   * adjacent pages coalesced into vectored writes and a single sync at the end. Each instance is latched only while
+   * its dirty frames are collected and pinned, which keeps them from being evicted. The write and the sync run with no
+   * instance latched. A page that was modified while it was written stays dirty, and so does one that was not written
+   * and synced.
+   * @param instances the instances to flush
+   */
+  static void FlushAllPgsBatched(const std::vector<BufferPoolManagerInstance *> &instances);
 
  protected:
   /**
@@ -66,6 +141,28 @@ class BufferPoolManagerInstance : public BufferPoolManager {
    */
   Page *FetchPgImp(page_id_t page_id) override;
 
+  /**
+   * Fetch the requested page from the buffer pool, recycling frames of the given access strategy on a miss.
+   * @param page_id id of page to be fetched
+   * @param strategy the access strategy of the caller, nullptr = normal access
+   * @return the requested page
+   */
+  Page *FetchPgImp(page_id_t page_id, BufferAccessStrategy *strategy) override;
+
+  /**
+   * Starts reading a page into a reserved frame without pinning it.
+   * @param page_id id of page to read
+   * @return the read in flight, not valid if there is nothing to read or no frame to read into
+   */
+  std::future<bool> StartPrefetchPgImp(page_id_t page_id) override;
+
+  /**
+   * Waits for a read started by StartPrefetchPgImp and publishes the page unpinned, or frees its frame.
+   * @param page_id id of the page that is being read
+   * @param read the read in flight
+   */
+  void FinishPrefetchPgImp(page_id_t page_id, std::future<bool> read) override;
+
   /**
    * Unpin the target page from the buffer pool.
    * @param page_id id of page to be unpinned
@@ -88,6 +185,21 @@ class BufferPoolManagerInstance : public BufferPoolManager {
    */
   Page *NewPgImp(page_id_t *page_id) override;
 
+  /**
+   * Creates a new page of a tablespace in the buffer pool.
+   * @param[out] page_id id of created page
+   * @param space_id the tablespace to allocate the page in
+   * @return nullptr if no new pages could be created, otherwise pointer to new page
+   */
+  Page *NewPgImp(page_id_t *page_id, tablespace_id_t space_id) override;
+
+  /**
+   * Drops the pages of a tablespace from the buffer pool without writing them back.
+   * @param space_id the tablespace
+   * @return false if a page of the tablespace is pinned
+   */
+  bool DiscardTablespacePgsImp(tablespace_id_t space_id) override;
+
   /**
    * Deletes a page from the buffer pool.
    * @param page_id id of page to be deleted
@@ -101,18 +213,17 @@ class BufferPoolManagerInstance : public BufferPoolManager {
   void FlushAllPgsImp() override;
 
   /**
-   * Allocate a page on disk.∂
-   * @return the id of the allocated page
+   * Allocate a page on disk, reusing a deallocated page of this BPI if there is one.
+   * @param space_id the tablespace to allocate the page in
+   * @return the id of the allocated page, INVALID_PAGE_ID if the tablespace does not exist or is full
    */
-  page_id_t AllocatePage();
+  page_id_t AllocatePage(tablespace_id_t space_id = DEFAULT_TABLESPACE_ID);
 
   /**
-   * Deallocate a page on disk.
+   * Deallocate a page on disk, so that the disk manager can hand its id out again.
    * @param page_id id of the page to deallocate
    */
-  void DeallocatePage(__attribute__((unused)) page_id_t page_id) {
-    // This is a no-nop right now without a more complex data structure to track deallocated pages
-  }
+  void DeallocatePage(page_id_t page_id);
 
   /**
    * Validate that the page_id being used is accessible to this BPI. This can be used in all of the functions to
@@ -121,28 +232,169 @@ class BufferPoolManagerInstance : public BufferPoolManager {
    */
   void ValidatePageId(page_id_t page_id) const;
 
-  /** Number of pages in the buffer pool. */
-  const size_t pool_size_;
+  /**
+   * Pins the page in a frame without taking latch_.
+   * @param frame_id the frame
+   * @param reference true to record the first pin as a reference with the replacer, false for internal pins that
+   * keep the page in its frame while it is written
+   * @return the pin count before the pin, NOT_PINNABLE if the frame holds no page and was not pinned
+   */
+  int TryPin(frame_id_t frame_id, bool reference);
+
+  /** Drops a pin taken by TryPin. Caller must not hold latch_. */
+  void ReleasePin(frame_id_t frame_id);
+
+  /**
+   * Takes a frame whose page is not pinned away from lock-free pins, by setting its pin count to NOT_PINNABLE. Caller
+   * must hold latch_.
+   * @return false if the page is pinned
+   */
+  bool ClaimFrame(frame_id_t frame_id);
+
+  /**
+   * Asks the replacer for a victim and claims it, skipping victims that were pinned since they were unpinned. Caller
+   * must hold latch_.
+   * @param[out] frame_id the claimed frame
+   * @return false if the replacer lists no unpinned frame
+   */
+  bool ClaimVictim(frame_id_t *frame_id);
+
+  /**
+   * Picks a frame for a new page: the next frame of the access strategy's ring if it can be recycled, otherwise from
+   * the free list first and then from the replacer. A dirty victim is written back and its page table entry is
+   * removed. Caller must hold latch_.
+   * @param[out] frame_id the frame that can be reused
+   * @param strategy the access strategy of the caller, nullptr = normal access
+   * @return false if every frame is pinned
+   */
+  bool GetVictimFrame(frame_id_t *frame_id, BufferAccessStrategy *strategy = nullptr);
+
+  /** @return the number of frames one access strategy may cycle through in this instance */
+  size_t RingCapacity(const BufferAccessStrategy *strategy) const {
+    return std::min(strategy->GetRingSize(), std::max<size_t>(pool_size_ / 8, 1));
+  }
+
+  /**
+   * Reserves a frame for a page that is about to be read: the frame is entered into the page table, but stays
+   * NOT_PINNABLE until FinishLoad, so that fetches of the page wait for the read on io_cv_ instead of reading the page
+   * again. The read itself runs without latch_. Caller must hold latch_.
+   * @param page_id the page to be read
+   * @param strategy the access strategy of the caller, nullptr = normal access
+   * @param[out] frame_id the reserved frame
+   * @return false if every frame is pinned
+   */
+  bool ReserveFrame(page_id_t page_id, BufferAccessStrategy *strategy, frame_id_t *frame_id);
+
+  /**
+   * Publishes a frame reserved by ReserveFrame once its read is done, or frees it if the read failed, and wakes up the
+   * fetches that wait for it. Caller must hold latch_.
+   * @param frame_id the reserved frame
+   * @param read_ok the result of the read
+   * @param pin_count 1 to publish the page pinned for the caller, 0 to publish it unpinned
+   * @return false if the read failed
+   */
+  bool FinishLoad(frame_id_t frame_id, bool read_ok, int pin_count);
+
+  /**
+   * Drops the page in a claimed frame without writing it back and puts the frame on the free list. Caller must hold
+   * latch_.
+   */
+  void DropFrame(frame_id_t frame_id);
+
+  /**
+   * Writes back a claimed victim frame if it is dirty and drops it from the page table. Caller must hold latch_.
+   */
+  void EvictFrame(frame_id_t frame_id);
+
+  /** @return latch_, locked; counts the acquisition as contended if latch_ was taken */
+  std::unique_lock<std::mutex> LockLatch();
+
+  /** Called when a frame that was just loaded gets its first pin. Caller must hold latch_. */
+  void OnPinned(frame_id_t frame_id);
+
+  /**
+   * Called when the pin count of a frame drops to 0. Takes latch_ if the frame is beyond the pool size, so caller must
+   * not hold it.
+   */
+  void OnUnpinned(frame_id_t frame_id);
+
+  /**
+   * Evicts the page of a claimed frame beyond the pool size and gives the frame's memory back. Caller must hold latch_.
+   */
+  void RetireFrame(frame_id_t frame_id);
+
+  /** @return the page handle of a frame */
+  inline Page *FramePage(frame_id_t frame_id) const {
+    return &chunks_[frame_id >> chunk_shift_]->pages_[frame_id & chunk_mask_];
+  }
+
+  /** Maximum number of frame chunks of an instance. */
+  static constexpr size_t MAX_FRAME_CHUNKS = 64;
+
+  /**
+   * Pin count of a frame that holds no page, or whose page is being read, evicted or dropped. Lock-free pins fail on
+   * it. A frame's pin count only becomes or stops being NOT_PINNABLE under latch_.
+   */
+  static constexpr int NOT_PINNABLE = -1;
+
+  /** A chunk of frames: their data, their descriptors and their page handles. Chunks are only ever added. */
+  struct FrameChunk {
+    FrameChunk(size_t num_frames, bool huge_pages);
+    ~FrameChunk();
+    DISALLOW_COPY_AND_MOVE(FrameChunk);
+
+    const size_t num_frames_;
+    /** Data of the frames, page aligned and (where possible) backed by huge pages. */
+    FrameArena arena_;
+    /** Page id, pin count and dirty flag of every frame, as a struct of arrays. */
+    FrameDescriptorTable descriptors_;
+    /** Page handles of the frames in arena_ and descriptors_. */
+    Page *pages_;
+  };
+
+  /** Number of frames in use. Frames beyond it only hold pages that were pinned when the pool shrank. */
+  std::atomic<size_t> pool_size_;
   /** How many instances are in the parallel BPM (if present, otherwise just 1 BPI) */
   const uint32_t num_instances_ = 1;
   /** Index of this BPI in the parallel BPM (if present, otherwise just 0) */
   const uint32_t instance_index_ = 0;
-  /** Each BPI maintains its own counter for page_ids to hand out, must ensure they mod back to its instance_index_ */
-  std::atomic<page_id_t> next_page_id_ = instance_index_;
 
-  /** Array of buffer pool pages. */
-  Page *pages_;
+  /** log2 of the number of frames per chunk. */
+  const uint32_t chunk_shift_;
+  const frame_id_t chunk_mask_;
+  /** The frame chunks; frame f lives in chunk f >> chunk_shift_. Lock-free readers only reach published chunks. */
+  std::unique_ptr<std::unique_ptr<FrameChunk>[]> chunks_;
+  /** Number of chunks allocated. Protected by latch_. */
+  size_t num_chunks_{0};
   /** Pointer to the disk manager. */
-  DiskManager *disk_manager_ __attribute__((__unused__));
+  DiskManager *disk_manager_;
   /** Pointer to the log manager. */
-  LogManager *log_manager_ __attribute__((__unused__));
-  /** Page table for keeping track of buffer pool pages. */
-  std::unordered_map<page_id_t, frame_id_t> page_table_;
+  LogManager *log_manager_;
+  /** Page table for keeping track of buffer pool pages. Readable without latch_, written only under latch_. */
+  PageTable page_table_;
   /** Replacer to find unpinned pages for replacement. */
   Replacer *replacer_;
   /** List of free pages. */
   std::list<frame_id_t> free_list_;
-  /** This latch protects shared data structures. We recommend updating this comment to describe what it protects. */
+  /**
+   * This latch protects the free list, page table updates, frame (re)assignment and resizing. Fetching and unpinning a
+   * resident page does not take it. The replacer has a latch of its own, which the first pin and the last unpin of a
+   * page take.
+   */
   std::mutex latch_;
+  /** Signalled under latch_ whenever a page read finishes, see ReserveFrame. */
+  std::condition_variable io_cv_;
+
+  /** Number of frames with a pin count above 0. Readable without latch_. */
+  std::atomic<size_t> pinned_frames_{0};
+  /** Counters and latency histograms, see GetStatsSnapshot. */
+  BufferPoolStats stats_;
+
+  /** Background writer thread, see StartBackgroundWriter. */
+  std::thread bg_writer_;
+  /** Set to stop the background writer. Protected by bg_writer_latch_. */
+  bool bg_writer_stop_{false};
+  std::mutex bg_writer_latch_;
+  std::condition_variable bg_writer_cv_;
 };
 }  // namespace bustub
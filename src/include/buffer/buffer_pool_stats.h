@@ -0,0 +1,167 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// buffer_pool_stats.h
+//
+// Identification: src/include/buffer/buffer_pool_stats.h
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>  // NOLINT
+#include <cstdint>
+#include <string>
+
+namespace bustub {
+
+/** A counter split over cache-line sized shards, so that threads bumping it at the same time rarely share a line. */
+class ShardedCounter {
+ public:
+  static constexpr size_t NUM_SHARDS = 16;
+
+  void Add(uint64_t n = 1) { shards_[ShardIndex()].value_.fetch_add(n, std::memory_order_relaxed); }
+
+  /** @return the sum over all shards; concurrent updates may or may not be included */
+  uint64_t Sum() const {
+    uint64_t sum = 0;
+    for (const auto &shard : shards_) {
+      sum += shard.value_.load(std::memory_order_relaxed);
+    }
+    return sum;
+  }
+
+ private:
+  struct alignas(64) Shard {
+    std::atomic<uint64_t> value_{0};
+  };
+
+  /** @return the shard of the calling thread; threads are spread over the shards round robin */
+  static size_t ShardIndex();
+
+  std::array<Shard, NUM_SHARDS> shards_;
+};
+
+/** A copy of a LatencyHistogram at one point in time. */
+struct HistogramSnapshot {
+  static constexpr size_t NUM_BUCKETS = 40;
+
+  /** buckets_[i] counts the latencies in [2^i, 2^(i+1)) nanoseconds; bucket 0 also counts 0. */
+  std::array<uint64_t, NUM_BUCKETS> buckets_{};
+  uint64_t count_{0};
+  uint64_t sum_ns_{0};
+
+  void Merge(const HistogramSnapshot &other);
+
+  /** @return the mean latency in nanoseconds, 0 if nothing was recorded */
+  uint64_t MeanNs() const { return count_ == 0 ? 0 : sum_ns_ / count_; }
+
+  /**
+   * @param percentile the percentile, in (0, 100]
+   * @return an upper bound of the latency at the percentile in nanoseconds, 0 if nothing was recorded
+   */
+  uint64_t PercentileNs(double percentile) const;
+};
+
+/** A latency histogram with power-of-two buckets, updated without locks. */
+class LatencyHistogram {
+ public:
+  void Record(std::chrono::nanoseconds latency);
+
+  HistogramSnapshot Snapshot() const;
+
+ private:
+  std::array<std::atomic<uint64_t>, HistogramSnapshot::NUM_BUCKETS> buckets_{};
+  std::atomic<uint64_t> sum_ns_{0};
+};
+
+/** Records the time from its construction to its destruction into a histogram. */
+class ScopedLatencyTimer {
+ public:
+  explicit ScopedLatencyTimer(LatencyHistogram *histogram)
+      : histogram_(histogram), start_(std::chrono::steady_clock::now()) {}
+  ~ScopedLatencyTimer() { histogram_->Record(std::chrono::steady_clock::now() - start_); }
+
+ private:
+  LatencyHistogram *histogram_;
+  std::chrono::steady_clock::time_point start_;
+};
+
+/** The statistics of one or more buffer pool instances at one point in time. */
+struct BufferPoolStatsSnapshot {
+  /** Number of frames in use. */
+  size_t pool_size_{0};
+  /** Number of frames holding a pinned page. */
+  size_t pinned_frames_{0};
+
+  /** Fetches of resident pages. */
+  uint64_t fetch_hits_{0};
+  /** Fetches that had to read the page from disk. */
+  uint64_t fetch_misses_{0};
+  /** Fetches and new pages that failed because every frame was pinned. */
+  uint64_t no_frame_failures_{0};
+  /** Pages created. */
+  uint64_t new_pages_{0};
+  /** Pages evicted, to make room for another page or because the pool shrank. */
+  uint64_t evictions_{0};
+  /** Evicted pages that were dirty and written back by the evicting thread. */
+  uint64_t dirty_evictions_{0};
+  /** Pages written back by the background writer. */
+  uint64_t background_writes_{0};
+  /** Pages written by FlushPage and FlushAllPages. */
+  uint64_t flushed_pages_{0};
+  /** Acquisitions of an instance latch that had to wait. */
+  uint64_t latch_contentions_{0};
+
+  /** Time of fetches that read the page from disk, including the victim search. */
+  HistogramSnapshot fetch_miss_latency_;
+  /** Time to find a frame for a page, including writing back a dirty victim. */
+  HistogramSnapshot victim_search_latency_;
+  /** Time to write back a dirty victim. */
+  HistogramSnapshot write_back_latency_;
+  /** Time spent waiting for a contended instance latch. */
+  HistogramSnapshot latch_wait_latency_;
+
+  /** Adds the statistics of another set of instances. */
+  void Merge(const BufferPoolStatsSnapshot &other);
+
+  /** @return the fraction of fetches that found the page resident, 0 if there were none */
+  double HitRatio() const {
+    uint64_t fetches = fetch_hits_ + fetch_misses_;
+    return fetches == 0 ? 0 : static_cast<double>(fetch_hits_) / static_cast<double>(fetches);
+  }
+
+  /** @return a human readable multi-line summary */
+  std::string ToString() const;
+
+  /** @return the statistics as a JSON object, including the non-empty histogram buckets */
+  std::string ToJson() const;
+};
+
+/** The live statistics of a buffer pool instance. Updates are lock-free; Snapshot reads them without stopping them. */
+struct BufferPoolStats {
+  ShardedCounter fetch_hits_;
+  ShardedCounter fetch_misses_;
+  ShardedCounter no_frame_failures_;
+  ShardedCounter new_pages_;
+  ShardedCounter evictions_;
+  ShardedCounter dirty_evictions_;
+  ShardedCounter background_writes_;
+  ShardedCounter flushed_pages_;
+  ShardedCounter latch_contentions_;
+
+  LatencyHistogram fetch_miss_latency_;
+  LatencyHistogram victim_search_latency_;
+  LatencyHistogram write_back_latency_;
+  LatencyHistogram latch_wait_latency_;
+
+  /** @return the counters and histograms; the caller fills in the gauges */
+  BufferPoolStatsSnapshot Snapshot() const;
+};
+
+}  // namespace bustub
@@ -43,10 +43,22 @@ class ClockReplacer : public Replacer {
 
   void Unpin(frame_id_t frame_id) override;
 
+  std::vector<frame_id_t> PeekVictims(size_t max_frames) override;
+
+  void Grow(size_t num_pages) override;
+
   size_t Size() override;
 
  private:
-  // TODO(student): implement me!
+  /** Whether each frame is currently unpinned, i.e. tracked by the clock. */
+  std::vector<bool> in_clock_;
+  /** Reference bit of each frame. */
+  std::vector<bool> ref_;
+  /** Current position of the clock hand. */
+  size_t hand_{0};
+  /** Number of frames currently tracked by the clock. */
+  size_t size_{0};
+  std::mutex latch_;
 };
 
 }  // namespace bustub
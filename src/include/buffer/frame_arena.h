@@ -0,0 +1,65 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// frame_arena.h
+//
+// Identification: src/include/buffer/frame_arena.h
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include "common/config.h"
+#include "common/macros.h"
+
+namespace bustub {
+
+/**
+ * FrameArena is one contiguous, zeroed memory mapping that holds the data of all frames of a buffer pool. Every frame
+ * starts on a PAGE_SIZE boundary, so frames can be used for O_DIRECT I/O.
+ *
+ * With huge pages, the arena is backed by 2 MB pages to cut TLB misses on large pools: explicit huge pages if the
+ * system has some reserved, otherwise a 2 MB aligned mapping that transparent huge pages may back (MADV_HUGEPAGE).
+ * Arenas smaller than a huge page use normal pages either way, rather than round up to a whole huge page.
+ */
+class FrameArena {
+ public:
+  /** Size of a huge page. */
+  static constexpr size_t HUGE_PAGE_SIZE = 2 * 1024 * 1024;
+
+  /**
+   * Creates a new FrameArena.
+   * @param num_frames the number of frames
+   * @param huge_pages true to back the arena with huge pages where possible
+   */
+  FrameArena(size_t num_frames, bool huge_pages);
+
+  ~FrameArena();
+
+  DISALLOW_COPY_AND_MOVE(FrameArena);
+
+  /** @return the PAGE_SIZE bytes of data of the given frame */
+  inline char *GetFrame(frame_id_t frame_id) const { return base_ + static_cast<size_t>(frame_id) * PAGE_SIZE; }
+
+  /**
+   * Gives the memory of a frame back to the operating system. The frame stays usable; its content is undefined.
+   * @param frame_id the frame to release
+   */
+  void Release(frame_id_t frame_id);
+
+  /** @return true if the arena is backed by explicit huge pages */
+  bool HasExplicitHugePages() const { return explicit_huge_pages_; }
+
+ private:
+  /** Start of the frames. */
+  char *base_;
+  /** Start and length of the mapping, which may extend beyond the frames for alignment. */
+  void *mapping_;
+  size_t mapping_size_;
+  bool explicit_huge_pages_{false};
+};
+
+}  // namespace bustub
@@ -0,0 +1,99 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// lru_k_replacer.h
+//
+// Identification: src/include/buffer/lru_k_replacer.h
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <deque>
+#include <mutex>  // NOLINT
+#include <set>
+#include <tuple>
+#include <vector>
+
+#include "buffer/replacer.h"
+#include "common/config.h"
+
+namespace bustub {
+
+/**
+ * LRUKReplacer implements the LRU-K replacement policy.
+ *
+ * The victim is the unpinned frame with the largest backward k-distance, i.e. the one whose k-th most recent
+ * reference is the oldest. Frames with fewer than k references have an infinite backward k-distance; among those the
+ * one with the oldest first reference is evicted first. Pages touched once by a sequential scan therefore leave the
+ * pool before pages that are referenced repeatedly.
+ *
+ * A reference is recorded whenever a frame is pinned. References to a frame that come within
+ * correlated_reference_period references of its previous one are correlated: they count as one, so a burst of
+ * correlated references does not look like a hot page. A table scan, for example, pins each page once per tuple.
+ * Frames referenced within the period are not evicted unless there is no other choice either.
+ */
+class LRUKReplacer : public Replacer {
+ public:
+  /**
+   * Create a new LRUKReplacer.
+   * @param num_pages the maximum number of pages the LRUKReplacer will be required to store
+   * @param k the number of references to remember per frame
+   * @param correlated_reference_period number of references after a reference to a frame during which further
+   * references to it are correlated, 0 = none are
+   */
+  explicit LRUKReplacer(size_t num_pages, size_t k = 2, size_t correlated_reference_period = LRUK_CORRELATED_PERIOD);
+
+  /**
+   * Destroys the LRUKReplacer.
+   */
+  ~LRUKReplacer() override;
+
+  bool Victim(frame_id_t *frame_id) override;
+
+  void Pin(frame_id_t frame_id) override;
+
+  void Unpin(frame_id_t frame_id) override;
+
+  void Remove(frame_id_t frame_id) override;
+
+  std::vector<frame_id_t> PeekVictims(size_t max_frames) override;
+
+  void Grow(size_t num_pages) override;
+
+  size_t Size() override;
+
+ private:
+  /** (has k references, oldest remembered reference, frame id): the smallest key is the next victim. */
+  using EvictionKey = std::tuple<bool, uint64_t, frame_id_t>;
+
+  struct FrameEntry {
+    /** Timestamps of the first references of the last k bursts of correlated references, oldest first. */
+    std::deque<uint64_t> history_;
+    /** Timestamp of the most recent reference, correlated or not. */
+    uint64_t last_{0};
+    /** True if the frame is unpinned and part of evictable_. */
+    bool evictable_{false};
+  };
+
+  EvictionKey KeyOf(frame_id_t frame_id) const;
+
+  /** @return true if the frame was referenced within the correlated reference period. Caller must hold latch_. */
+  bool InCorrelatedPeriod(const FrameEntry &frame) const {
+    return !frame.history_.empty() && current_timestamp_ - frame.last_ < correlated_reference_period_;
+  }
+
+  const size_t k_;
+  const size_t correlated_reference_period_;
+  /** Logical clock, advanced on every reference. */
+  uint64_t current_timestamp_{0};
+  std::vector<FrameEntry> frames_;
+  /** Unpinned frames ordered by eviction priority. */
+  std::set<EvictionKey> evictable_;
+  std::mutex latch_;
+};
+
+}  // namespace bustub
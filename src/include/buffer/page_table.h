@@ -0,0 +1,119 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// page_table.h
+//
+// Identification: src/include/buffer/page_table.h
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <vector>
+
+#include "common/config.h"
+#include "common/macros.h"
+
+namespace bustub {
+
+/**
+ * PageTable maps resident page ids to buffer pool frames.
+ *
+ * It is a fixed-capacity open-addressing (linear probing) hash table whose slots are single 64-bit atomics packing
+ * (page_id, frame_id). Lookups never block and may run concurrently with a single writer; Insert and Remove must be
+ * serialized externally (the buffer pool instance latch). A concurrent lookup may miss an entry that is being moved
+ * by a Compact() or a Reserve(), and it may return a stale mapping, so callers must validate the returned frame and
+ * fall back to a latched lookup on a miss.
+ */
+class PageTable {
+ public:
+  /**
+   * Creates a new PageTable.
+   * @param max_entries the maximum number of live entries (the buffer pool size)
+   */
+  explicit PageTable(size_t max_entries);
+
+  ~PageTable() = default;
+
+  DISALLOW_COPY_AND_MOVE(PageTable);
+
+  /**
+   * Lock-free lookup.
+   * @param page_id the page id to look up
+   * @param[out] frame_id the frame holding the page, if found
+   * @return true if a mapping was found
+   */
+  bool Find(page_id_t page_id, frame_id_t *frame_id) const;
+
+  /**
+   * Adds a mapping. The page must not already be present. Caller must hold the writer latch.
+   * @param page_id the page id
+   * @param frame_id the frame now holding the page
+   */
+  void Insert(page_id_t page_id, frame_id_t frame_id);
+
+  /**
+   * Removes a mapping. Caller must hold the writer latch.
+   * @param page_id the page id to remove
+   * @return true if the page was present
+   */
+  bool Remove(page_id_t page_id);
+
+  /**
+   * Makes room for more live entries. Lookups that started before the call keep probing the old slots, which stay
+   * allocated until the table is destroyed. Caller must hold the writer latch.
+   * @param max_entries the new maximum number of live entries
+   */
+  void Reserve(size_t max_entries);
+
+  /** @return the number of live entries */
+  size_t Size() const { return size_; }
+
+ private:
+  /** The slots, together with the numbers needed to probe them. */
+  struct Slots {
+    explicit Slots(size_t max_entries);
+    /** Number of slots, always a power of two. */
+    size_t capacity_;
+    /** 64 - log2(capacity_), used by HomeSlot. */
+    uint32_t shift_;
+    std::unique_ptr<std::atomic<uint64_t>[]> slots_;
+  };
+
+  static constexpr uint64_t EMPTY = ~static_cast<uint64_t>(0);
+  static constexpr uint64_t TOMBSTONE = EMPTY - 1;
+
+  static inline uint64_t Pack(page_id_t page_id, frame_id_t frame_id) {
+    return (static_cast<uint64_t>(static_cast<uint32_t>(page_id)) << 32) | static_cast<uint32_t>(frame_id);
+  }
+  static inline page_id_t UnpackPageId(uint64_t slot) { return static_cast<page_id_t>(slot >> 32); }
+  static inline frame_id_t UnpackFrameId(uint64_t slot) { return static_cast<frame_id_t>(slot & 0xFFFFFFFF); }
+
+  /** @return the home slot of page_id */
+  static inline size_t HomeSlot(const Slots &slots, page_id_t page_id) {
+    // Fibonacci hashing spreads the strided page ids of a parallel BPM instance across the table.
+    return (static_cast<uint32_t>(page_id) * 0x9E3779B97F4A7C15ULL) >> slots.shift_;
+  }
+
+  /** Adds a mapping to the given slots, which must have room for it. */
+  static void InsertInto(Slots *slots, page_id_t page_id, frame_id_t frame_id);
+
+  /** Rehashes all live entries in place to get rid of tombstones. Caller must hold the writer latch. */
+  void Compact();
+
+  /** Number of live entries. */
+  size_t size_{0};
+  /** Number of tombstones left behind by Remove. */
+  size_t tombstones_{0};
+  /** The current slots, read by lock-free lookups. */
+  std::atomic<Slots *> current_;
+  /** Every set of slots ever used, the last one being current_. */
+  std::vector<std::unique_ptr<Slots>> slots_;
+};
+
+}  // namespace bustub
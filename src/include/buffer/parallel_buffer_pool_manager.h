@@ -12,7 +12,11 @@
 
 #pragma once
 
+#include <mutex>  // NOLINT
+#include <vector>
+
 #include "buffer/buffer_pool_manager.h"
+#include "buffer/buffer_pool_manager_instance.h"
 #include "recovery/log_manager.h"
 #include "storage/disk/disk_manager.h"
 #include "storage/page/page.h"
@@ -39,6 +43,51 @@ class ParallelBufferPoolManager : public BufferPoolManager {
   /** @return size of the buffer pool */
   size_t GetPoolSize() override;
 
+  /** Registers a pin cache with every instance, since each of them may need its pins released. */
+  void RegisterPinCache(PinCache *cache) override;
+
+  /** Unregisters a pin cache from every instance. */
+  void UnregisterPinCache(PinCache *cache) override;
+
+  /**
+   * Resizes every instance, see BufferPoolManagerInstance::Resize.
+   * @param pool_size the new pool size of each instance
+   * @return the number of frames, over all instances, that still hold pinned pages beyond the new size
+   */
+  size_t Resize(size_t pool_size);
+
+  /**
+   * Resizes one instance, e.g. to move memory from an idle instance to a busy one.
+   * @param instance_index the instance to resize
+   * @param pool_size the new pool size of the instance
+   * @return the number of frames of the instance that still hold pinned pages beyond the new size
+   */
+  size_t ResizeInstance(size_t instance_index, size_t pool_size);
+
+  /** @return the statistics of all instances, added up */
+  BufferPoolStatsSnapshot GetStatsSnapshot() override;
+
+  /** @return a snapshot of the occupancy and contention counters of every instance, in instance order */
+  std::vector<BufferPoolInstanceStats> GetInstanceStats() const;
+
+  /**
+   * Moves frames from the instance with the most available frames to the one with the fewest, so that an instance
+   * whose pages are all pinned can load pages again. Page ids still map statically to instances, so this is what
+   * relieves a hot instance; NewPage placement alone cannot. Call it periodically or when fetches start to fail.
+   * @param max_frames the maximum number of frames to move
+   * @return the number of frames moved
+   */
+  size_t Rebalance(size_t max_frames = REBALANCE_MAX_FRAMES);
+
+  /**
+   * Starts a background writer in every instance.
+   * @param max_pages_per_round the maximum number of pages each instance writes back per round
+   */
+  void StartBackgroundWriter(size_t max_pages_per_round = BG_WRITER_MAX_PAGES);
+
+  /** Stops the background writers. */
+  void StopBackgroundWriter();
+
  protected:
   /**
    * @param page_id id of page
@@ -53,6 +102,28 @@ class ParallelBufferPoolManager : public BufferPoolManager {
    */
   Page *FetchPgImp(page_id_t page_id) override;
 
+  /**
+   * Fetch the requested page from the buffer pool, recycling frames of the given access strategy on a miss.
+   * @param page_id id of page to be fetched
+   * @param strategy the access strategy of the caller, nullptr = normal access
+   * @return the requested page
+   */
+  Page *FetchPgImp(page_id_t page_id, BufferAccessStrategy *strategy) override;
+
+  /**
+   * Starts reading a page into a reserved frame without pinning it.
+   * @param page_id id of page to read
+   * @return the read in flight, not valid if there is nothing to read or no frame to read into
+   */
+  std::future<bool> StartPrefetchPgImp(page_id_t page_id) override;
+
+  /**
+   * Waits for a read started by StartPrefetchPgImp and publishes the page unpinned, or frees its frame.
+   * @param page_id id of the page that is being read
+   * @param read the read in flight
+   */
+  void FinishPrefetchPgImp(page_id_t page_id, std::future<bool> read) override;
+
   /**
    * Unpin the target page from the buffer pool.
    * @param page_id id of page to be unpinned
@@ -75,6 +146,21 @@ class ParallelBufferPoolManager : public BufferPoolManager {
    */
   Page *NewPgImp(page_id_t *page_id) override;
 
+  /**
+   * Creates a new page of a tablespace in the buffer pool.
+   * @param[out] page_id id of created page
+   * @param space_id the tablespace to allocate the page in
+   * @return nullptr if no new pages could be created, otherwise pointer to new page
+   */
+  Page *NewPgImp(page_id_t *page_id, tablespace_id_t space_id) override;
+
+  /**
+   * Drops the pages of a tablespace from all instances without writing them back.
+   * @param space_id the tablespace
+   * @return false if a page of the tablespace is pinned
+   */
+  bool DiscardTablespacePgsImp(tablespace_id_t space_id) override;
+
   /**
    * Deletes a page from the buffer pool.
    * @param page_id id of page to be deleted
@@ -86,5 +172,22 @@ class ParallelBufferPoolManager : public BufferPoolManager {
    * Flushes all the pages in the buffer pool to disk.
    */
   void FlushAllPgsImp() override;
+
+  /** The individual buffer pool instances; page_id % num_instances selects the one that owns a page. */
+  std::vector<BufferPoolManagerInstance *> instances_;
+  /**
+   * Picks the instance for a new page: the one with the most available frames, and among those the one whose latch
+   * was contended least. Ties go round robin.
+   * @param start the instance to start looking at
+   * @return the index of the chosen instance
+   */
+  size_t PickInstance(size_t start) const;
+
+  /** Instance at which the next NewPgImp starts looking for a free frame. */
+  size_t next_instance_{0};
+  /** Protects next_instance_. */
+  std::mutex latch_;
+  /** Serializes Rebalance calls. */
+  std::mutex rebalance_latch_;
 };
 }  // namespace bustub
@@ -0,0 +1,136 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// pin_cache.h
+//
+// Identification: src/include/buffer/pin_cache.h
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <cstdint>
+#include <mutex>  // NOLINT
+#include <vector>
+
+#include "common/config.h"
+#include "common/macros.h"
+
+namespace bustub {
+
+class BufferPoolManager;
+class Page;
+
+/**
+ * PinCache keeps the pages an operation context fetched recently pinned across calls, so that pages fetched on every
+ * operation, e.g. an index root or a hash table directory, cost a short array scan instead of a page table lookup and
+ * a round-trip through the buffer pool.
+ *
+ * Fetches and unpins made through the cache only change a count local to the cache; the cache holds one buffer pool
+ * pin per cached page and drops it when the page is released. The owner calls AdvanceEpoch at operation boundaries;
+ * a page that nobody references and that was not used during the whole previous epoch is released then.
+ *
+ * A cache belongs to a single thread and must not be shared, except for Release and ReleaseAll: the cache registers
+ * with its buffer pool, which calls them from other threads before it gives up on deleting, discarding or retiring a
+ * pinned page.
+ */
+class PinCache {
+ public:
+  /**
+   * Creates a new PinCache.
+   * @param buffer_pool_manager the buffer pool to fetch pages from
+   * @param capacity the number of pages to keep pinned; exceeded only while all cached pages are in use
+   * @param max_idle_epochs the number of epochs an unreferenced page stays pinned without being used
+   */
+  explicit PinCache(BufferPoolManager *buffer_pool_manager, size_t capacity = PIN_CACHE_SIZE,
+                    uint64_t max_idle_epochs = PIN_CACHE_IDLE_EPOCHS);
+
+  /** Unregisters from the buffer pool and releases every cached page. */
+  ~PinCache();
+
+  DISALLOW_COPY_AND_MOVE(PinCache);
+
+  /**
+   * Fetches a page, from the cache if it holds the page.
+   * @param page_id id of page to be fetched
+   * @return the requested page, nullptr if the buffer pool could not load it
+   */
+  Page *FetchPage(page_id_t page_id);
+
+  /**
+   * Unpins a page fetched through the cache. The dirty flag is set on the page right away, through the pin the cache
+   * holds, so that flushes see it. The buffer pool is only involved if the page is released.
+   * @param page_id id of page to be unpinned
+   * @param is_dirty true if the page should be marked as dirty
+   * @return false if the page was not pinned through the cache, true otherwise
+   */
+  bool UnpinPage(page_id_t page_id, bool is_dirty);
+
+  /** Starts a new epoch and releases the pages that have been idle for too long. */
+  void AdvanceEpoch();
+
+  /**
+   * Drops the cache's pin on a page. If the page is referenced through the cache, the pin is dropped as soon as the
+   * last reference is unpinned. May be called from any thread.
+   * @param page_id the page to release
+   */
+  void Release(page_id_t page_id);
+
+  /** Drops the cache's pins on all pages, like Release. May be called from any thread. */
+  void ReleaseAll();
+
+  /** @return the buffer pool the cache fetches pages from */
+  BufferPoolManager *GetBufferPoolManager() const { return buffer_pool_manager_; }
+
+  /** @return the number of pages the cache keeps pinned */
+  size_t Size() const { return entries_.size(); }
+
+  /** @return the number of fetches served without going to the buffer pool */
+  uint64_t GetHits() const { return hits_; }
+
+  /** @return the number of fetches that went to the buffer pool */
+  uint64_t GetMisses() const { return misses_; }
+
+ private:
+  struct Entry {
+    page_id_t page_id_;
+    Page *page_;
+    /** Fetches through the cache that have not been unpinned yet. */
+    uint32_t ref_count_;
+    /** Epoch in which the page was last fetched. */
+    uint64_t last_epoch_;
+    /** True if the pin is to be dropped once ref_count_ reaches 0. */
+    bool release_;
+  };
+
+  /** @return the entry of a page, nullptr if the page is not cached */
+  Entry *Find(page_id_t page_id);
+
+  /** Releases the page of an entry now if it is unreferenced, otherwise once it is. Caller must hold latch_. */
+  void ReleaseOrDefer(size_t index);
+
+  /** Drops the cache's pin on entries_[index]. Caller must hold latch_. */
+  void ReleaseAt(size_t index);
+
+  /**
+   * Releases the least recently used page that is not referenced. Caller must hold latch_.
+   * @return false if every cached page is referenced
+   */
+  bool ReleaseOldest();
+
+  BufferPoolManager *buffer_pool_manager_;
+  const size_t capacity_;
+  const uint64_t max_idle_epochs_;
+  uint64_t epoch_{0};
+  /** The cached pages. Kept small, so a linear scan beats hashing. */
+  std::vector<Entry> entries_;
+  /** Protects entries_. Only the owner thread and the release hooks of the buffer pool take it. */
+  std::mutex latch_;
+  uint64_t hits_{0};
+  uint64_t misses_{0};
+};
+
+}  // namespace bustub
@@ -0,0 +1,88 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// prefetcher.h
+//
+// Identification: src/include/buffer/prefetcher.h
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <condition_variable>  // NOLINT
+#include <deque>
+#include <future>  // NOLINT
+#include <mutex>   // NOLINT
+#include <thread>  // NOLINT
+#include <unordered_set>
+#include <vector>
+
+#include "common/config.h"
+
+namespace bustub {
+
+class BufferPoolManager;
+class Page;
+
+/**
+ * Reads the id of the page that follows the given page in a page chain, e.g. the next page of a table heap or the
+ * next leaf of a B+ tree. Called with the page read-latched. Returns INVALID_PAGE_ID at the end of the chain.
+ */
+using prefetch_next_fn = page_id_t (*)(Page *page);
+
+/**
+ * Prefetcher loads pages into a buffer pool from a small pool of background threads, so that the I/O for pages a
+ * scan will need next overlaps with the processing of the pages it already has. Each thread submits the reads of
+ * several queued requests before it waits for any of them. Prefetched pages are left unpinned.
+ *
+ * Requests are hints: they are dropped if the page is already queued, if the queue is full, or if the buffer pool has
+ * no frame to spare.
+ */
+class Prefetcher {
+ public:
+  /**
+   * Creates a new Prefetcher and starts its threads.
+   * @param buffer_pool_manager the buffer pool to load pages into
+   * @param num_threads number of background I/O threads
+   * @param max_pending maximum number of queued requests
+   * @param max_in_flight maximum number of reads one thread has in flight
+   */
+  Prefetcher(BufferPoolManager *buffer_pool_manager, size_t num_threads, size_t max_pending, size_t max_in_flight);
+
+  /** Stops the background threads. Queued requests are dropped; reads in flight are finished. */
+  ~Prefetcher();
+
+  /**
+   * Queues a page to be loaded.
+   * @param page_id the page to load
+   * @param depth number of further pages to follow through next_fn once the page is loaded
+   * @param next_fn how to find the next page of the chain, nullptr if depth is 0
+   */
+  void Schedule(page_id_t page_id, size_t depth, prefetch_next_fn next_fn);
+
+ private:
+  struct Request {
+    page_id_t page_id_;
+    size_t depth_;
+    prefetch_next_fn next_fn_;
+  };
+
+  /** Background thread body. */
+  void Run();
+
+  BufferPoolManager *buffer_pool_manager_;
+  const size_t max_pending_;
+  const size_t max_in_flight_;
+  std::deque<Request> queue_;
+  /** Pages in queue_, to drop duplicate requests. */
+  std::unordered_set<page_id_t> queued_;
+  bool shutdown_{false};
+  std::mutex latch_;
+  std::condition_variable cv_;
+  std::vector<std::thread> threads_;
+};
+
+}  // namespace bustub
@@ -12,6 +12,8 @@
 
 #pragma once
 
+#include <vector>
+
 #include "common/config.h"
 
 namespace bustub {
@@ -37,12 +39,42 @@ class Replacer {
    */
   virtual void Pin(frame_id_t frame_id) = 0;
 
+  /**
+   * Tells the replacer which page was just loaded into a frame, before the frame is pinned for it. Replacers that
+   * remember recently evicted pages by their id use it; the others ignore it.
+   * @param frame_id the id of the frame
+   * @param page_id the id of the page now in the frame
+   */
+  virtual void Load(frame_id_t frame_id, page_id_t page_id) {}
+
   /**
    * Unpins a frame, indicating that it can now be victimized.
    * @param frame_id the id of the frame to unpin
    */
   virtual void Unpin(frame_id_t frame_id) = 0;
 
+  /**
+   * Removes a frame from the replacer and forgets anything the replacer remembers about its page, e.g. because the
+   * page was deleted. Replacers that keep no per-page history can treat this as a Pin.
+   * @param frame_id the id of the frame to remove
+   */
+  virtual void Remove(frame_id_t frame_id) { Pin(frame_id); }
+
+  /**
+   * Lists the frames that are closest to being victimized, in the order the replacer would currently pick them,
+   * without removing them. Replacers that cannot tell return nothing.
+   * @param max_frames the maximum number of frames to list
+   * @return the next victims, most imminent first
+   */
+  virtual std::vector<frame_id_t> PeekVictims(size_t max_frames) { return {}; }
+
+  /**
+   * Makes room for frame ids below num_pages, after the buffer pool added frames. Buffer pools never take frames away,
+   * so the number of frames only grows.
+   * @param num_pages the new number of frames
+   */
+  virtual void Grow(size_t num_pages) {}
+
   /** @return the number of elements in the replacer that can be victimized */
   virtual size_t Size() = 0;
 };
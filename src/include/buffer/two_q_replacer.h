@@ -0,0 +1,105 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// two_q_replacer.h
+//
+// Identification: src/include/buffer/two_q_replacer.h
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <list>
+#include <mutex>  // NOLINT
+#include <unordered_map>
+#include <vector>
+
+#include "buffer/replacer.h"
+#include "common/config.h"
+
+namespace bustub {
+
+/**
+ * TwoQReplacer implements the full 2Q replacement policy (Johnson and Shasha).
+ *
+ * A newly loaded page goes to the A1 FIFO queue. Further references while it is in A1 are correlated, e.g. a table
+ * scan pinning the page once per tuple, and leave it where it is. When a page is evicted from A1, its id is
+ * remembered in the A1out ghost queue; only a page that is loaded again while A1out remembers it goes to the Am LRU
+ * queue. Victims are taken from A1 while it holds more than its share of the pool, so pages read once (e.g. by a
+ * sequential scan) cycle through A1 without displacing the pages in Am.
+ *
+ * The buffer pool reports the page of a frame through Load. Frames that are pinned without a Load always start in A1.
+ */
+class TwoQReplacer : public Replacer {
+ public:
+  /**
+   * Create a new TwoQReplacer.
+   * @param num_pages the maximum number of pages the TwoQReplacer will be required to store
+   * @param a1_size the number of frames A1 may hold before it becomes the preferred source of victims,
+   * 0 means a quarter of num_pages
+   * @param a1out_size the number of evicted page ids A1out remembers, 0 means half of num_pages
+   */
+  explicit TwoQReplacer(size_t num_pages, size_t a1_size = 0, size_t a1out_size = 0);
+
+  /**
+   * Destroys the TwoQReplacer.
+   */
+  ~TwoQReplacer() override;
+
+  bool Victim(frame_id_t *frame_id) override;
+
+  void Pin(frame_id_t frame_id) override;
+
+  void Load(frame_id_t frame_id, page_id_t page_id) override;
+
+  void Unpin(frame_id_t frame_id) override;
+
+  void Remove(frame_id_t frame_id) override;
+
+  std::vector<frame_id_t> PeekVictims(size_t max_frames) override;
+
+  void Grow(size_t num_pages) override;
+
+  size_t Size() override;
+
+ private:
+  enum class Queue { NONE, A1, AM };
+
+  struct FrameEntry {
+    Queue queue_{Queue::NONE};
+    std::list<frame_id_t>::iterator pos_;
+    bool evictable_{false};
+    /** The page reported by Load, INVALID_PAGE_ID if there was none. */
+    page_id_t page_id_{INVALID_PAGE_ID};
+    /** True if A1out remembered the page when it was loaded, so that its first pin puts it into Am. */
+    bool ghost_hit_{false};
+  };
+
+  /** Takes the first unpinned frame of the given queue. */
+  bool VictimFrom(std::list<frame_id_t> *queue, frame_id_t *frame_id);
+
+  /** Drops a frame from whichever queue holds it. */
+  void Erase(frame_id_t frame_id);
+
+  /** Adds the id of a page evicted from A1 to A1out, forgetting the oldest one if A1out is full. */
+  void RememberEvicted(page_id_t page_id);
+
+  const size_t a1_size_;
+  const size_t a1out_size_;
+  std::vector<FrameEntry> frames_;
+  /** Frames referenced once since they were loaded, oldest first. */
+  std::list<frame_id_t> a1_;
+  /** Frames whose pages were loaded again soon after being evicted from A1, least recently referenced first. */
+  std::list<frame_id_t> am_;
+  /** Ids of the pages evicted from A1 most recently, oldest first, and where each one is in the list. */
+  std::list<page_id_t> a1out_;
+  std::unordered_map<page_id_t, std::list<page_id_t>::iterator> a1out_index_;
+  /** Number of unpinned frames. */
+  size_t size_{0};
+  std::mutex latch_;
+};
+
+}  // namespace bustub
@@ -186,7 +186,8 @@ class Catalog {
    * @param key_attrs Key attributes
    * @param keysize Size of the key
    * @param hash_function The hash function for the index
-   * @return A (non-owning) pointer to the metadata of the new table
+   * @return A (non-owning) pointer to the metadata of the new table, or NULL_INDEX_INFO if the index could not be
+   * created or populated with every tuple
    */
   template <class KeyType, class ValueType, class KeyComparator>
   IndexInfo *CreateIndex(Transaction *txn, const std::string &index_name, const std::string &table_name,
@@ -217,11 +218,21 @@ class Catalog {
     auto index = std::make_unique<ExtendibleHashTableIndex<KeyType, ValueType, KeyComparator>>(std::move(meta), bpm_,
                                                                                                hash_function);
 
-    // Populate the index with all tuples in table heap
+    // Populate the index with all tuples in table heap. The back-fill reads the whole table once, so keep it from
+    // evicting the working set of concurrent queries. The keys are collected first, so that the index is built in one
+    // go rather than growing bucket by bucket.
     auto *table_meta = GetTable(table_name);
     auto *heap = table_meta->table_.get();
-    for (auto tuple = heap->Begin(txn); tuple != heap->End(); ++tuple) {
-      index->InsertEntry(tuple->KeyFromTuple(schema, key_schema, key_attrs), tuple->GetRid(), txn);
+    BufferAccessStrategy strategy(AccessHint::BULK_READ);
+    std::vector<std::pair<KeyType, RID>> entries;
+    for (auto tuple = heap->Begin(txn, &strategy); tuple != heap->End(); ++tuple) {
+      KeyType index_key;
+      index_key.SetFromKey(tuple->KeyFromTuple(schema, key_schema, key_attrs));
+      entries.emplace_back(index_key, tuple->GetRid());
+    }
+    if (!index->BulkLoad(entries, txn)) {
+      // An index that misses some tuples would give wrong answers
+      return NULL_INDEX_INFO;
     }
 
     // Get the next OID for the new index
@@ -16,6 +16,11 @@
 #include <chrono>  // NOLINT
 #include <cstdint>
 
+/** Size of a data page, chosen when configuring the build (-DBUSTUB_PAGE_SIZE=8192). A database keeps its page size. */
+#ifndef BUSTUB_PAGE_SIZE
+#define BUSTUB_PAGE_SIZE 4096  // NOLINT
+#endif
+
 namespace bustub {
 
 /** Cycle detection is performed every CYCLE_DETECTION_INTERVAL milliseconds. */
@@ -24,23 +29,52 @@ extern std::chrono::milliseconds cycle_detection_interval;
 /** True if logging should be enabled, false otherwise. */
 extern std::atomic<bool> enable_logging;
 
+/**
+ * True if buffer pools created from now on should back their frames with huge pages where possible. Off by default;
+ * frame chunks smaller than a huge page never use them.
+ */
+extern std::atomic<bool> enable_huge_pages;
+
 /** If ENABLE_LOGGING is true, the log should be flushed to disk every LOG_TIMEOUT. */
 extern std::chrono::duration<int64_t> log_timeout;
 
+/** A running background writer cleans the pages next in line for eviction every BG_WRITER_DELAY. */
+extern std::chrono::milliseconds bg_writer_delay;
+
 static constexpr int INVALID_PAGE_ID = -1;                                    // invalid page id
 static constexpr int INVALID_TXN_ID = -1;                                     // invalid transaction id
 static constexpr int INVALID_LSN = -1;                                        // invalid log sequence number
+static constexpr int INVALID_TABLESPACE_ID = -1;                              // invalid tablespace id
 static constexpr int HEADER_PAGE_ID = 0;                                      // the header page id
-static constexpr int PAGE_SIZE = 4096;                                        // size of a data page in byte
+static constexpr int PAGE_SIZE = BUSTUB_PAGE_SIZE;                            // size of a data page in byte
 static constexpr int BUFFER_POOL_SIZE = 10;                                   // size of buffer pool
 static constexpr int LOG_BUFFER_SIZE = ((BUFFER_POOL_SIZE + 1) * PAGE_SIZE);  // size of a log buffer in byte
 static constexpr int BUCKET_SIZE = 50;                                        // size of extendible hash bucket
+static constexpr int BULK_READ_RING_SIZE = 32;                                // frames a sequential scan cycles through
+static constexpr int BULK_WRITE_RING_SIZE = 256;                              // frames a bulk write cycles through
+static constexpr int PREFETCH_THREADS = 2;                                    // background read-ahead I/O threads
+static constexpr int PREFETCH_QUEUE_SIZE = 256;                               // max queued read-ahead requests
+static constexpr int PREFETCH_IO_DEPTH = 8;                                   // reads a read-ahead thread keeps in flight
+static constexpr int LRUK_CORRELATED_PERIOD = 16;                             // LRU-K references that count as one
+static constexpr int BG_WRITER_MAX_PAGES = 16;                                // pages a background writer round cleans
+static constexpr int REBALANCE_MAX_FRAMES = 64;                               // frames one rebalance step moves
+static constexpr int PIN_CACHE_SIZE = 8;                                      // pages a pin cache keeps pinned
+static constexpr int PIN_CACHE_IDLE_EPOCHS = 1;                               // epochs an idle cached page stays pinned
+static constexpr int OPTIMISTIC_READ_ATTEMPTS = 2;                            // optimistic page reads before latching
+static constexpr int ASYNC_IO_QUEUE_DEPTH = 64;                               // page I/Os in flight per async backend
+static constexpr int ASYNC_IO_THREADS = 4;                                    // threads of the thread pool disk backend
+static constexpr int TABLESPACE_SHIFT = 24;                                   // page id bits of a page in a tablespace
+static constexpr int MAX_TABLESPACES = 16;                                    // tablespaces, the default one included
+
+static_assert(PAGE_SIZE >= 4096 && PAGE_SIZE <= 32768 && (PAGE_SIZE & (PAGE_SIZE - 1)) == 0,
+              "the page size must be a power of two from 4 KB to 32 KB");
 
-using frame_id_t = int32_t;    // frame id type
-using page_id_t = int32_t;     // page id type
-using txn_id_t = int32_t;      // transaction id type
-using lsn_t = int32_t;         // log sequence number type
-using slot_offset_t = size_t;  // slot offset type
+using frame_id_t = int32_t;       // frame id type
+using page_id_t = int32_t;        // page id type
+using tablespace_id_t = int32_t;  // tablespace id type
+using txn_id_t = int32_t;         // transaction id type
+using lsn_t = int32_t;            // log sequence number type
+using slot_offset_t = size_t;     // slot offset type
 using oid_t = uint16_t;
 
 }  // namespace bustub
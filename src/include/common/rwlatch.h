@@ -12,25 +12,72 @@
 
 #pragma once
 
+#include <array>
+#include <atomic>
 #include <climits>
-#include <condition_variable>  // NOLINT
-#include <mutex>               // NOLINT
+#include <cstdint>
 
 #include "common/macros.h"
 
 namespace bustub {
 
 /**
- * Reader-Writer latch backed by std::mutex.
+ * Blocking support for latches that keep all of their state in one atomic word. A thread that has spun long enough
+ * parks on one of a fixed set of condition variables, picked by the address of the word, and sets PARKED in the word
+ * so that the thread changing the word next knows to wake it. Latches thus stay one word large, and uncontended
+ * latching never touches a mutex.
+ */
+class LatchParking {
+ public:
+  /** Bit of a latch word that is set while a thread may be parked on it. */
+  static constexpr uint32_t PARKED = 1U << 30;
+  /** Number of times a latch retries before its thread parks. */
+  static constexpr int SPIN_LIMIT = 32;
+
+  /** Backs off for one round of spinning. */
+  static void Pause();
+
+  /**
+   * Parks the calling thread until the latch word admits it.
+   * @param word the latch word
+   * @param can_proceed returns true for values of the word that admit the thread
+   */
+  template <typename Predicate>
+  static void Park(std::atomic<uint32_t> *word, Predicate can_proceed) {
+    predicate_fn check = [](const void *arg, uint32_t value) { return (*static_cast<const Predicate *>(arg))(value); };
+    while (!ParkOnce(word, check, &can_proceed)) {
+    }
+  }
+
+  /** Wakes the threads parked on a latch word, if any. Call after every change that may admit a parked thread. */
+  static void UnparkAll(std::atomic<uint32_t> *word) {
+    if ((word->load() & PARKED) != 0) {
+      UnparkAllSlow(word);
+    }
+  }
+
+ private:
+  using predicate_fn = bool (*)(const void *arg, uint32_t value);
+
+  /** Sets PARKED and waits for one wake-up, unless can_proceed already holds. @return true if can_proceed held */
+  static bool ParkOnce(std::atomic<uint32_t> *word, predicate_fn can_proceed, const void *arg);
+  static void UnparkAllSlow(std::atomic<uint32_t> *word);
+};
+
+/**
+ * Reader-writer latch in a single atomic word: a writer bit, the parked bit and a reader count. Readers and writers
+ * take it with one compare-and-swap when it is free, spin for a while when it is not and then park. It prefers
+ * writers: once a writer has announced itself, new readers wait until it is done, so a steady stream of readers cannot
+ * starve writers.
  */
 class ReaderWriterLatch {
-  using mutex_t = std::mutex;
-  using cond_t = std::condition_variable;
-  static const uint32_t MAX_READERS = UINT_MAX;
+  static constexpr uint32_t WRITER = 1U << 31;
+  static constexpr uint32_t READERS = LatchParking::PARKED - 1;
+  static constexpr uint32_t MAX_READERS = READERS;
 
  public:
   ReaderWriterLatch() = default;
-  ~ReaderWriterLatch() { std::lock_guard<mutex_t> guard(mutex_); }
+  ~ReaderWriterLatch() = default;
 
   DISALLOW_COPY(ReaderWriterLatch);
 
@@ -38,13 +85,27 @@ class ReaderWriterLatch {
    * Acquire a write latch.
    */
   void WLock() {
-    std::unique_lock<mutex_t> latch(mutex_);
-    while (writer_entered_) {
-      reader_.wait(latch);
+    // Announce the writer first, which holds off new readers, then wait for the current readers to leave.
+    for (int spins = 0;; spins++) {
+      uint32_t state = state_.load(std::memory_order_relaxed);
+      if ((state & WRITER) == 0) {
+        if (state_.compare_exchange_weak(state, state | WRITER, std::memory_order_acquire)) {
+          break;
+        }
+        continue;
+      }
+      if (spins < LatchParking::SPIN_LIMIT) {
+        LatchParking::Pause();
+      } else {
+        LatchParking::Park(&state_, [](uint32_t value) { return (value & WRITER) == 0; });
+      }
     }
-    writer_entered_ = true;
-    while (reader_count_ > 0) {
-      writer_.wait(latch);
+    for (int spins = 0; (state_.load(std::memory_order_acquire) & READERS) != 0; spins++) {
+      if (spins < LatchParking::SPIN_LIMIT) {
+        LatchParking::Pause();
+      } else {
+        LatchParking::Park(&state_, [](uint32_t value) { return (value & READERS) == 0; });
+      }
     }
   }
 
@@ -52,45 +113,120 @@ class ReaderWriterLatch {
    * Release a write latch.
    */
   void WUnlock() {
-    std::lock_guard<mutex_t> guard(mutex_);
-    writer_entered_ = false;
-    reader_.notify_all();
+    state_.fetch_and(~WRITER);
+    LatchParking::UnparkAll(&state_);
   }
 
   /**
    * Acquire a read latch.
    */
   void RLock() {
-    std::unique_lock<mutex_t> latch(mutex_);
-    while (writer_entered_ || reader_count_ == MAX_READERS) {
-      reader_.wait(latch);
+    for (int spins = 0;; spins++) {
+      uint32_t state = state_.load(std::memory_order_relaxed);
+      if ((state & WRITER) == 0 && (state & READERS) < MAX_READERS) {
+        if (state_.compare_exchange_weak(state, state + 1, std::memory_order_acquire)) {
+          return;
+        }
+        continue;
+      }
+      if (spins < LatchParking::SPIN_LIMIT) {
+        LatchParking::Pause();
+      } else {
+        LatchParking::Park(&state_, [](uint32_t value) {
+          return (value & WRITER) == 0 && (value & READERS) < MAX_READERS;
+        });
+      }
     }
-    reader_count_++;
   }
 
   /**
    * Release a read latch.
    */
   void RUnlock() {
-    std::lock_guard<mutex_t> guard(mutex_);
-    reader_count_--;
-    if (writer_entered_) {
-      if (reader_count_ == 0) {
-        writer_.notify_one();
-      }
-    } else {
-      if (reader_count_ == MAX_READERS - 1) {
-        reader_.notify_one();
-      }
+    uint32_t state = state_.fetch_sub(1) - 1;
+    // Wake a writer waiting for the last reader, or a reader waiting for a free reader slot.
+    if ((state & READERS) == 0 || (state & READERS) == MAX_READERS - 1) {
+      LatchParking::UnparkAll(&state_);
+    }
+  }
+
+ private:
+  std::atomic<uint32_t> state_{0};
+};
+
+/**
+ * Reader-writer latch for extremely read-hot data, e.g. a structure every operation reads. Readers count themselves
+ * in one of several cache-line sized slots, picked per thread, so that they do not contend for a single line; writers
+ * have to check every slot, which makes write latching correspondingly more expensive. Same interface and writer
+ * preference as ReaderWriterLatch, but about a kilobyte large, so use it for a few hot latches, not per page.
+ *
+ * Unlike ReaderWriterLatch, a read latch must be released by the thread that acquired it, since the release takes
+ * the reader off the slot of the calling thread. Debug builds assert this.
+ */
+class ShardedReaderWriterLatch {
+  static constexpr uint32_t WRITER = 1U << 31;
+
+ public:
+  static constexpr size_t NUM_SLOTS = 16;
+
+  ShardedReaderWriterLatch() = default;
+  ~ShardedReaderWriterLatch() = default;
+
+  DISALLOW_COPY(ShardedReaderWriterLatch);
+
+  /**
+   * Acquire a write latch.
+   */
+  void WLock();
+
+  /**
+   * Release a write latch.
+   */
+  void WUnlock() {
+    writer_.fetch_and(~WRITER);
+    LatchParking::UnparkAll(&writer_);
+  }
+
+  /**
+   * Acquire a read latch.
+   */
+  void RLock();
+
+  /**
+   * Release a read latch. Only the thread that acquired it may release it.
+   */
+  void RUnlock() {
+#ifndef NDEBUG
+    int &held = HeldReadLatches();
+    held--;
+    BUSTUB_ASSERT(held >= 0, "read latch released by a thread that does not hold one");
+#endif
+    [[maybe_unused]] uint32_t readers = slots_[SlotIndex()].readers_.fetch_sub(1);
+    BUSTUB_ASSERT(readers > 0, "read latch released from the slot of another thread");
+    if ((writer_.load() & WRITER) != 0) {
+      LatchParking::UnparkAll(&writer_);
     }
   }
 
  private:
-  mutex_t mutex_;
-  cond_t writer_;
-  cond_t reader_;
-  uint32_t reader_count_{0};
-  bool writer_entered_{false};
+  struct alignas(64) Slot {
+    std::atomic<uint32_t> readers_{0};
+  };
+
+  /** @return the reader slot of the calling thread */
+  static size_t SlotIndex();
+
+#ifndef NDEBUG
+  /** @return the number of read latches of any ShardedReaderWriterLatch that the calling thread holds */
+  static int &HeldReadLatches();
+#endif
+
+  /** @return true if no slot counts a reader */
+  bool NoReaders() const;
+
+  /** The writer bit and the parked bit; readers and writers park on this word. */
+  std::atomic<uint32_t> writer_{0};
+  std::array<Slot, NUM_SLOTS> slots_;
 };
 
 }  // namespace bustub
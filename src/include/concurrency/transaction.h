@@ -55,6 +55,7 @@ enum class WType { INSERT = 0, DELETE, UPDATE };
 
 class TableHeap;
 class Catalog;
+class PinCache;
 using table_oid_t = uint32_t;
 using index_oid_t = uint32_t;
 
@@ -246,6 +247,15 @@ class Transaction {
    */
   inline void SetPrevLSN(lsn_t prev_lsn) { prev_lsn_ = prev_lsn; }
 
+  /** @return the pin cache of the executor context running the transaction, nullptr if there is none */
+  inline PinCache *GetPinCache() { return pin_cache_; }
+
+  /**
+   * Set the pin cache that index operations run for the transaction fetch their hot pages through.
+   * @param pin_cache the pin cache, nullptr = fetch from the buffer pool
+   */
+  inline void SetPinCache(PinCache *pin_cache) { pin_cache_ = pin_cache; }
+
  private:
   /** The current transaction state. */
   TransactionState state_;
@@ -272,6 +282,9 @@ class Transaction {
   std::shared_ptr<std::unordered_set<RID>> shared_lock_set_;
   /** LockManager: the set of exclusive-locked tuples held by this transaction. */
   std::shared_ptr<std::unordered_set<RID>> exclusive_lock_set_;
+
+  /** The pin cache of the executor context running the transaction, owned by the context. */
+  PinCache *pin_cache_{nullptr};
 };
 
 }  // namespace bustub
@@ -14,11 +14,13 @@
 
 #include <queue>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include "buffer/buffer_pool_manager.h"
 #include "concurrency/transaction.h"
 #include "container/hash/hash_function.h"
+#include "container/hash/hash_table_directory.h"
 #include "storage/page/hash_table_bucket_page.h"
 #include "storage/page/hash_table_directory_page.h"
 
@@ -30,6 +32,17 @@ namespace bustub {
  * Implementation of extendible hash table that is backed by a buffer pool
  * manager. Non-unique keys are supported. Supports insert and delete. The
  * table grows/shrinks dynamically as buckets become full/empty.
+ *
+ * The directory is kept in the directory page up to DIRECTORY_ARRAY_SIZE entries and in segment pages beyond that
+ * (see HashTableDirectory), which lets the table grow to 2^27 buckets with 4 KB pages. Keys whose hash is the same
+ * cannot be split apart, so once they fill half of a bucket, they move to an overflow chain of the bucket instead of
+ * growing the directory (see HashTableBucketPage).
+ *
+ * Concurrency: every operation holds table_latch_ shared and latch-crabs from the directory page to the bucket page,
+ * so operations on different buckets run in parallel. Lookups, inserts and removes read-latch the directory; splits
+ * and merges write-latch it while they repoint its entries, and a split lets go of it before moving entries to the new
+ * bucket. Only a change of the global depth (doubling or halving the directory) takes table_latch_ exclusively. The
+ * latch of a bucket also covers its overflow chain.
  */
 template <typename KeyType, typename ValueType, typename KeyComparator>
 class ExtendibleHashTable {
@@ -74,6 +87,20 @@ class ExtendibleHashTable {
    */
   bool GetValue(Transaction *transaction, const KeyType &key, std::vector<ValueType> *result);
 
+  /**
+   * Loads (key, value) pairs into an empty table. Rather than splitting buckets and doubling the directory as pairs
+   * come in one at a time, it partitions the pairs by the low bits of their hash until each partition fits into a
+   * bucket, sizes the directory once, and fills each bucket page in one go. A hash whose pairs fill half a bucket gets
+   * an overflow chain, as it would from Insert.
+   *
+   * @param transaction the current transaction
+   * @param entries the pairs to load
+   * @return false if the table is not empty or there was no frame for a page, in which case nothing was loaded, or if
+   * some of the pairs that did not fit into their bucket could not be inserted afterwards, in which case only those
+   * are missing
+   */
+  bool BulkLoad(Transaction *transaction, const std::vector<MappingType> &entries);
+
   /**
    * Returns the global depth.  Do not touch.
    */
@@ -107,19 +134,47 @@ class ExtendibleHashTable {
    * representation.
    *
    * @param key the key to use for lookup
-   * @param dir_page to use for lookup of global depth
+   * @param dir to use for lookup of global depth
    * @return the directory index
    */
-  inline uint32_t KeyToDirectoryIndex(KeyType key, HashTableDirectoryPage *dir_page);
+  inline uint32_t KeyToDirectoryIndex(KeyType key, HashTableDirectory *dir);
 
   /**
    * Get the bucket page_id corresponding to a key.
    *
    * @param key the key for lookup
-   * @param dir_page a pointer to the hash table's directory page
+   * @param dir a pointer to the hash table's directory
    * @return the bucket page_id corresponding to the input key
    */
-  inline uint32_t KeyToPageId(KeyType key, HashTableDirectoryPage *dir_page);
+  inline uint32_t KeyToPageId(KeyType key, HashTableDirectory *dir);
+
+  /**
+   * Get the bucket page_id corresponding to a key from the latched directory page.
+   *
+   * @param key the key for lookup
+   * @param dir the pinned and latched directory page
+   * @return the bucket page_id corresponding to the input key, INVALID_PAGE_ID if there was no frame for the directory
+   * segment holding it
+   */
+  page_id_t LookupBucketPageId(const KeyType &key, Page *dir);
+
+  /**
+   * Fetches a page of the hash table from the buffer pool manager.
+   *
+   * @param page_id the page_id to fetch
+   * @return the pinned page, nullptr if no frame was free
+   */
+  Page *FetchPage(page_id_t page_id);
+
+  /** @return the directory stored in a page */
+  static HashTableDirectoryPage *DirectoryOf(Page *page) {
+    return reinterpret_cast<HashTableDirectoryPage *>(page->GetData());
+  }
+
+  /** @return the bucket stored in a page */
+  static HASH_TABLE_BUCKET_TYPE *BucketOf(Page *page) {
+    return reinterpret_cast<HASH_TABLE_BUCKET_TYPE *>(page->GetData());
+  }
 
   /**
    * Fetches the directory page from the buffer pool manager.
@@ -128,6 +183,28 @@ class ExtendibleHashTable {
    */
   HashTableDirectoryPage *FetchDirectoryPage();
 
+  /**
+   * @return the pin cache attached to the transaction, nullptr if there is none or it caches another buffer pool
+   */
+  PinCache *PinCacheOf(Transaction *transaction);
+
+  /**
+   * Starts a new epoch of the transaction's pin cache, so that pages the previous operations stopped using are
+   * released. Called at the start of every public operation.
+   */
+  void StartOperation(Transaction *transaction);
+
+  /**
+   * Fetches the directory page, through the transaction's pin cache if it has one. The directory is fetched by every
+   * operation, so the cache keeps it pinned across the operations of a transaction.
+   *
+   * @return the pinned directory page, nullptr if no frame was free
+   */
+  Page *FetchDirectory(Transaction *transaction);
+
+  /** Unpins the directory page fetched by FetchDirectory. */
+  void UnpinDirectory(Transaction *transaction, bool is_dirty);
+
   /**
    * Fetches the a bucket page from the buffer pool manager using the bucket's page_id.
    *
@@ -136,6 +213,92 @@ class ExtendibleHashTable {
    */
   HASH_TABLE_BUCKET_TYPE *FetchBucketPage(page_id_t bucket_page_id);
 
+  /**
+   * Creates a bucket page without an overflow chain.
+   *
+   * @param[out] page_id the page_id of the new page
+   * @return the pinned page, nullptr if no frame was free
+   */
+  Page *NewBucketPage(page_id_t *page_id);
+
+  /** @return true if the bucket has an overflow chain for the hash of key */
+  bool IsChained(HASH_TABLE_BUCKET_TYPE *bucket_page, const KeyType &key);
+
+  /**
+   * Finds the hash that most keys in a full bucket share.
+   *
+   * @param bucket_page the bucket
+   * @param[out] hash the hash of most keys
+   * @return true if the keys of that hash fill at least half of the bucket
+   */
+  bool DominantHash(HASH_TABLE_BUCKET_TYPE *bucket_page, uint32_t *hash);
+
+  /**
+   * Finds the hash that most of a number of keys share.
+   *
+   * @param hashes the hashes of the keys; sorted on return
+   * @param[out] hash the hash of most keys
+   * @return true if the keys of that hash would fill at least half of a bucket
+   */
+  static bool DominantHash(std::vector<uint32_t> *hashes, uint32_t *hash);
+
+  /**
+   * Builds the overflow chain of a bucket that BulkLoad fills: puts pairs of one hash into new overflow pages and
+   * links them. The caller links the bucket to the first page.
+   *
+   * @param entries the pairs of the bulk load
+   * @param hashes (hash, index in entries) of the pairs of the bulk load
+   * @param begin first index in hashes of the chain's pairs
+   * @param end one past the last index in hashes of the chain's pairs
+   * @param hash the hash of the chain's pairs
+   * @param[out] page_ids the pages of the chain are appended, first to last
+   * @return false if there was no frame for a page; the pages created so far are appended anyway
+   */
+  bool BuildChain(const std::vector<MappingType> &entries, const std::vector<std::pair<uint32_t, size_t>> &hashes,
+                  size_t begin, size_t end, uint32_t hash, std::vector<page_id_t> *page_ids);
+
+  /**
+   * Moves the pairs of a hash from a bucket without a chain into a new overflow page. The caller holds the bucket's
+   * write latch.
+   *
+   * @param bucket the pinned and latched bucket page
+   * @param hash the hash of the pairs to move
+   * @return false if there was no frame for the overflow page
+   */
+  bool StartChain(Page *bucket, uint32_t hash);
+
+  /**
+   * Collects the values of a key from the overflow chain of a bucket. The caller holds the bucket's latch.
+   *
+   * @param bucket_page the bucket, whose chain is for the hash of key
+   * @param key the key to look up
+   * @param[out] result the values are appended here
+   * @return true if the chain holds a value of key
+   */
+  bool ChainGetValue(HASH_TABLE_BUCKET_TYPE *bucket_page, const KeyType &key, std::vector<ValueType> *result);
+
+  /**
+   * Inserts a pair into the overflow chain of a bucket, extending the chain if all of its pages are full. The caller
+   * holds the bucket's write latch.
+   *
+   * @param bucket the pinned and latched bucket page, whose chain is for the hash of key
+   * @param key the key to insert
+   * @param value the value to insert
+   * @return false if the pair is already there, or there was no frame for a page
+   */
+  bool ChainInsert(Page *bucket, const KeyType &key, const ValueType &value);
+
+  /**
+   * Removes a pair from the overflow chain of a bucket, deleting the chain page if it becomes empty. The caller holds
+   * the bucket's write latch.
+   *
+   * @param bucket the pinned and latched bucket page, whose chain is for the hash of key
+   * @param key the key to remove
+   * @param value the value to remove
+   * @return true if the pair was removed
+   */
+  bool ChainRemove(Page *bucket, const KeyType &key, const ValueType &value);
+
   /**
    * Performs insertion with an optional bucket splitting.
    *
@@ -161,12 +324,28 @@ class ExtendibleHashTable {
    */
   void Merge(Transaction *transaction, const KeyType &key, const ValueType &value);
 
+  /**
+   * Doubles the directory, unless another thread already did.
+   *
+   * @param transaction the current transaction
+   * @param global_depth the global depth the caller found too small
+   * @return false if the directory cannot grow any further
+   */
+  bool GrowDirectory(Transaction *transaction, uint32_t global_depth);
+
+  /**
+   * Halves the directory for as long as no bucket needs all of its entries.
+   *
+   * @param transaction the current transaction
+   */
+  void ShrinkDirectory(Transaction *transaction);
+
   // member variables
   page_id_t directory_page_id_;
   BufferPoolManager *buffer_pool_manager_;
   KeyComparator comparator_;
 
-  // Readers includes inserts and removes, writers are splits and merges
+  // Readers are all operations, writers are the changes of the global depth
   ReaderWriterLatch table_latch_;
   HashFunction<KeyType> hash_fn_;
 };
@@ -0,0 +1,180 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// hash_table_directory.h
+//
+// Identification: src/include/container/hash/hash_table_directory.h
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <unordered_map>
+#include <utility>
+
+#include "buffer/buffer_pool_manager.h"
+#include "common/macros.h"
+#include "storage/page/hash_table_directory_page.h"
+
+namespace bustub {
+
+/**
+ * The directory of an extendible hash table, which may span several pages.
+ *
+ * Up to DIRECTORY_ARRAY_SIZE entries live in the directory page itself, so small tables read their directory from a
+ * single page. Beyond that, the entries move to segment pages, reached through segment table pages whose ids the
+ * directory page holds:
+ *
+ *   directory page --> segment table pages --> segment pages --> entries
+ *
+ * A HashTableDirectory is a short-lived view of a directory page that the caller has pinned and latched. The latch of
+ * the directory page covers the whole directory: segment and segment table pages are only accessed under it and take
+ * no latches of their own. The view pins the segment pages it visits one at a time and unpins them when it is done.
+ *
+ * Visiting a segment fails if the buffer pool has no free frame for it. Reads of the entry then return INVALID_PAGE_ID
+ * or a local depth of 0, writes are dropped, and Failed tells the caller to give up the operation. A caller that
+ * modifies several entries first pins them all with PinEntries, so that it modifies either all of them or none.
+ */
+class HashTableDirectory {
+ public:
+  /**
+   * @param buffer_pool_manager the buffer pool manager of the hash table
+   * @param dir_page the pinned and latched directory page
+   */
+  HashTableDirectory(BufferPoolManager *buffer_pool_manager, HashTableDirectoryPage *dir_page);
+
+  ~HashTableDirectory();
+
+  DISALLOW_COPY_AND_MOVE(HashTableDirectory);
+
+  /** @return the largest global depth a directory can have: 27 with 4 KB pages */
+  static uint32_t MaxGlobalDepth();
+
+  /** @return the global depth of the directory */
+  uint32_t GetGlobalDepth() { return dir_page_->GetGlobalDepth(); }
+
+  /** @return mask of global_depth 1's and the rest 0's (with 1's from LSB upwards) */
+  uint32_t GetGlobalDepthMask() { return dir_page_->GetGlobalDepthMask(); }
+
+  /** @return the current directory size */
+  uint32_t Size() { return dir_page_->Size(); }
+
+  /** @return true if a page of the directory could not be fetched since the view was created */
+  bool Failed() const { return failed_; }
+
+  /**
+   * Pins the segments of the entries start, start + step, start + 2 * step, ... of the directory, so that accessing
+   * these entries cannot fail until the view goes or the global depth changes.
+   * @return false if a segment could not be fetched
+   */
+  bool PinEntries(uint32_t start, uint32_t step);
+
+  /** @return bucket page_id corresponding to bucket_idx, INVALID_PAGE_ID if its segment could not be fetched */
+  page_id_t GetBucketPageId(uint32_t bucket_idx);
+
+  /** Updates the directory index using a bucket index and page_id */
+  void SetBucketPageId(uint32_t bucket_idx, page_id_t bucket_page_id);
+
+  /** @return the local depth of the bucket at bucket_idx, 0 if its segment could not be fetched */
+  uint32_t GetLocalDepth(uint32_t bucket_idx);
+
+  /** Set the local depth of the bucket at bucket_idx to local_depth */
+  void SetLocalDepth(uint32_t bucket_idx, uint8_t local_depth);
+
+  /** Increment the local depth of the bucket at bucket_idx */
+  void IncrLocalDepth(uint32_t bucket_idx) { SetLocalDepth(bucket_idx, GetLocalDepth(bucket_idx) + 1); }
+
+  /** Decrement the local depth of the bucket at bucket_idx */
+  void DecrLocalDepth(uint32_t bucket_idx) { SetLocalDepth(bucket_idx, GetLocalDepth(bucket_idx) - 1); }
+
+  /** @return mask of local depth 1's and the rest 0's (with 1's from LSB upwards) */
+  uint32_t GetLocalDepthMask(uint32_t bucket_idx) { return (1U << GetLocalDepth(bucket_idx)) - 1; }
+
+  /** @return the bit the next split of the bucket at bucket_idx adds */
+  uint32_t GetLocalHighBit(uint32_t bucket_idx) { return 1U << GetLocalDepth(bucket_idx); }
+
+  /** @return the directory index of the split image of the bucket at bucket_idx */
+  uint32_t GetSplitImageIndex(uint32_t bucket_idx);
+
+  /** @return true if the directory can be shrunk */
+  bool CanShrink();
+
+  /**
+   * Doubles the directory, the new upper half mirroring the lower half.
+   * @return false if the directory is at its maximum size, or there was no frame for a segment, in which case the
+   * directory is unchanged
+   */
+  bool IncrGlobalDepth();
+
+  /**
+   * Halves the directory, releasing the segments it no longer needs. Only valid if CanShrink.
+   * @return false if there was no frame for a segment, in which case the directory is unchanged
+   */
+  bool DecrGlobalDepth();
+
+  /** Verifies the invariants of HashTableDirectoryPage::VerifyIntegrity over all entries. */
+  void VerifyIntegrity();
+
+ private:
+  /** @return true if the directory keeps its entries in segment pages */
+  bool IsSegmented() { return Size() > DIRECTORY_ARRAY_SIZE; }
+
+  /** @return the number of segments of a directory of size entries, 0 if it fits into the directory page */
+  static uint32_t NumSegments(uint32_t size);
+
+  /**
+   * @param bucket_idx a directory index of a segmented directory
+   * @param dirty whether the caller modifies the segment
+   * @return the segment of the entry, pinned until another segment is visited unless PinEntries pinned it; nullptr if
+   * it could not be fetched
+   */
+  HashTableDirectorySegmentPage *SegmentOf(uint32_t bucket_idx, bool dirty);
+
+  /** Unpins the segment visited last. */
+  void ReleaseSegment();
+
+  /** Unpins the segment visited last and those PinEntries pinned. */
+  void ReleaseSegments();
+
+  /** @return the pinned segment page at segment_idx, nullptr if no frame is free */
+  Page *FetchSegment(uint32_t segment_idx);
+
+  /** @return the page, which must exist; nullptr if no frame is free */
+  Page *Fetch(page_id_t page_id);
+
+  /**
+   * Copies the entries of a segmented directory of size entries to its upper half, which must have its segments.
+   * @return false if a segment could not be fetched
+   */
+  bool MirrorEntries(uint32_t size);
+
+  /**
+   * Creates the segments [from, to) and the segment tables they need.
+   * @return false if there was no frame for a page, in which case no page was created
+   */
+  bool AllocateSegments(uint32_t from, uint32_t to);
+
+  /** Deletes the segments and segment tables of a directory of size entries beyond those keep_size entries need. */
+  void FreeSegments(uint32_t keep_size, uint32_t size);
+
+  /**
+   * Counts the entries below size whose local depth is depth.
+   * @return false if a segment could not be fetched
+   */
+  bool CountEntriesAtDepth(uint32_t size, uint32_t depth, uint32_t *count);
+
+  BufferPoolManager *buffer_pool_manager_;
+  HashTableDirectoryPage *dir_page_;
+  /** The segment visited last, kept pinned for the accesses that follow. */
+  Page *segment_{nullptr};
+  uint32_t segment_idx_{0};
+  bool segment_dirty_{false};
+  /** Segments pinned by PinEntries, by index, and whether they were modified. */
+  std::unordered_map<uint32_t, std::pair<Page *, bool>> pinned_segments_;
+  bool failed_{false};
+};
+
+}  // namespace bustub
@@ -16,6 +16,7 @@
 #include <utility>
 #include <vector>
 
+#include "buffer/pin_cache.h"
 #include "catalog/catalog.h"
 #include "concurrency/transaction.h"
 #include "storage/page/tmp_tuple_page.h"
@@ -36,9 +37,23 @@ class ExecutorContext {
    */
   ExecutorContext(Transaction *transaction, Catalog *catalog, BufferPoolManager *bpm, TransactionManager *txn_mgr,
                   LockManager *lock_mgr)
-      : transaction_(transaction), catalog_{catalog}, bpm_{bpm}, txn_mgr_(txn_mgr), lock_mgr_(lock_mgr) {}
+      : transaction_(transaction),
+        catalog_{catalog},
+        bpm_{bpm},
+        txn_mgr_(txn_mgr),
+        lock_mgr_(lock_mgr),
+        pin_cache_(bpm) {
+    if (transaction_ != nullptr) {
+      transaction_->SetPinCache(&pin_cache_);
+    }
+  }
 
-  ~ExecutorContext() = default;
+  /** Detaches the pin cache from the transaction; destroying the cache then drops its pins. */
+  ~ExecutorContext() {
+    if (transaction_ != nullptr && transaction_->GetPinCache() == &pin_cache_) {
+      transaction_->SetPinCache(nullptr);
+    }
+  }
 
   DISALLOW_COPY_AND_MOVE(ExecutorContext);
 
@@ -51,6 +66,12 @@ class ExecutorContext {
   /** @return the buffer pool manager */
   BufferPoolManager *GetBufferPoolManager() { return bpm_; }
 
+  /**
+   * @return the pin cache for pages that the operations of this context fetch over and over, e.g. hash table
+   * directories. The context attaches it to its transaction, so that index operations run for the transaction find it.
+   */
+  PinCache *GetPinCache() { return &pin_cache_; }
+
   /** @return the log manager - don't worry about it for now */
   LogManager *GetLogManager() { return nullptr; }
 
@@ -71,6 +92,8 @@ class ExecutorContext {
   TransactionManager *txn_mgr_;
   /** The lock manager associated with this executor context */
   LockManager *lock_mgr_;
+  /** Keeps hot pages pinned across the operations of this context */
+  PinCache pin_cache_;
 };
 
 }  // namespace bustub
@@ -0,0 +1,194 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// async_disk_io.h
+//
+// Identification: src/include/storage/disk/async_disk_io.h
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <sys/types.h>
+#include <condition_variable>  // NOLINT
+#include <deque>
+#include <future>  // NOLINT
+#include <memory>
+#include <mutex>   // NOLINT
+#include <thread>  // NOLINT
+#include <utility>
+#include <vector>
+
+#include "common/config.h"
+#include "common/macros.h"
+
+struct io_uring_sqe;
+struct io_uring_cqe;
+
+namespace bustub {
+
+/**
+ * AsyncDiskIO reads and writes pages of files asynchronously, keeping up to a fixed number of I/Os in flight. A page
+ * I/O is submitted with SubmitRead or SubmitWrite and completes when the returned future becomes ready; the file must
+ * stay open and the page buffer valid until then. Reads past the end of a file complete successfully with zeroes.
+ */
+class AsyncDiskIO {
+ public:
+  /**
+   * Creates the best backend available: io_uring if the kernel allows it, a thread pool doing pread/pwrite otherwise.
+   * @param queue_depth maximum number of I/Os in flight; further submissions block until one completes
+   * @param use_io_uring false to always use the thread pool
+   */
+  static std::unique_ptr<AsyncDiskIO> Create(size_t queue_depth, bool use_io_uring = true);
+
+  /** Waits for the I/Os in flight to complete and stops the backend. */
+  virtual ~AsyncDiskIO() = default;
+
+  /**
+   * Submits a page read.
+   * @param fd the file to read from
+   * @param offset offset of the page in the file
+   * @param[out] page_data PAGE_SIZE bytes of output buffer
+   * @param file_ref released once the read completed, e.g. to keep fd open until then
+   * @return a future that becomes true once the page is read, false if the read failed
+   */
+  std::future<bool> SubmitRead(int fd, off_t offset, char *page_data, std::shared_ptr<void> file_ref = nullptr) {
+    return Submit(std::make_unique<Request>(Request{false, fd, offset, page_data, {}, std::move(file_ref)}));
+  }
+
+  /**
+   * Submits a page write.
+   * @param fd the file to write to
+   * @param offset offset of the page in the file
+   * @param page_data PAGE_SIZE bytes of page data
+   * @param file_ref released once the write completed, e.g. to keep fd open until then
+   * @return a future that becomes true once the page is written, false if the write failed
+   */
+  std::future<bool> SubmitWrite(int fd, off_t offset, const char *page_data, std::shared_ptr<void> file_ref = nullptr) {
+    return Submit(
+        std::make_unique<Request>(Request{true, fd, offset, const_cast<char *>(page_data), {}, std::move(file_ref)}));
+  }
+
+  /** @return the name of the backend */
+  virtual const char *GetName() const = 0;
+
+ protected:
+  struct Request {
+    bool is_write_;
+    int fd_;
+    off_t offset_;
+    char *data_;
+    std::promise<bool> promise_;
+    std::shared_ptr<void> file_ref_;
+  };
+
+  /** Starts a request and takes ownership of it. @return the future of its promise */
+  virtual std::future<bool> Submit(std::unique_ptr<Request> request) = 0;
+
+  /**
+   * Transfers the rest of a page with blocking pread/pwrite.
+   * @param request the request
+   * @param done number of bytes of the page already transferred
+   * @return true on success
+   */
+  static bool TransferSync(Request *request, size_t done);
+};
+
+/**
+ * ThreadPoolDiskIO runs page I/O on a pool of threads doing blocking pread/pwrite.
+ */
+class ThreadPoolDiskIO : public AsyncDiskIO {
+ public:
+  /**
+   * Starts the threads.
+   * @param queue_depth maximum number of queued and running requests
+   * @param num_threads number of I/O threads
+   */
+  ThreadPoolDiskIO(size_t queue_depth, size_t num_threads);
+
+  ~ThreadPoolDiskIO() override;
+
+  DISALLOW_COPY_AND_MOVE(ThreadPoolDiskIO);
+
+  const char *GetName() const override { return "thread pool"; }
+
+ protected:
+  std::future<bool> Submit(std::unique_ptr<Request> request) override;
+
+ private:
+  /** I/O thread body. */
+  void Run();
+
+  const size_t queue_depth_;
+  std::deque<std::unique_ptr<Request>> queue_;
+  /** Requests queued or running. */
+  size_t pending_{0};
+  bool shutdown_{false};
+  std::mutex latch_;
+  /** Signals I/O threads that queue_ is not empty, or shutdown. */
+  std::condition_variable queue_cv_;
+  /** Signals submitters that pending_ dropped below queue_depth_. */
+  std::condition_variable slot_cv_;
+  std::vector<std::thread> threads_;
+};
+
+/**
+ * IoUringDiskIO submits page I/O to an io_uring. Submitters fill the submission ring under a latch, and a reaper
+ * thread waits on the completion ring and completes the futures. The ring is driven through the raw system calls so
+ * that no liburing is needed.
+ */
+class IoUringDiskIO : public AsyncDiskIO {
+ public:
+  /**
+   * Sets up a ring.
+   * @param queue_depth maximum number of I/Os in flight
+   * @return the backend, nullptr if the kernel does not support or allow io_uring
+   */
+  static std::unique_ptr<IoUringDiskIO> Open(size_t queue_depth);
+
+  ~IoUringDiskIO() override;
+
+  DISALLOW_COPY_AND_MOVE(IoUringDiskIO);
+
+  const char *GetName() const override { return "io_uring"; }
+
+ protected:
+  std::future<bool> Submit(std::unique_ptr<Request> request) override;
+
+ private:
+  explicit IoUringDiskIO(size_t queue_depth) : queue_depth_(queue_depth) {}
+
+  /** Pushes one submission queue entry and submits it. Caller must hold latch_. */
+  void Push(uint8_t opcode, const Request *request, uint64_t user_data);
+
+  /** Reaper thread body. */
+  void Reap();
+
+  const size_t queue_depth_;
+  int ring_fd_{-1};
+  void *sq_ring_{nullptr};
+  size_t sq_ring_size_{0};
+  void *cq_ring_{nullptr};
+  size_t cq_ring_size_{0};
+  io_uring_sqe *sqes_{nullptr};
+  size_t sqes_size_{0};
+  unsigned *sq_tail_{nullptr};
+  unsigned sq_mask_{0};
+  unsigned *sq_array_{nullptr};
+  unsigned *cq_head_{nullptr};
+  unsigned *cq_tail_{nullptr};
+  unsigned cq_mask_{0};
+  io_uring_cqe *cqes_{nullptr};
+  /** Requests submitted and not yet reaped. */
+  size_t in_flight_{0};
+  /** Protects the submission ring and in_flight_. */
+  std::mutex latch_;
+  /** Signals submitters and the destructor that in_flight_ dropped. */
+  std::condition_variable slot_cv_;
+  std::thread reaper_;
+};
+
+}  // namespace bustub
@@ -0,0 +1,115 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// compressed_page_store.h
+//
+// Identification: src/include/storage/disk/compressed_page_store.h
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <cstdint>
+#include <mutex>  // NOLINT
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "common/config.h"
+#include "common/macros.h"
+
+namespace bustub {
+
+/**
+ * CompressedPageStore keeps pages compressed in a data file. Every page is compressed on its own and stored in an
+ * extent of one to eight slots of PAGE_SIZE / 8 bytes; a page that does not compress by at least a slot is stored raw.
+ * The page-id-to-extent map lives in memory and is persisted to a map file by Sync.
+ *
+ * A rewritten page always moves to a fresh extent, since the persisted map may still point to the old one along with
+ * its stored size. Extents given up by a move are only reused once a Sync has persisted the map that no longer points
+ * to them, so that a crash always leaves the persisted map pointing at the data it was written with.
+ */
+class CompressedPageStore {
+ public:
+  /**
+   * Opens a store, creating its files if they do not exist.
+   * @param data_file the file holding the compressed pages
+   * @param map_file the file holding the extent map
+   */
+  CompressedPageStore(const std::string &data_file, std::string map_file);
+
+  /** Closes the store without syncing it. */
+  ~CompressedPageStore();
+
+  DISALLOW_COPY_AND_MOVE(CompressedPageStore);
+
+  /**
+   * Compresses and writes a page.
+   * @param page_id id of the page
+   * @param page_data PAGE_SIZE bytes of page data
+   * @return false on an I/O error
+   */
+  bool WritePage(page_id_t page_id, const char *page_data);
+
+  /**
+   * Reads and decompresses a page. A page that was never written reads as zeroes.
+   * @param page_id id of the page
+   * @param[out] page_data PAGE_SIZE bytes of output buffer
+   */
+  void ReadPage(page_id_t page_id, char *page_data);
+
+  /**
+   * Persists the extent map and syncs both files.
+   * @return false on an I/O error, in which case the pages written since the last Sync are not durable
+   */
+  bool Sync();
+
+  /** Syncs and closes the files. */
+  void Close();
+
+  /** @return the number of bytes the stored pages take up on disk */
+  size_t GetStoredBytes();
+
+  /** @return the number of bytes the stored pages would take up uncompressed */
+  size_t GetLogicalBytes();
+
+  /** @return one past the highest page id ever written */
+  page_id_t GetEndPageId();
+
+  /** Size of an extent slot. */
+  static constexpr size_t SLOT_SIZE = PAGE_SIZE / 8;
+
+ private:
+  struct Extent {
+    /** Offset of the extent in the data file. */
+    uint64_t offset_;
+    /** Number of bytes stored; PAGE_SIZE means the page is stored raw. */
+    uint32_t stored_size_;
+    /** Size of the extent in slots, 0 if the page was never written. */
+    uint32_t num_slots_;
+  };
+
+  /** @return the offset of a free extent of num_slots slots. Caller must hold latch_. */
+  uint64_t AllocateExtent(uint32_t num_slots);
+
+  /** Reads the map file and rebuilds the free extents from the gaps between used ones. */
+  void LoadMap();
+
+  std::string map_file_;
+  int data_fd_{-1};
+  /** Extent of every page, indexed by page id. */
+  std::vector<Extent> extents_;
+  /** Offsets of free extents, indexed by their size in slots. */
+  std::vector<std::vector<uint64_t>> free_extents_;
+  /** Extents given up since the last Sync; see the class comment. */
+  std::vector<std::pair<uint64_t, uint32_t>> pending_free_extents_;
+  /** End of the used part of the data file. */
+  uint64_t end_offset_{0};
+  /** Protects everything above. */
+  std::mutex latch_;
+};
+
+}  // namespace bustub
@@ -12,27 +12,42 @@
 
 #pragma once
 
+#include <array>
 #include <atomic>
 #include <fstream>
 #include <future>  // NOLINT
+#include <memory>
 #include <mutex>   // NOLINT
 #include <string>
+#include <utility>
+#include <vector>
 
 #include "common/config.h"
+#include "storage/disk/async_disk_io.h"
+#include "storage/disk/compressed_page_store.h"
+#include "storage/disk/free_page_map.h"
+#include "storage/disk/tablespace.h"
 
 namespace bustub {
 
 /**
  * DiskManager takes care of the allocation and deallocation of pages within a database. It performs the reading and
  * writing of pages to and from disk, providing a logical file layer within the context of a database management system.
+ *
+ * The pages of a database live in tablespaces, each a file of its own: the default tablespace is the database file, and
+ * further ones can be created for e.g. a table and its indexes. A page id names the tablespace and the page within it
+ * (see tablespace.h), so callers address all pages alike.
  */
 class DiskManager {
  public:
   /**
    * Creates a new disk manager that writes to the specified database file.
    * @param db_file the file name of the database file to write to
+   * @param compress_pages whether pages are stored compressed, with their extent map kept next to the database file
+   * @param direct_io whether page I/O bypasses the OS page cache (O_DIRECT). Falls back to buffered I/O where the file
+   * system does not support it. Pages in memory not aligned to PAGE_SIZE are staged through an aligned buffer.
    */
-  explicit DiskManager(const std::string &db_file);
+  explicit DiskManager(const std::string &db_file, bool compress_pages = false, bool direct_io = false);
 
   ~DiskManager() = default;
 
@@ -45,8 +60,41 @@ class DiskManager {
    * Write a page to the database file.
    * @param page_id id of the page
    * @param page_data raw page data
+   * @return false on an I/O error
    */
-  void WritePage(page_id_t page_id, const char *page_data);
+  bool WritePage(page_id_t page_id, const char *page_data);
+
+  /**
+   * Write a batch of pages to the database file and sync it. Pages are written in page id order, and runs of adjacent
+   * pages are coalesced into single vectored writes, so that a checkpoint issues few large sequential writes. A failed
+   * write does not keep the other pages from being written and synced.
+   * @param[in,out] pages (page id, raw page data) of the pages to write; on return, the pages that were written and
+   * synced, sorted by page id
+   * @return false if some page was not written and synced
+   */
+  bool WritePages(std::vector<std::pair<page_id_t, const char *>> *pages);
+
+  /**
+   * Sync the database file, making all page writes so far durable. WritePage does not sync, so callers that need
+   * durability sync explicitly; WritePages syncs on its own. This is also the sync point of the free page map.
+   * @return false if some file could not be synced
+   */
+  bool Sync();
+
+  /**
+   * Allocate a page id, reusing a deallocated page where possible.
+   * @param stride with index, restricts the page id to one equal to index modulo stride
+   * @param index see stride
+   * @param space_id the tablespace to allocate the page in
+   * @return the id of the allocated page, INVALID_PAGE_ID if the tablespace does not exist or is full
+   */
+  page_id_t AllocatePage(uint32_t stride = 1, uint32_t index = 0, tablespace_id_t space_id = DEFAULT_TABLESPACE_ID);
+
+  /**
+   * Deallocate a page id. It is reused after the next sync point.
+   * @param page_id id of the page
+   */
+  void DeallocatePage(page_id_t page_id);
 
   /**
    * Read a page from the database file.
@@ -55,6 +103,47 @@ class DiskManager {
    */
   void ReadPage(page_id_t page_id, char *page_data);
 
+  /**
+   * Start reading a page from the database file. Unlike ReadPage, reads do not wait for each other, so concurrent
+   * callers keep several I/Os in flight. A page past the end of the file reads as zeroes.
+   * @param page_id id of the page
+   * @param[out] page_data output buffer, which must stay valid until the read completes
+   * @return a future that becomes true once the page is read, false if the read failed
+   */
+  std::future<bool> ReadPageAsync(page_id_t page_id, char *page_data);
+
+  /**
+   * Start writing a page to the database file.
+   * @param page_id id of the page
+   * @param page_data raw page data, which must stay valid until the write completes
+   * @return a future that becomes true once the page is written, false if the write failed
+   */
+  std::future<bool> WritePageAsync(page_id_t page_id, const char *page_data);
+
+  /** @return the backend of ReadPageAsync and WritePageAsync, started on first use */
+  AsyncDiskIO *GetAsyncIO();
+
+  /**
+   * Create a tablespace, with a data file of its own next to the database file.
+   * @return the id of the new tablespace, INVALID_TABLESPACE_ID if all ids are taken or the file cannot be created
+   */
+  tablespace_id_t CreateTablespace();
+
+  /**
+   * Drop a tablespace by unlinking its file, which releases all of its pages at once. The file is closed once the I/O
+   * on its pages still in flight is done. The buffer pool must not hold any of them (see
+   * BufferPoolManager::DiscardTablespace).
+   * @param space_id id of the tablespace
+   * @return false if the tablespace does not exist or is the default one
+   */
+  bool DropTablespace(tablespace_id_t space_id);
+
+  /**
+   * @param space_id id of the tablespace
+   * @return the name of the data file of the tablespace
+   */
+  std::string GetTablespaceFileName(tablespace_id_t space_id) const;
+
   /**
    * Flush the entire log buffer into disk.
    * @param log_data raw log data
@@ -89,20 +178,78 @@ class DiskManager {
   /** Checks if the non-blocking flush future was set. */
   inline bool HasFlushLogFuture() { return flush_log_f_ != nullptr; }
 
+  /** @return true iff page I/O bypasses the OS page cache */
+  inline bool IsDirectIO() const { return direct_io_; }
+
+  /**
+   * @param space_id id of the tablespace
+   * @return the map of allocated pages of the tablespace, nullptr if it does not exist
+   */
+  FreePageMap *GetFreePageMap(tablespace_id_t space_id = DEFAULT_TABLESPACE_ID);
+
+  /** @return the compressed page store, or nullptr if pages are stored raw */
+  inline CompressedPageStore *GetPageStore() { return page_store_.get(); }
+
  private:
+  /** A data file and the map of its allocated pages. */
+  struct Tablespace {
+    int fd_{-1};
+    std::unique_ptr<FreePageMap> free_page_map_;
+    /** One reference for being open plus one per page I/O on fd_; the last one to go closes fd_. */
+    std::atomic<uint32_t> refs_{1};
+  };
+
+  /** A reference to an open tablespace file, which keeps the file open until it goes. */
+  using FileRef = std::unique_ptr<Tablespace, void (*)(Tablespace *)>;
+
+  /** @return the tablespace, opening its file on first use; nullptr if it does not exist */
+  Tablespace *GetTablespace(tablespace_id_t space_id);
+
+  /** Opens the file of a tablespace other than the default one. Caller must hold spaces_latch_. */
+  std::unique_ptr<Tablespace> OpenTablespace(tablespace_id_t space_id, bool create);
+
+  /**
+   * Takes a reference to the file of a page's tablespace for an I/O, so that a concurrent DropTablespace does not
+   * close it under the I/O.
+   * @param page_id id of the page
+   * @param[out] offset offset of the page in its file
+   * @return a reference to the tablespace, empty if it does not exist or is being dropped
+   */
+  FileRef PinFile(page_id_t page_id, off_t *offset);
+
+  /** Drops a reference to a tablespace file, closing the file if it was the last one. */
+  static void UnpinFile(Tablespace *space);
+
+  /** @return true if the page goes through the compressed page store, which only holds the default tablespace */
+  inline bool IsCompressed(page_id_t page_id) const {
+    return page_store_ != nullptr && TablespaceOf(page_id) == DEFAULT_TABLESPACE_ID;
+  }
+
   int GetFileSize(const std::string &file_name);
   // stream to write log file
   std::fstream log_io_;
   std::string log_name_;
-  // stream to write db file
-  std::fstream db_io_;
+  // descriptor of the db file; page I/O is positional, so concurrent readers and writers need no latch
+  int db_fd_{-1};
+  bool direct_io_{false};
   std::string file_name_;
+  // db file name without its extension, which the names of the other files extend
+  std::string base_name_;
   int num_flushes_;
-  int num_writes_;
+  std::atomic<int> num_writes_;
   bool flush_log_;
   std::future<void> *flush_log_f_;
-  // With multiple buffer pool instances, need to protect file access
-  std::mutex db_io_latch_;
+  // set iff pages are stored compressed, in which case all page I/O of the default tablespace goes through it
+  std::unique_ptr<CompressedPageStore> page_store_;
+  // open tablespaces by id; page I/O looks them up without a latch
+  std::array<std::atomic<Tablespace *>, MAX_TABLESPACES> spaces_{};
+  // owns the tablespaces in spaces_, and the dropped ones, which a racing lookup or I/O may still use
+  std::vector<std::unique_ptr<Tablespace>> owned_spaces_;
+  // serializes opening, creating and dropping tablespaces
+  std::mutex spaces_latch_;
+  // backend of the async page I/O
+  std::unique_ptr<AsyncDiskIO> async_io_;
+  std::once_flag async_io_started_;
 };
 
 }  // namespace bustub
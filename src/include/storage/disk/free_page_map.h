@@ -0,0 +1,117 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// free_page_map.h
+//
+// Identification: src/include/storage/disk/free_page_map.h
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <functional>
+#include <mutex>  // NOLINT
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "common/config.h"
+#include "common/macros.h"
+
+namespace bustub {
+
+/**
+ * FreePageMap tracks which page ids of a database file are allocated, so that deallocated pages are reused instead of
+ * growing the file. It keeps one bit per page id below the end of the file, and persists the bitmap to a map file at
+ * sync points and on close. The map file also records the page size, so that a database is not opened by a build with
+ * a different one. Without a map file, every page of the database file counts as allocated.
+ *
+ * A deallocated page only becomes reusable after a sync point, and a map persisted by that sync point still shows it
+ * as allocated. A crash therefore never finds a page free while the synced data may still refer to it; at worst, a
+ * page deallocated shortly before the crash leaks.
+ */
+class FreePageMap {
+ public:
+  /**
+   * Creates a map.
+   * @param map_file the file the map is persisted to
+   * @param num_file_pages number of pages in the database file; 0 for a new database, which ignores a stale map file
+   */
+  FreePageMap(std::string map_file, page_id_t num_file_pages);
+
+  DISALLOW_COPY_AND_MOVE(FreePageMap);
+
+  /**
+   * Allocates a page id, reusing the lowest free one if there is any.
+   * @param stride with index, restricts the page ids to those equal to index modulo stride
+   * @param index see stride
+   * @return the allocated page id
+   */
+  page_id_t Allocate(uint32_t stride, uint32_t index);
+
+  /**
+   * Deallocates a page id. It becomes reusable after the next sync point.
+   * @param page_id the page id; ignored if it is not allocated
+   */
+  void Deallocate(page_id_t page_id);
+
+  /**
+   * Runs a sync point: persists the map, syncs the data, and then makes the pages deallocated before it reusable.
+   * @param sync_data makes the writes to the database file so far durable
+   */
+  void Sync(const std::function<void()> &sync_data);
+
+  /** Persists the map, so that a restart finds the free pages again. */
+  void Close();
+
+  /** @return true if the page id is allocated, including deallocated pages that are not reusable yet */
+  bool IsAllocated(page_id_t page_id);
+
+  /** @return the number of page ids free for reuse */
+  size_t GetNumFreePages();
+
+  /** @return one past the highest page id ever allocated */
+  page_id_t GetEndPageId();
+
+ private:
+  /**
+   * Writes the bitmap to a temporary file and renames it over map_file_. Pages pending deallocation count as
+   * allocated. Caller must hold sync_latch_.
+   * @return false on an I/O error
+   */
+  bool Persist();
+
+  /**
+   * Splits the free page ids by their residue modulo a stride, the first time Allocate is called with it. From then on
+   * the split is kept up to date. Caller must hold latch_.
+   * @return the free page ids of each residue, indexed by residue
+   */
+  std::vector<std::set<page_id_t>> &FreePagesOf(uint32_t stride);
+
+  /** Makes a page id free, in free_pages_ and in every split of it. Caller must hold latch_. */
+  void AddFreePage(page_id_t page_id);
+
+  /** Takes a page id out of free_pages_ and every split of it. Caller must hold latch_. */
+  void RemoveFreePage(page_id_t page_id);
+
+  std::string map_file_;
+  /** Allocation bit of every page id below end_page_id_, indexed by page id. */
+  std::vector<bool> allocated_;
+  /** Page ids below end_page_id_ that are not allocated. */
+  std::set<page_id_t> free_pages_;
+  /** free_pages_ split by residue, for every stride other than 1 that Allocate was called with. */
+  std::unordered_map<uint32_t, std::vector<std::set<page_id_t>>> free_pages_by_residue_;
+  /** Page ids deallocated since the last sync point started. */
+  std::set<page_id_t> pending_free_pages_;
+  page_id_t end_page_id_{0};
+  /** Protects everything above. */
+  std::mutex latch_;
+  /** Serializes sync points. */
+  std::mutex sync_latch_;
+};
+
+}  // namespace bustub
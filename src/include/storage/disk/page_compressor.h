@@ -0,0 +1,47 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// page_compressor.h
+//
+// Identification: src/include/storage/disk/page_compressor.h
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <cstddef>
+
+namespace bustub {
+
+/**
+ * PageCompressor is a small LZ77 compressor in the style of the LZ4 block format: a stream of sequences, each a run of
+ * literal bytes followed by a back-reference of at least four bytes into the last 64 KB of output. It trades ratio for
+ * speed and is meant for page-sized blocks, where zeroed free space and repetitive integer columns compress well.
+ */
+class PageCompressor {
+ public:
+  /**
+   * Compresses a block.
+   * @param src the data to compress
+   * @param src_size size of src in bytes
+   * @param[out] dst the compressed data
+   * @param dst_capacity size of dst in bytes
+   * @return the size of the compressed data, 0 if it would not fit into dst_capacity bytes
+   */
+  static size_t Compress(const char *src, size_t src_size, char *dst, size_t dst_capacity);
+
+  /**
+   * Decompresses a block produced by Compress. Corrupt input is detected rather than read or written out of bounds.
+   * @param src the compressed data
+   * @param src_size size of the compressed data in bytes
+   * @param[out] dst the decompressed data
+   * @param dst_size the exact size of the decompressed data
+   * @return false if src is not a valid compressed block of dst_size bytes
+   */
+  static bool Decompress(const char *src, size_t src_size, char *dst, size_t dst_size);
+};
+
+}  // namespace bustub
@@ -0,0 +1,64 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// tablespace.h
+//
+// Identification: src/include/storage/disk/tablespace.h
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <limits>
+
+#include "common/config.h"
+
+namespace bustub {
+
+/**
+ * A page id names a page of a tablespace. Tablespace 0 is the database file itself and owns all page ids below
+ * FIRST_TABLESPACE_PAGE_ID, so the page ids of a database without tablespaces are plain page numbers, over almost the
+ * whole page id range. The other tablespaces split the top of the range: each owns TABLESPACE_MAX_PAGES page ids, whose
+ * low TABLESPACE_SHIFT bits number the page within the tablespace's file.
+ */
+static constexpr tablespace_id_t DEFAULT_TABLESPACE_ID = 0;
+
+/** Number of pages a tablespace other than the default one can hold. */
+static constexpr page_id_t TABLESPACE_MAX_PAGES = 1 << TABLESPACE_SHIFT;
+
+/** First page id of tablespace 1, and thus the number of pages the default tablespace can hold. */
+static constexpr page_id_t FIRST_TABLESPACE_PAGE_ID =
+    ((std::numeric_limits<page_id_t>::max() >> TABLESPACE_SHIFT) + 2 - MAX_TABLESPACES) << TABLESPACE_SHIFT;
+
+static_assert(FIRST_TABLESPACE_PAGE_ID > TABLESPACE_MAX_PAGES, "the tablespaces must leave the default one most ids");
+
+/** @return the tablespace of a page */
+inline tablespace_id_t TablespaceOf(page_id_t page_id) {
+  if (page_id < FIRST_TABLESPACE_PAGE_ID) {
+    return page_id < 0 ? INVALID_TABLESPACE_ID : DEFAULT_TABLESPACE_ID;
+  }
+  return ((page_id - FIRST_TABLESPACE_PAGE_ID) >> TABLESPACE_SHIFT) + 1;
+}
+
+/** @return the number of a page within its tablespace */
+inline page_id_t PageNumberOf(page_id_t page_id) {
+  return page_id < FIRST_TABLESPACE_PAGE_ID ? page_id : page_id & (TABLESPACE_MAX_PAGES - 1);
+}
+
+/** @return the id of page page_number of a tablespace */
+inline page_id_t MakePageId(tablespace_id_t space_id, page_id_t page_number) {
+  if (space_id == DEFAULT_TABLESPACE_ID) {
+    return page_number;
+  }
+  return FIRST_TABLESPACE_PAGE_ID + ((space_id - 1) << TABLESPACE_SHIFT) + page_number;
+}
+
+/** @return the number of pages a tablespace can hold */
+inline page_id_t TablespaceMaxPages(tablespace_id_t space_id) {
+  return space_id == DEFAULT_TABLESPACE_ID ? FIRST_TABLESPACE_PAGE_ID : TABLESPACE_MAX_PAGES;
+}
+
+}  // namespace bustub
@@ -15,6 +15,7 @@
 #include <map>
 #include <memory>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include "container/hash/extendible_hash_table.h"
@@ -39,6 +40,15 @@ class ExtendibleHashTableIndex : public Index {
 
   void ScanKey(const Tuple &key, std::vector<RID> *result, Transaction *transaction) override;
 
+  /**
+   * Fills a new, empty index with the entries of its table at once (see ExtendibleHashTable::BulkLoad). Falls back to
+   * inserting them one by one if the bulk load fails.
+   * @param entries the (key, RID) entries
+   * @param transaction the current transaction
+   * @return false if some entries could not be inserted at all
+   */
+  bool BulkLoad(const std::vector<std::pair<KeyType, RID>> &entries, Transaction *transaction);
+
  protected:
   // comparator for key
   KeyComparator comparator_;
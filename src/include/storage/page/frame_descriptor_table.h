@@ -0,0 +1,63 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// frame_descriptor_table.h
+//
+// Identification: src/include/storage/page/frame_descriptor_table.h
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <atomic>
+#include <memory>
+
+#include "common/config.h"
+#include "common/macros.h"
+
+namespace bustub {
+
+/**
+ * FrameDescriptorTable holds the book-keeping information of a buffer pool's frames as a struct of arrays: one dense
+ * array each for page ids, pin counts and dirty flags. Sweeps over the pool that only look at one of them, e.g. a
+ * flush looking for dirty pages, read contiguous memory instead of one cache line per frame.
+ */
+class FrameDescriptorTable {
+ public:
+  /**
+   * Creates a new FrameDescriptorTable with every frame empty.
+   * @param num_frames the number of frames
+   */
+  explicit FrameDescriptorTable(size_t num_frames)
+      : page_ids_(std::make_unique<std::atomic<page_id_t>[]>(num_frames)),
+        pin_counts_(std::make_unique<std::atomic<int>[]>(num_frames)),
+        dirty_(std::make_unique<std::atomic<bool>[]>(num_frames)) {
+    for (size_t i = 0; i < num_frames; i++) {
+      page_ids_[i] = INVALID_PAGE_ID;
+    }
+  }
+
+  DISALLOW_COPY_AND_MOVE(FrameDescriptorTable);
+
+  /**
+   * @return the id of the page in the frame, INVALID_PAGE_ID if the frame is empty. Lock-free fetches read it to check
+   * that a frame they pinned still holds their page, so it is published with release and read with acquire ordering.
+   */
+  inline std::atomic<page_id_t> &PageId(frame_id_t frame_id) { return page_ids_[frame_id]; }
+
+  /** @return the pin count of the frame */
+  inline std::atomic<int> &PinCount(frame_id_t frame_id) { return pin_counts_[frame_id]; }
+
+  /** @return the dirty flag of the frame */
+  inline std::atomic<bool> &Dirty(frame_id_t frame_id) { return dirty_[frame_id]; }
+
+ private:
+  std::unique_ptr<std::atomic<page_id_t>[]> page_ids_;
+  std::unique_ptr<std::atomic<int>[]> pin_counts_;
+  std::unique_ptr<std::atomic<bool>[]> dirty_;
+};
+
+}  // namespace bustub
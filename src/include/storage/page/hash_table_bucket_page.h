@@ -33,6 +33,14 @@ namespace bustub {
  *  The above format omits the space required for the occupied_ and
  *  readable_ arrays. More information is in storage/page/hash_table_page_defs.h.
  *
+ *  Each slot also has a one-byte fingerprint of its key in fingerprints_. Lookups compare the fingerprints of a
+ *  group of slots at once with SIMD instructions and only call the comparator on the slots whose fingerprint matches.
+ *
+ *  Pairs whose keys share a hash cannot be told apart by splitting the bucket. Once they fill half of it, all pairs
+ *  of that hash move to a chain of overflow pages, which are bucket pages as well: the bucket keeps the id of the
+ *  first overflow page and the hash of the pairs in the chain, and each overflow page the id of the next one. While a
+ *  bucket has a chain, it holds no pairs of the chain's hash itself.
+ *
  */
 template <typename KeyType, typename ValueType, typename KeyComparator>
 class HashTableBucketPage {
@@ -64,6 +72,32 @@ class HashTableBucketPage {
    */
   bool Remove(KeyType key, ValueType value, KeyComparator cmp);
 
+  /**
+   * @return true if the bucket holds the key and value
+   */
+  bool Contains(KeyType key, ValueType value, KeyComparator cmp) const;
+
+  /**
+   * @return the page_id of the first overflow page, INVALID_PAGE_ID if there is none
+   */
+  page_id_t GetOverflowPageId() const { return overflow_page_id_; }
+
+  /**
+   * @return the hash of the keys in the overflow pages
+   */
+  uint32_t GetOverflowHash() const { return overflow_hash_; }
+
+  /**
+   * Links the overflow pages to the bucket, or unlinks them if page_id is INVALID_PAGE_ID.
+   *
+   * @param page_id page_id of the first overflow page
+   * @param hash the hash of the keys in the overflow pages
+   */
+  void SetOverflow(page_id_t page_id, uint32_t hash) {
+    overflow_page_id_ = page_id;
+    overflow_hash_ = hash;
+  }
+
   /**
    * Gets the key at an index in the bucket.
    *
@@ -138,10 +172,26 @@ class HashTableBucketPage {
   void PrintBucket();
 
  private:
+  /**
+   * @return the fingerprint of a key, a hash of its bytes independent of the hash that picks the bucket
+   */
+  static uint8_t Fingerprint(const KeyType &key);
+
+  /**
+   * @param group_idx index of the first slot of a group of FINGERPRINT_GROUP_SIZE slots
+   * @param fingerprint the fingerprint to look for
+   * @return bitmap of the readable slots of the group with the fingerprint, bit i for slot group_idx + i
+   */
+  uint32_t MatchFingerprint(uint32_t group_idx, uint8_t fingerprint) const;
+
+  page_id_t overflow_page_id_;
+  uint32_t overflow_hash_;
   //  For more on BUCKET_ARRAY_SIZE see storage/page/hash_table_page_defs.h
   char occupied_[(BUCKET_ARRAY_SIZE - 1) / 8 + 1];
   // 0 if tombstone/brand new (never occupied), 1 otherwise.
   char readable_[(BUCKET_ARRAY_SIZE - 1) / 8 + 1];
+  // Fingerprint of the key in each slot, valid if the slot is readable.
+  uint8_t fingerprints_[BUCKET_ARRAY_SIZE];
   MappingType array_[0];
 };
 
@@ -17,6 +17,7 @@
 #include <cstdlib>
 #include <string>
 
+#include "common/config.h"
 #include "storage/index/generic_key.h"
 #include "storage/page/hash_table_page_defs.h"
 
@@ -28,8 +29,13 @@ namespace bustub {
  *
  * Directory format (size in byte):
  * --------------------------------------------------------------------------------------------
- * | LSN (4) | PageId(4) | GlobalDepth(4) | LocalDepths(512) | BucketPageIds(2048) | Free(1524)
+ * | LSN (4) | PageId(4) | GlobalDepth(4) | LocalDepths(512) | BucketPageIds(2048) |
  * --------------------------------------------------------------------------------------------
+ * | GlobalDepthEntries(4) | SegmentTablePageIds(1024) | Free(496)
+ * --------------------------------------------------------------------------------------------
+ *
+ * Up to DIRECTORY_ARRAY_SIZE entries live in this page. A larger directory keeps its entries in segment pages instead,
+ * see HashTableDirectory, and uses the fields after BucketPageIds.
  */
 class HashTableDirectoryPage {
  public:
@@ -118,6 +124,13 @@ class HashTableDirectoryPage {
    */
   void IncrGlobalDepth();
 
+  /**
+   * Set the global depth without touching the entries in this page, for directories kept in segment pages
+   *
+   * @param global_depth the new global depth
+   */
+  void SetGlobalDepth(uint32_t global_depth);
+
   /**
    * Decrement the global depth of the directory
    */
@@ -171,6 +184,30 @@ class HashTableDirectoryPage {
    */
   uint32_t GetLocalHighBit(uint32_t bucket_idx);
 
+  /**
+   * @return the number of entries whose local depth equals the global depth, kept for segmented directories only
+   */
+  uint32_t GetNumGlobalDepthEntries() const { return num_global_depth_entries_; }
+
+  /**
+   * @param num_entries the number of entries whose local depth equals the global depth
+   */
+  void SetNumGlobalDepthEntries(uint32_t num_entries) { num_global_depth_entries_ = num_entries; }
+
+  /**
+   * @param table_idx index of a segment table
+   * @return page_id of the segment table
+   */
+  page_id_t GetSegmentTablePageId(uint32_t table_idx) const { return segment_table_page_ids_[table_idx]; }
+
+  /**
+   * @param table_idx index of a segment table
+   * @param table_page_id page_id of the segment table
+   */
+  void SetSegmentTablePageId(uint32_t table_idx, page_id_t table_page_id) {
+    segment_table_page_ids_[table_idx] = table_page_id;
+  }
+
   /**
    * VerifyIntegrity
    *
@@ -192,6 +229,57 @@ class HashTableDirectoryPage {
   uint32_t global_depth_{0};
   uint8_t local_depths_[DIRECTORY_ARRAY_SIZE];
   page_id_t bucket_page_ids_[DIRECTORY_ARRAY_SIZE];
+  uint32_t num_global_depth_entries_;
+  page_id_t segment_table_page_ids_[DIRECTORY_ROOT_TABLE_SIZE];
 };
 
+static_assert(sizeof(HashTableDirectoryPage) <= PAGE_SIZE);
+
+/**
+ * Segment page of a directory larger than DIRECTORY_ARRAY_SIZE entries: the local depths and bucket page ids of
+ * DIRECTORY_SEGMENT_SIZE consecutive directory entries.
+ */
+class HashTableDirectorySegmentPage {
+ public:
+  HashTableDirectorySegmentPage() = delete;
+
+  /** @return bucket page_id of the entry at offset in the segment */
+  page_id_t GetBucketPageId(uint32_t offset) const { return bucket_page_ids_[offset]; }
+
+  /** Sets the bucket page_id of the entry at offset in the segment */
+  void SetBucketPageId(uint32_t offset, page_id_t bucket_page_id) { bucket_page_ids_[offset] = bucket_page_id; }
+
+  /** @return local depth of the entry at offset in the segment */
+  uint32_t GetLocalDepth(uint32_t offset) const { return local_depths_[offset]; }
+
+  /** Sets the local depth of the entry at offset in the segment */
+  void SetLocalDepth(uint32_t offset, uint8_t local_depth) { local_depths_[offset] = local_depth; }
+
+ private:
+  uint8_t local_depths_[DIRECTORY_SEGMENT_SIZE];
+  page_id_t bucket_page_ids_[DIRECTORY_SEGMENT_SIZE];
+};
+
+static_assert(sizeof(HashTableDirectorySegmentPage) <= PAGE_SIZE);
+
+/**
+ * Segment table page of a directory larger than DIRECTORY_ARRAY_SIZE entries: the page ids of DIRECTORY_TABLE_SIZE
+ * consecutive segments.
+ */
+class HashTableDirectoryTablePage {
+ public:
+  HashTableDirectoryTablePage() = delete;
+
+  /** @return page_id of the segment at offset in the table */
+  page_id_t GetSegmentPageId(uint32_t offset) const { return segment_page_ids_[offset]; }
+
+  /** Sets the page_id of the segment at offset in the table */
+  void SetSegmentPageId(uint32_t offset, page_id_t segment_page_id) { segment_page_ids_[offset] = segment_page_id; }
+
+ private:
+  page_id_t segment_page_ids_[DIRECTORY_TABLE_SIZE];
+};
+
+static_assert(sizeof(HashTableDirectoryTablePage) <= PAGE_SIZE);
+
 }  // namespace bustub
@@ -34,11 +34,21 @@
 #define HASH_TABLE_BUCKET_TYPE HashTableBucketPage<KeyType, ValueType, KeyComparator>
 #define DIRECTORY_ARRAY_SIZE 512
 
+/**
+ * A directory larger than DIRECTORY_ARRAY_SIZE entries is split into segment pages of DIRECTORY_SEGMENT_SIZE entries.
+ * Segment table pages hold the page ids of DIRECTORY_TABLE_SIZE segments each, and the directory page those of up to
+ * DIRECTORY_ROOT_TABLE_SIZE segment tables.
+ */
+#define DIRECTORY_SEGMENT_SIZE (PAGE_SIZE / 8)
+#define DIRECTORY_TABLE_SIZE (PAGE_SIZE / 4)
+#define DIRECTORY_ROOT_TABLE_SIZE 256
+
 /**
  * BUCKET_ARRAY_SIZE is the number of (key, value) pairs that can be stored in an extendible hashing bucket page.
  * It is an approximate calculation based on the size of MappingType (which is a std::pair of KeyType and ValueType).
- * For each key/value pair, we need two additional bits for occupied_ and readable_. 4 * (PAGE_SIZE - 4) / (4 * sizeof
- * (MappingType) + 1) = (PAGE_SIZE - 4)/(sizeof (MappingType) + 0.25) because 0.25 bytes = 2 bits is the space required
- * to maintain the occupied and readable flags for a key value pair.
+ * For each key/value pair, we need two additional bits for occupied_ and readable_ and a byte for its fingerprint.
+ * 4 * (PAGE_SIZE - 16) / (4 * sizeof (MappingType) + 5) = (PAGE_SIZE - 16)/(sizeof (MappingType) + 1.25) because 1.25
+ * bytes = 10 bits is the space required to maintain the flags and the fingerprint of a key value pair. The 16 bytes
+ * cover the overflow chain header, the rounding of the bitmaps and the alignment of the pairs.
  */
-#define BUCKET_ARRAY_SIZE (4 * PAGE_SIZE / (4 * sizeof(MappingType) + 1))
+#define BUCKET_ARRAY_SIZE (4 * (PAGE_SIZE - 16) / (4 * sizeof(MappingType) + 5))
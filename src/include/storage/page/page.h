@@ -12,11 +12,14 @@
 
 #pragma once
 
+#include <atomic>
 #include <cstring>
 #include <iostream>
+#include <memory>
 
 #include "common/config.h"
 #include "common/rwlatch.h"
+#include "storage/page/frame_descriptor_table.h"
 
 namespace bustub {
 
@@ -28,10 +31,17 @@ namespace bustub {
 class Page {
   // There is book-keeping information inside the page that should only be relevant to the buffer pool manager.
   friend class BufferPoolManagerInstance;
+  friend class PinCache;
 
  public:
-  /** Constructor. Zeros out the page data. */
-  Page() { ResetMemory(); }
+  /** Constructor for a page outside of the buffer pool. Allocates zeroed page data and its own descriptor. */
+  Page()
+      : owned_data_(std::make_unique<char[]>(PAGE_SIZE)),
+        owned_descriptor_(std::make_unique<FrameDescriptorTable>(1)),
+        data_(owned_data_.get()),
+        page_id_(owned_descriptor_->PageId(0)),
+        pin_count_(owned_descriptor_->PinCount(0)),
+        is_dirty_(owned_descriptor_->Dirty(0)) {}
 
   /** Default destructor. */
   ~Page() = default;
@@ -40,7 +50,7 @@ class Page {
   inline char *GetData() { return data_; }
 
   /** @return the page id of this page */
-  inline page_id_t GetPageId() { return page_id_; }
+  inline page_id_t GetPageId() { return page_id_.load(std::memory_order_acquire); }
 
   /** @return the pin count of this page */
   inline int GetPinCount() { return pin_count_; }
@@ -49,10 +59,18 @@ class Page {
   inline bool IsDirty() { return is_dirty_; }
 
   /** Acquire the page write latch. */
-  inline void WLatch() { rwlatch_.WLock(); }
+  inline void WLatch() {
+    rwlatch_.WLock();
+    // An odd version tells optimistic readers that a writer is active. Only the latch holder writes the version.
+    version_.store(version_.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+  }
 
   /** Release the page write latch. */
-  inline void WUnlatch() { rwlatch_.WUnlock(); }
+  inline void WUnlatch() {
+    version_.store(version_.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    rwlatch_.WUnlock();
+  }
 
   /** Acquire the page read latch. */
   inline void RLatch() { rwlatch_.RLock(); }
@@ -60,6 +78,28 @@ class Page {
   /** Release the page read latch. */
   inline void RUnlatch() { rwlatch_.RUnlock(); }
 
+  /**
+   * Starts an optimistic read of a pinned page. Unlike RLatch, this writes nothing, so concurrent readers do not
+   * contend for a cache line. Whatever is read from the page afterwards may be torn by a concurrent writer and must be
+   * bounds-checked before it is used to address the page, and it may only be trusted once ValidateOptimisticRead
+   * succeeds. On failure, retry or fall back to RLatch.
+   * @param[out] version the version to validate against
+   * @return false if a writer holds the latch right now
+   */
+  inline bool TryOptimisticRead(uint64_t *version) const {
+    *version = version_.load(std::memory_order_acquire);
+    return (*version & 1) == 0;
+  }
+
+  /**
+   * @param version the version returned by TryOptimisticRead
+   * @return true if no writer latched the page since TryOptimisticRead, i.e. everything read in between is consistent
+   */
+  inline bool ValidateOptimisticRead(uint64_t version) const {
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return version_.load(std::memory_order_relaxed) == version;
+  }
+
   /** @return the page LSN. */
   inline lsn_t GetLSN() { return *reinterpret_cast<lsn_t *>(GetData() + OFFSET_LSN); }
 
@@ -75,19 +115,40 @@ class Page {
   static constexpr size_t OFFSET_LSN = 4;
 
  private:
+  /**
+   * Constructor for a buffer pool frame, whose data lives in the buffer pool's frame arena and whose book-keeping
+   * information lives in the buffer pool's descriptor table.
+   * @param data PAGE_SIZE bytes of zeroed page data, not owned
+   * @param descriptors the descriptor table of the buffer pool
+   * @param frame_id the frame this page is
+   */
+  Page(char *data, FrameDescriptorTable *descriptors, frame_id_t frame_id)
+      : data_(data),
+        page_id_(descriptors->PageId(frame_id)),
+        pin_count_(descriptors->PinCount(frame_id)),
+        is_dirty_(descriptors->Dirty(frame_id)) {}
+
   /** Zeroes out the data that is held within the page. */
   inline void ResetMemory() { memset(data_, OFFSET_PAGE_START, PAGE_SIZE); }
 
-  /** The actual data that is stored within a page. */
-  char data_[PAGE_SIZE]{};
-  /** The ID of this page. */
-  page_id_t page_id_ = INVALID_PAGE_ID;
-  /** The pin count of this page. */
-  int pin_count_ = 0;
-  /** True if the page is dirty, i.e. it is different from its corresponding page on disk. */
-  bool is_dirty_ = false;
+  /** Page data and descriptor of a page outside of the buffer pool. */
+  std::unique_ptr<char[]> owned_data_;
+  std::unique_ptr<FrameDescriptorTable> owned_descriptor_;
+  /** The actual data that is stored within a page. Frames keep it apart from this book-keeping information. */
+  char *data_;
+  /** The ID of this page, in the descriptor table. Read by lock-free fetches, written under the instance latch. */
+  std::atomic<page_id_t> &page_id_;
+  /**
+   * The pin count of this page, in the descriptor table. Hit paths of the buffer pool pin and unpin without holding
+   * the instance latch.
+   */
+  std::atomic<int> &pin_count_;
+  /** True if the page is dirty, i.e. it is different from its corresponding page on disk. In the descriptor table. */
+  std::atomic<bool> &is_dirty_;
   /** Page latch. */
   ReaderWriterLatch rwlatch_;
+  /** Bumped when the write latch is taken and when it is released; odd while a writer holds it. */
+  std::atomic<uint64_t> version_{0};
 };
 
 }  // namespace bustub
@@ -122,6 +122,16 @@ class TablePage : public Page {
    */
   bool GetTuple(const RID &rid, Tuple *tuple, Transaction *txn, LockManager *lock_manager);
 
+  /**
+   * Read a tuple from a table without latching the page, see Page::TryOptimisticRead. Takes no tuple lock and never
+   * aborts, so the caller must already hold a lock on the tuple if it needs one.
+   * @param rid rid of the tuple to read
+   * @param[out] tuple the tuple that was read, untouched unless the tuple exists
+   * @param[out] exists whether the tuple exists, only set if the read was consistent
+   * @return false if a concurrent writer got in the way; retry or fall back to GetTuple under the read latch
+   */
+  bool TryGetTupleOptimistic(const RID &rid, Tuple *tuple, bool *exists);
+
   /** @return the rid of the first tuple in this page */
 
   /**
@@ -14,6 +14,7 @@
 
 #include "buffer/buffer_pool_manager.h"
 #include "recovery/log_manager.h"
+#include "storage/disk/tablespace.h"
 #include "storage/page/table_page.h"
 #include "storage/table/table_iterator.h"
 #include "storage/table/tuple.h"
@@ -46,9 +47,10 @@ class TableHeap {
    * @param lock_manager the lock manager
    * @param log_manager the log manager
    * @param txn the creating transaction
+   * @param space_id the tablespace the pages of the table are allocated in
    */
   TableHeap(BufferPoolManager *buffer_pool_manager, LockManager *lock_manager, LogManager *log_manager,
-            Transaction *txn);
+            Transaction *txn, tablespace_id_t space_id = DEFAULT_TABLESPACE_ID);
 
   /**
    * Insert a tuple into the table. If the tuple is too large (>= page_size), return false.
@@ -99,8 +101,14 @@ class TableHeap {
    */
   bool GetTuple(const RID &rid, Tuple *tuple, Transaction *txn);
 
-  /** @return the begin iterator of this table */
-  TableIterator Begin(Transaction *txn);
+  /**
+   * @param txn the transaction performing the scan
+   * @param strategy buffer access strategy for the pages the scan reads, nullptr = normal access
+   * @param read_ahead number of pages to prefetch ahead of the scan, 0 = no read-ahead. Prefetched pages are loaded
+   * outside of the strategy's ring.
+   * @return the begin iterator of this table
+   */
+  TableIterator Begin(Transaction *txn, BufferAccessStrategy *strategy = nullptr, size_t read_ahead = 0);
 
   /** @return the end iterator of this table */
   TableIterator End();
@@ -14,6 +14,7 @@
 
 #include <cassert>
 
+#include "buffer/buffer_access_strategy.h"
 #include "common/rid.h"
 #include "concurrency/transaction.h"
 #include "storage/table/tuple.h"
@@ -29,10 +30,16 @@ class TableIterator {
   friend class Cursor;
 
  public:
-  TableIterator(TableHeap *table_heap, RID rid, Transaction *txn);
+  TableIterator(TableHeap *table_heap, RID rid, Transaction *txn, BufferAccessStrategy *strategy = nullptr,
+                size_t read_ahead = 0);
 
   TableIterator(const TableIterator &other)
-      : table_heap_(other.table_heap_), tuple_(new Tuple(*other.tuple_)), txn_(other.txn_) {}
+      : table_heap_(other.table_heap_),
+        tuple_(new Tuple(*other.tuple_)),
+        txn_(other.txn_),
+        strategy_(other.strategy_),
+        read_ahead_(other.read_ahead_),
+        pages_until_read_ahead_(other.pages_until_read_ahead_) {}
 
   ~TableIterator() { delete tuple_; }
 
@@ -52,13 +59,25 @@ class TableIterator {
     table_heap_ = other.table_heap_;
     *tuple_ = *other.tuple_;
     txn_ = other.txn_;
+    strategy_ = other.strategy_;
+    read_ahead_ = other.read_ahead_;
+    pages_until_read_ahead_ = other.pages_until_read_ahead_;
     return *this;
   }
 
  private:
+  /** Asks the buffer pool to prefetch the read_ahead_ pages that follow page_id. */
+  void ReadAhead(page_id_t page_id);
+
   TableHeap *table_heap_;
   Tuple *tuple_;
   Transaction *txn_;
+  /** Buffer access strategy of the scan, not owned. nullptr = normal access. */
+  BufferAccessStrategy *strategy_;
+  /** Number of pages to prefetch ahead of the scan, 0 = no read-ahead. */
+  size_t read_ahead_;
+  /** Pages left to scan before the next read-ahead is issued. */
+  size_t pages_until_read_ahead_{0};
 };
 
 }  // namespace bustub
@@ -0,0 +1,273 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// async_disk_io.cpp
+//
+// Identification: src/storage/disk/async_disk_io.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "storage/disk/async_disk_io.h"
+
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <utility>
+
+#include "common/logger.h"
+
+namespace bustub {
+
+std::unique_ptr<AsyncDiskIO> AsyncDiskIO::Create(size_t queue_depth, bool use_io_uring) {
+  if (use_io_uring) {
+    auto io_uring = IoUringDiskIO::Open(queue_depth);
+    if (io_uring != nullptr) {
+      return io_uring;
+    }
+  }
+  return std::make_unique<ThreadPoolDiskIO>(queue_depth, std::min<size_t>(queue_depth, ASYNC_IO_THREADS));
+}
+
+bool AsyncDiskIO::TransferSync(Request *request, size_t done) {
+  int fd = request->fd_;
+  off_t offset = request->offset_;
+  while (done < PAGE_SIZE) {
+    ssize_t count = request->is_write_ ? pwrite(fd, request->data_ + done, PAGE_SIZE - done, offset + done)
+                                       : pread(fd, request->data_ + done, PAGE_SIZE - done, offset + done);
+    if (count < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      LOG_DEBUG("I/O error at offset %ld", static_cast<int64_t>(offset));
+      return false;
+    }
+    if (count == 0 && !request->is_write_) {
+      // the file ends before the page does
+      memset(request->data_ + done, 0, PAGE_SIZE - done);
+      return true;
+    }
+    done += count;
+  }
+  return true;
+}
+
+/*
+ * ThreadPoolDiskIO
+ */
+
+ThreadPoolDiskIO::ThreadPoolDiskIO(size_t queue_depth, size_t num_threads) : queue_depth_(queue_depth) {
+  for (size_t i = 0; i < num_threads; i++) {
+    threads_.emplace_back(&ThreadPoolDiskIO::Run, this);
+  }
+}
+
+ThreadPoolDiskIO::~ThreadPoolDiskIO() {
+  {
+    std::scoped_lock lock(latch_);
+    shutdown_ = true;
+  }
+  queue_cv_.notify_all();
+  for (auto &thread : threads_) {
+    thread.join();
+  }
+}
+
+std::future<bool> ThreadPoolDiskIO::Submit(std::unique_ptr<Request> request) {
+  auto future = request->promise_.get_future();
+  {
+    std::unique_lock lock(latch_);
+    slot_cv_.wait(lock, [&] { return pending_ < queue_depth_; });
+    pending_++;
+    queue_.push_back(std::move(request));
+  }
+  queue_cv_.notify_one();
+  return future;
+}
+
+void ThreadPoolDiskIO::Run() {
+  while (true) {
+    std::unique_ptr<Request> request;
+    {
+      std::unique_lock lock(latch_);
+      // queued requests are still served on shutdown, since someone may be waiting for them
+      queue_cv_.wait(lock, [&] { return shutdown_ || !queue_.empty(); });
+      if (queue_.empty()) {
+        return;
+      }
+      request = std::move(queue_.front());
+      queue_.pop_front();
+    }
+    request->promise_.set_value(TransferSync(request.get(), 0));
+    {
+      std::scoped_lock lock(latch_);
+      pending_--;
+    }
+    slot_cv_.notify_one();
+  }
+}
+
+/*
+ * IoUringDiskIO
+ */
+
+static int IoUringEnter(int ring_fd, unsigned to_submit, unsigned min_complete, unsigned flags) {
+  return static_cast<int>(syscall(__NR_io_uring_enter, ring_fd, to_submit, min_complete, flags, nullptr, 0));
+}
+
+std::unique_ptr<IoUringDiskIO> IoUringDiskIO::Open(size_t queue_depth) {
+  std::unique_ptr<IoUringDiskIO> io(new IoUringDiskIO(queue_depth));
+  io_uring_params params;
+  memset(&params, 0, sizeof(params));
+  io->ring_fd_ = static_cast<int>(syscall(__NR_io_uring_setup, static_cast<unsigned>(queue_depth), &params));
+  if (io->ring_fd_ < 0) {
+    LOG_DEBUG("io_uring is not available: %s", strerror(errno));
+    return nullptr;
+  }
+
+  // The submission and completion rings share one mapping on kernels that support it.
+  io->sq_ring_size_ = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+  io->cq_ring_size_ = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+  bool single_mmap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+  if (single_mmap) {
+    io->sq_ring_size_ = std::max(io->sq_ring_size_, io->cq_ring_size_);
+  }
+  io->sq_ring_ = mmap(nullptr, io->sq_ring_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, io->ring_fd_,
+                      IORING_OFF_SQ_RING);
+  if (io->sq_ring_ == MAP_FAILED) {
+    io->sq_ring_ = nullptr;
+    return nullptr;
+  }
+  if (single_mmap) {
+    io->cq_ring_ = io->sq_ring_;
+    io->cq_ring_size_ = 0;
+  } else {
+    io->cq_ring_ = mmap(nullptr, io->cq_ring_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, io->ring_fd_,
+                        IORING_OFF_CQ_RING);
+    if (io->cq_ring_ == MAP_FAILED) {
+      io->cq_ring_ = nullptr;
+      return nullptr;
+    }
+  }
+  io->sqes_size_ = params.sq_entries * sizeof(io_uring_sqe);
+  void *sqes =
+      mmap(nullptr, io->sqes_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, io->ring_fd_, IORING_OFF_SQES);
+  if (sqes == MAP_FAILED) {
+    return nullptr;
+  }
+  io->sqes_ = static_cast<io_uring_sqe *>(sqes);
+
+  auto *sq_ring = static_cast<char *>(io->sq_ring_);
+  auto *cq_ring = static_cast<char *>(io->cq_ring_);
+  io->sq_tail_ = reinterpret_cast<unsigned *>(sq_ring + params.sq_off.tail);
+  io->sq_mask_ = *reinterpret_cast<unsigned *>(sq_ring + params.sq_off.ring_mask);
+  io->sq_array_ = reinterpret_cast<unsigned *>(sq_ring + params.sq_off.array);
+  io->cq_head_ = reinterpret_cast<unsigned *>(cq_ring + params.cq_off.head);
+  io->cq_tail_ = reinterpret_cast<unsigned *>(cq_ring + params.cq_off.tail);
+  io->cq_mask_ = *reinterpret_cast<unsigned *>(cq_ring + params.cq_off.ring_mask);
+  io->cqes_ = reinterpret_cast<io_uring_cqe *>(cq_ring + params.cq_off.cqes);
+  io->reaper_ = std::thread(&IoUringDiskIO::Reap, io.get());
+  return io;
+}
+
+IoUringDiskIO::~IoUringDiskIO() {
+  if (reaper_.joinable()) {
+    std::unique_lock lock(latch_);
+    slot_cv_.wait(lock, [&] { return in_flight_ == 0; });
+    // a no-op without a request tells the reaper to stop
+    Push(IORING_OP_NOP, nullptr, 0);
+    lock.unlock();
+    reaper_.join();
+  }
+  if (sqes_ != nullptr) {
+    munmap(sqes_, sqes_size_);
+  }
+  if (cq_ring_ != nullptr && cq_ring_ != sq_ring_) {
+    munmap(cq_ring_, cq_ring_size_);
+  }
+  if (sq_ring_ != nullptr) {
+    munmap(sq_ring_, sq_ring_size_);
+  }
+  if (ring_fd_ >= 0) {
+    close(ring_fd_);
+  }
+}
+
+std::future<bool> IoUringDiskIO::Submit(std::unique_ptr<Request> request) {
+  auto future = request->promise_.get_future();
+  std::unique_lock lock(latch_);
+  // The ring has at least queue_depth_ entries, so it never overflows.
+  slot_cv_.wait(lock, [&] { return in_flight_ < queue_depth_; });
+  in_flight_++;
+  Request *raw_request = request.release();
+  Push(raw_request->is_write_ ? IORING_OP_WRITE : IORING_OP_READ, raw_request,
+       reinterpret_cast<uint64_t>(raw_request));
+  return future;
+}
+
+void IoUringDiskIO::Push(uint8_t opcode, const Request *request, uint64_t user_data) {
+  // Only submitters write the tail, and they hold latch_.
+  unsigned tail = *sq_tail_;
+  unsigned index = tail & sq_mask_;
+  io_uring_sqe *sqe = &sqes_[index];
+  memset(sqe, 0, sizeof(*sqe));
+  sqe->opcode = opcode;
+  sqe->fd = -1;
+  if (request != nullptr) {
+    sqe->fd = request->fd_;
+    sqe->off = static_cast<uint64_t>(request->offset_);
+    sqe->addr = reinterpret_cast<uint64_t>(request->data_);
+    sqe->len = PAGE_SIZE;
+  }
+  sqe->user_data = user_data;
+  sq_array_[index] = index;
+  // The kernel must see the entry before the tail that publishes it.
+  __atomic_store_n(sq_tail_, tail + 1, __ATOMIC_RELEASE);
+  while (IoUringEnter(ring_fd_, 1, 0, 0) < 0) {
+    if (errno != EINTR && errno != EAGAIN && errno != EBUSY) {
+      // the entry stays in the ring and goes out with the next submission
+      LOG_DEBUG("io_uring_enter failed: %s", strerror(errno));
+      break;
+    }
+  }
+}
+
+void IoUringDiskIO::Reap() {
+  while (true) {
+    // Only the reaper writes the head.
+    unsigned head = *cq_head_;
+    if (head == __atomic_load_n(cq_tail_, __ATOMIC_ACQUIRE)) {
+      IoUringEnter(ring_fd_, 0, 1, IORING_ENTER_GETEVENTS);
+      continue;
+    }
+    io_uring_cqe cqe = cqes_[head & cq_mask_];
+    __atomic_store_n(cq_head_, head + 1, __ATOMIC_RELEASE);
+    if (cqe.user_data == 0) {
+      return;
+    }
+
+    std::unique_ptr<Request> request(reinterpret_cast<Request *>(cqe.user_data));
+    bool ok;
+    if (cqe.res < 0) {
+      LOG_DEBUG("I/O error at offset %ld: %s", static_cast<int64_t>(request->offset_), strerror(-cqe.res));
+      ok = false;
+    } else {
+      // finish short transfers, including reads at the end of the file, synchronously
+      ok = TransferSync(request.get(), cqe.res);
+    }
+    request->promise_.set_value(ok);
+    {
+      std::scoped_lock lock(latch_);
+      in_flight_--;
+    }
+    slot_cv_.notify_all();
+  }
+}
+
+}  // namespace bustub
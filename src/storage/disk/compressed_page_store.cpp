@@ -0,0 +1,271 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// compressed_page_store.cpp
+//
+// Identification: src/storage/disk/compressed_page_store.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "storage/disk/compressed_page_store.h"
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <utility>
+
+#include "common/exception.h"
+#include "common/logger.h"
+#include "storage/disk/page_compressor.h"
+
+namespace bustub {
+
+static constexpr uint32_t MAP_MAGIC = 0x42545043;  // "CPTB"
+static constexpr uint32_t MAX_EXTENT_SLOTS = PAGE_SIZE / CompressedPageStore::SLOT_SIZE;
+
+/** Header of the map file, followed by one Extent per page. */
+struct MapHeader {
+  uint32_t magic_;
+  uint32_t page_size_;
+  uint64_t num_pages_;
+};
+
+/** Writes all of buf at offset, retrying short writes. @return false on an I/O error */
+static bool WriteFully(int fd, const char *buf, size_t size, off_t offset) {
+  while (size > 0) {
+    ssize_t written = pwrite(fd, buf, size, offset);
+    if (written < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      return false;
+    }
+    buf += written;
+    size -= written;
+    offset += written;
+  }
+  return true;
+}
+
+/** Makes a rename within the directory of a file durable. @return false on an I/O error */
+static bool SyncDirectoryOf(const std::string &file) {
+  size_t slash = file.rfind('/');
+  std::string dir = slash == std::string::npos ? "." : file.substr(0, slash + 1);
+  int fd = open(dir.c_str(), O_RDONLY | O_DIRECTORY);
+  if (fd < 0) {
+    return false;
+  }
+  bool ok = fsync(fd) == 0;
+  close(fd);
+  return ok;
+}
+
+/** Reads size bytes at offset, zero-filling whatever lies beyond the end of the file. @return false on an I/O error */
+static bool ReadFully(int fd, char *buf, size_t size, off_t offset) {
+  while (size > 0) {
+    ssize_t read_count = pread(fd, buf, size, offset);
+    if (read_count < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      return false;
+    }
+    if (read_count == 0) {
+      memset(buf, 0, size);
+      return true;
+    }
+    buf += read_count;
+    size -= read_count;
+    offset += read_count;
+  }
+  return true;
+}
+
+CompressedPageStore::CompressedPageStore(const std::string &data_file, std::string map_file)
+    : map_file_(std::move(map_file)), free_extents_(MAX_EXTENT_SLOTS + 1) {
+  data_fd_ = open(data_file.c_str(), O_RDWR | O_CREAT, 0644);
+  if (data_fd_ < 0) {
+    throw Exception("can't open compressed page file");
+  }
+  LoadMap();
+}
+
+CompressedPageStore::~CompressedPageStore() {
+  if (data_fd_ >= 0) {
+    close(data_fd_);
+  }
+}
+
+bool CompressedPageStore::WritePage(page_id_t page_id, const char *page_data) {
+  // Only worth it if the page saves at least one slot.
+  char compressed[PAGE_SIZE];
+  size_t stored_size = PageCompressor::Compress(page_data, PAGE_SIZE, compressed, PAGE_SIZE - SLOT_SIZE);
+  const char *stored = compressed;
+  if (stored_size == 0) {
+    stored_size = PAGE_SIZE;
+    stored = page_data;
+  }
+  auto num_slots = static_cast<uint32_t>((stored_size + SLOT_SIZE - 1) / SLOT_SIZE);
+
+  std::scoped_lock lock(latch_);
+  if (static_cast<size_t>(page_id) >= extents_.size()) {
+    extents_.resize(page_id + 1, Extent{0, 0, 0});
+  }
+  Extent &extent = extents_[page_id];
+  // Never overwrite in place, not even with as many slots: after a crash, the persisted map would pair the new data
+  // with the old stored size.
+  if (extent.num_slots_ != 0) {
+    pending_free_extents_.emplace_back(extent.offset_, extent.num_slots_);
+  }
+  extent = Extent{AllocateExtent(num_slots), static_cast<uint32_t>(stored_size), num_slots};
+  if (!WriteFully(data_fd_, stored, stored_size, static_cast<off_t>(extent.offset_))) {
+    LOG_DEBUG("I/O error while writing");
+    return false;
+  }
+  return true;
+}
+
+void CompressedPageStore::ReadPage(page_id_t page_id, char *page_data) {
+  Extent extent{0, 0, 0};
+  {
+    std::scoped_lock lock(latch_);
+    if (static_cast<size_t>(page_id) < extents_.size()) {
+      extent = extents_[page_id];
+    }
+  }
+  if (extent.num_slots_ == 0) {
+    memset(page_data, 0, PAGE_SIZE);
+    return;
+  }
+  if (extent.stored_size_ == PAGE_SIZE) {
+    if (!ReadFully(data_fd_, page_data, PAGE_SIZE, static_cast<off_t>(extent.offset_))) {
+      LOG_DEBUG("I/O error while reading");
+    }
+    return;
+  }
+  char compressed[PAGE_SIZE];
+  if (!ReadFully(data_fd_, compressed, extent.stored_size_, static_cast<off_t>(extent.offset_)) ||
+      !PageCompressor::Decompress(compressed, extent.stored_size_, page_data, PAGE_SIZE)) {
+    LOG_DEBUG("I/O error while reading compressed page %d", page_id);
+    memset(page_data, 0, PAGE_SIZE);
+  }
+}
+
+bool CompressedPageStore::Sync() {
+  std::scoped_lock lock(latch_);
+  // The data must be durable before a map that points to it.
+  if (fsync(data_fd_) != 0) {
+    LOG_DEBUG("I/O error while syncing");
+    return false;
+  }
+  std::string tmp_file = map_file_ + ".tmp";
+  int map_fd = open(tmp_file.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  if (map_fd < 0) {
+    LOG_DEBUG("can't open page map file");
+    return false;
+  }
+  MapHeader header{MAP_MAGIC, PAGE_SIZE, extents_.size()};
+  bool ok = WriteFully(map_fd, reinterpret_cast<const char *>(&header), sizeof(header), 0) &&
+            WriteFully(map_fd, reinterpret_cast<const char *>(extents_.data()), extents_.size() * sizeof(Extent),
+                       sizeof(header)) &&
+            fsync(map_fd) == 0;
+  close(map_fd);
+  // Replacing the map is atomic, so a crash leaves either the old or the new one.
+  if (!ok || rename(tmp_file.c_str(), map_file_.c_str()) != 0 || !SyncDirectoryOf(map_file_)) {
+    LOG_DEBUG("I/O error while writing page map");
+    return false;
+  }
+  // Nothing persisted points to the extents given up before this sync any more.
+  for (const auto &[offset, num_slots] : pending_free_extents_) {
+    free_extents_[num_slots].push_back(offset);
+  }
+  pending_free_extents_.clear();
+  return true;
+}
+
+void CompressedPageStore::Close() {
+  if (data_fd_ < 0) {
+    return;
+  }
+  Sync();
+  std::scoped_lock lock(latch_);
+  close(data_fd_);
+  data_fd_ = -1;
+}
+
+size_t CompressedPageStore::GetStoredBytes() {
+  std::scoped_lock lock(latch_);
+  size_t bytes = 0;
+  for (const auto &extent : extents_) {
+    bytes += extent.num_slots_ * SLOT_SIZE;
+  }
+  return bytes;
+}
+
+size_t CompressedPageStore::GetLogicalBytes() {
+  std::scoped_lock lock(latch_);
+  return std::count_if(extents_.begin(), extents_.end(), [](const Extent &extent) { return extent.num_slots_ != 0; }) *
+         static_cast<size_t>(PAGE_SIZE);
+}
+
+page_id_t CompressedPageStore::GetEndPageId() {
+  std::scoped_lock lock(latch_);
+  return static_cast<page_id_t>(extents_.size());
+}
+
+uint64_t CompressedPageStore::AllocateExtent(uint32_t num_slots) {
+  auto &free_list = free_extents_[num_slots];
+  if (!free_list.empty()) {
+    uint64_t offset = free_list.back();
+    free_list.pop_back();
+    return offset;
+  }
+  uint64_t offset = end_offset_;
+  end_offset_ += num_slots * SLOT_SIZE;
+  return offset;
+}
+
+void CompressedPageStore::LoadMap() {
+  int map_fd = open(map_file_.c_str(), O_RDONLY);
+  if (map_fd < 0) {
+    return;
+  }
+  MapHeader header{};
+  bool ok = ReadFully(map_fd, reinterpret_cast<char *>(&header), sizeof(header), 0) && header.magic_ == MAP_MAGIC &&
+            header.page_size_ == PAGE_SIZE;
+  if (ok) {
+    extents_.resize(header.num_pages_);
+    ok = ReadFully(map_fd, reinterpret_cast<char *>(extents_.data()), extents_.size() * sizeof(Extent),
+                   sizeof(header));
+  }
+  close(map_fd);
+  if (!ok) {
+    throw Exception("corrupt page map file");
+  }
+
+  // Everything between used extents is free; hand it out in the largest extents that fit.
+  std::vector<std::pair<uint64_t, uint32_t>> used;
+  for (const auto &extent : extents_) {
+    if (extent.num_slots_ != 0) {
+      used.emplace_back(extent.offset_, extent.num_slots_);
+    }
+  }
+  std::sort(used.begin(), used.end());
+  for (const auto &[offset, num_slots] : used) {
+    while (end_offset_ < offset) {
+      auto gap_slots = static_cast<uint32_t>(std::min<uint64_t>((offset - end_offset_) / SLOT_SIZE, MAX_EXTENT_SLOTS));
+      free_extents_[gap_slots].push_back(end_offset_);
+      end_offset_ += gap_slots * SLOT_SIZE;
+    }
+    end_offset_ = offset + num_slots * SLOT_SIZE;
+  }
+}
+
+}  // namespace bustub
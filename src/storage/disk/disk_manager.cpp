@@ -10,11 +10,18 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include <fcntl.h>
 #include <sys/stat.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#include <algorithm>
 #include <cassert>
+#include <cerrno>
+#include <cstdint>
+#include <climits>
 #include <cstring>
 #include <iostream>
-#include <mutex>  // NOLINT
+#include <memory>
 #include <string>
 #include <thread>  // NOLINT
 
@@ -26,18 +33,30 @@ namespace bustub {
 
 static char *buffer_used;
 
+/** @return true if buf can be used for direct I/O as is */
+static bool IsAligned(const char *buf) { return reinterpret_cast<uintptr_t>(buf) % PAGE_SIZE == 0; }
+
+/** Aligned staging buffer for direct I/O of pages that live in unaligned memory. */
+static char *BounceBuffer() {
+  alignas(PAGE_SIZE) static thread_local char buffer[PAGE_SIZE];
+  return buffer;
+}
+
 /**
  * Constructor: open/create a single database file & log file
  * @input db_file: database file name
+ * @input compress_pages: whether to store pages compressed
+ * @input direct_io: whether to bypass the OS page cache for page I/O
  */
-DiskManager::DiskManager(const std::string &db_file)
+DiskManager::DiskManager(const std::string &db_file, bool compress_pages, bool direct_io)
     : file_name_(db_file), num_flushes_(0), num_writes_(0), flush_log_(false), flush_log_f_(nullptr) {
   std::string::size_type n = file_name_.rfind('.');
   if (n == std::string::npos) {
     LOG_DEBUG("wrong file format");
     return;
   }
-  log_name_ = file_name_.substr(0, n) + ".log";
+  base_name_ = file_name_.substr(0, n);
+  log_name_ = base_name_ + ".log";
 
   log_io_.open(log_name_, std::ios::binary | std::ios::in | std::ios::app | std::ios::out);
   // directory or file does not exist
@@ -53,20 +72,36 @@ DiskManager::DiskManager(const std::string &db_file)
     }
   }
 
-  std::scoped_lock scoped_db_io_latch(db_io_latch_);
-  db_io_.open(db_file, std::ios::binary | std::ios::in | std::ios::out);
-  // directory or file does not exist
-  if (!db_io_.is_open()) {
-    db_io_.clear();
-    // create a new file
-    db_io_.open(db_file, std::ios::binary | std::ios::trunc | std::ios::out);
-    db_io_.close();
-    // reopen with original mode
-    db_io_.open(db_file, std::ios::binary | std::ios::in | std::ios::out);
-    if (!db_io_.is_open()) {
-      throw Exception("can't open db file");
+  if (direct_io) {
+    db_fd_ = open(db_file.c_str(), O_RDWR | O_CREAT | O_DIRECT, 0644);
+    direct_io_ = db_fd_ >= 0;
+    if (!direct_io_) {
+      // e.g. tmpfs does not support O_DIRECT
+      LOG_DEBUG("direct I/O is not available, using buffered I/O");
     }
   }
+  if (db_fd_ < 0) {
+    db_fd_ = open(db_file.c_str(), O_RDWR | O_CREAT, 0644);
+  }
+  if (db_fd_ < 0) {
+    throw Exception("can't open db file");
+  }
+  if (compress_pages) {
+    page_store_ = std::make_unique<CompressedPageStore>(db_file, base_name_ + ".pmap");
+  }
+  page_id_t num_file_pages;
+  if (page_store_ != nullptr) {
+    num_file_pages = page_store_->GetEndPageId();
+  } else {
+    struct stat stat_buf;
+    num_file_pages = fstat(db_fd_, &stat_buf) == 0 ? static_cast<page_id_t>(stat_buf.st_size / PAGE_SIZE) : 0;
+  }
+  // the database file is the default tablespace; the others are opened on first use
+  auto space = std::make_unique<Tablespace>();
+  space->fd_ = db_fd_;
+  space->free_page_map_ = std::make_unique<FreePageMap>(base_name_ + ".fsm", num_file_pages);
+  spaces_[DEFAULT_TABLESPACE_ID] = space.get();
+  owned_spaces_.push_back(std::move(space));
   buffer_used = nullptr;
 }
 
@@ -74,58 +109,386 @@ DiskManager::DiskManager(const std::string &db_file)
  * Close all file streams
  */
 void DiskManager::ShutDown() {
+  // waits for the async I/O in flight
+  async_io_.reset();
+  if (page_store_ != nullptr) {
+    page_store_->Close();
+  }
   {
-    std::scoped_lock scoped_db_io_latch(db_io_latch_);
-    db_io_.close();
+    std::scoped_lock lock(spaces_latch_);
+    for (auto &space : spaces_) {
+      Tablespace *open_space = space.exchange(nullptr);
+      if (open_space != nullptr) {
+        open_space->free_page_map_->Close();
+        UnpinFile(open_space);
+      }
+    }
+    db_fd_ = -1;
   }
   log_io_.close();
 }
 
 /**
- * Write the contents of the specified page into disk file
+ * Write the contents of the specified page into disk file. The write reaches the OS at once and the disk at the next
+ * sync point.
  */
-void DiskManager::WritePage(page_id_t page_id, const char *page_data) {
-  std::scoped_lock scoped_db_io_latch(db_io_latch_);
-  size_t offset = static_cast<size_t>(page_id) * PAGE_SIZE;
-  // set write cursor to offset
+bool DiskManager::WritePage(page_id_t page_id, const char *page_data) {
   num_writes_ += 1;
-  db_io_.seekp(offset);
-  db_io_.write(page_data, PAGE_SIZE);
-  // check for I/O error
-  if (db_io_.bad()) {
-    LOG_DEBUG("I/O error while writing");
-    return;
+  if (IsCompressed(page_id)) {
+    return page_store_->WritePage(page_id, page_data);
   }
-  // needs to flush to keep disk file in sync
-  db_io_.flush();
+  off_t offset;
+  FileRef file = PinFile(page_id, &offset);
+  if (file == nullptr) {
+    LOG_DEBUG("I/O error while writing: no tablespace for page %d", page_id);
+    return false;
+  }
+  int fd = file->fd_;
+  if (direct_io_ && !IsAligned(page_data)) {
+    page_data = static_cast<const char *>(memcpy(BounceBuffer(), page_data, PAGE_SIZE));
+  }
+  size_t done = 0;
+  while (done < PAGE_SIZE) {
+    ssize_t written = pwrite(fd, page_data + done, PAGE_SIZE - done, offset + done);
+    if (written < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      LOG_DEBUG("I/O error while writing");
+      return false;
+    }
+    done += written;
+  }
+  return true;
 }
 
 /**
- * Read the contents of the specified page into the given memory area
+ * Write a batch of pages with one vectored write per run of adjacent pages, then sync the files once. A run that
+ * fails does not stop the others, and the ones that went out are synced either way.
  */
-void DiskManager::ReadPage(page_id_t page_id, char *page_data) {
-  std::scoped_lock scoped_db_io_latch(db_io_latch_);
-  int offset = page_id * PAGE_SIZE;
-  // check if read beyond file length
-  if (offset > GetFileSize(file_name_)) {
-    LOG_DEBUG("I/O error reading past end of file");
-    // std::cerr << "I/O error while reading" << std::endl;
+bool DiskManager::WritePages(std::vector<std::pair<page_id_t, const char *>> *pages) {
+  std::sort(pages->begin(), pages->end());
+  std::vector<std::pair<page_id_t, const char *>> written_pages;
+  written_pages.reserve(pages->size());
+  bool vectored = page_store_ == nullptr && (!direct_io_ || std::all_of(pages->begin(), pages->end(), [](auto &page) {
+                                               return IsAligned(page.second);
+                                             }));
+  if (!vectored) {
+    // compressed pages live at unrelated offsets, and unaligned pages need staging for direct I/O
+    for (const auto &page : *pages) {
+      if (WritePage(page.first, page.second)) {
+        written_pages.push_back(page);
+      }
+    }
   } else {
-    // set read cursor to offset
-    db_io_.seekp(offset);
-    db_io_.read(page_data, PAGE_SIZE);
-    if (db_io_.bad()) {
+    num_writes_ += static_cast<int>(pages->size());
+    std::vector<struct iovec> iov;
+    size_t begin = 0;
+    while (begin < pages->size()) {
+      // extend the run while page ids are consecutive within one tablespace
+      page_id_t first_page_id = (*pages)[begin].first;
+      size_t end = begin + 1;
+      while (end < pages->size() && end - begin < IOV_MAX && (*pages)[end].first == (*pages)[end - 1].first + 1 &&
+             TablespaceOf((*pages)[end].first) == TablespaceOf(first_page_id)) {
+        end++;
+      }
+      off_t offset;
+      FileRef file = PinFile(first_page_id, &offset);
+      if (file == nullptr) {
+        LOG_DEBUG("I/O error while writing: no tablespace for page %d", first_page_id);
+        begin = end;
+        continue;
+      }
+      iov.clear();
+      for (size_t i = begin; i < end; i++) {
+        iov.push_back({const_cast<char *>((*pages)[i].second), PAGE_SIZE});
+      }
+      struct iovec *next = iov.data();
+      int remaining = static_cast<int>(iov.size());
+      while (remaining > 0) {
+        ssize_t written = pwritev(file->fd_, next, remaining, offset);
+        if (written < 0) {
+          if (errno == EINTR) {
+            continue;
+          }
+          LOG_DEBUG("I/O error while writing");
+          break;
+        }
+        // skip the fully written buffers and trim a partially written one
+        offset += written;
+        while (remaining > 0 && static_cast<size_t>(written) >= next->iov_len) {
+          written -= next->iov_len;
+          next++;
+          remaining--;
+        }
+        if (remaining > 0) {
+          next->iov_base = static_cast<char *>(next->iov_base) + written;
+          next->iov_len -= written;
+        }
+      }
+      if (remaining == 0) {
+        written_pages.insert(written_pages.end(), pages->begin() + begin, pages->begin() + end);
+      }
+      begin = end;
+    }
+  }
+  if (!Sync()) {
+    // nothing is known to be durable
+    written_pages.clear();
+  }
+  bool all_written = written_pages.size() == pages->size();
+  pages->swap(written_pages);
+  return all_written;
+}
+
+/**
+ * Make all page writes so far durable
+ */
+bool DiskManager::Sync() {
+  std::scoped_lock lock(spaces_latch_);
+  bool synced = true;
+  for (tablespace_id_t space_id = 0; space_id < MAX_TABLESPACES; space_id++) {
+    Tablespace *space = spaces_[space_id].load();
+    if (space == nullptr) {
+      continue;
+    }
+    space->free_page_map_->Sync([&] {
+      if (space_id == DEFAULT_TABLESPACE_ID && page_store_ != nullptr) {
+        synced = page_store_->Sync() && synced;
+      } else if (fsync(space->fd_) != 0) {
+        LOG_DEBUG("I/O error while syncing");
+        synced = false;
+      }
+    });
+  }
+  return synced;
+}
+
+/**
+ * Allocate a page id from the free page map of a tablespace
+ */
+page_id_t DiskManager::AllocatePage(uint32_t stride, uint32_t index, tablespace_id_t space_id) {
+  Tablespace *space = GetTablespace(space_id);
+  if (space == nullptr) {
+    return INVALID_PAGE_ID;
+  }
+  // the page number must make up for the residue of the tablespace's first page id
+  page_id_t first_page_id = MakePageId(space_id, 0);
+  uint32_t page_number_index = (index + stride - static_cast<uint32_t>(first_page_id) % stride) % stride;
+  page_id_t page_number = space->free_page_map_->Allocate(stride, page_number_index);
+  if (page_number >= TablespaceMaxPages(space_id)) {
+    LOG_DEBUG("tablespace %d is full", space_id);
+    return INVALID_PAGE_ID;
+  }
+  return first_page_id + page_number;
+}
+
+/**
+ * Return a page id to the free page map of its tablespace
+ */
+void DiskManager::DeallocatePage(page_id_t page_id) {
+  Tablespace *space = GetTablespace(TablespaceOf(page_id));
+  if (space != nullptr) {
+    space->free_page_map_->Deallocate(PageNumberOf(page_id));
+  }
+}
+
+FreePageMap *DiskManager::GetFreePageMap(tablespace_id_t space_id) {
+  Tablespace *space = GetTablespace(space_id);
+  return space != nullptr ? space->free_page_map_.get() : nullptr;
+}
+
+/**
+ * Read the contents of the specified page into the given memory area. Reads share no file cursor, so they run in
+ * parallel with each other and with writes.
+ */
+void DiskManager::ReadPage(page_id_t page_id, char *page_data) {
+  if (IsCompressed(page_id)) {
+    page_store_->ReadPage(page_id, page_data);
+    return;
+  }
+  off_t offset;
+  FileRef file = PinFile(page_id, &offset);
+  if (file == nullptr) {
+    LOG_DEBUG("I/O error while reading: no tablespace for page %d", page_id);
+    memset(page_data, 0, PAGE_SIZE);
+    return;
+  }
+  int fd = file->fd_;
+  char *buf = direct_io_ && !IsAligned(page_data) ? BounceBuffer() : page_data;
+  size_t done = 0;
+  while (done < PAGE_SIZE) {
+    ssize_t read_count = pread(fd, buf + done, PAGE_SIZE - done, offset + done);
+    if (read_count < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
       LOG_DEBUG("I/O error while reading");
       return;
     }
-    // if file ends before reading PAGE_SIZE
-    int read_count = db_io_.gcount();
-    if (read_count < PAGE_SIZE) {
+    if (read_count == 0) {
+      // if file ends before reading PAGE_SIZE
       LOG_DEBUG("Read less than a page");
-      db_io_.clear();
-      // std::cerr << "Read less than a page" << std::endl;
-      memset(page_data + read_count, 0, PAGE_SIZE - read_count);
+      memset(buf + done, 0, PAGE_SIZE - done);
+      break;
+    }
+    done += read_count;
+  }
+  if (buf != page_data) {
+    memcpy(page_data, buf, PAGE_SIZE);
+  }
+}
+
+/**
+ * Start an asynchronous read of the specified page
+ */
+std::future<bool> DiskManager::ReadPageAsync(page_id_t page_id, char *page_data) {
+  off_t offset;
+  FileRef file = IsCompressed(page_id) ? FileRef(nullptr, UnpinFile) : PinFile(page_id, &offset);
+  if (file == nullptr || (direct_io_ && !IsAligned(page_data))) {
+    file.reset();
+    std::promise<bool> done;
+    ReadPage(page_id, page_data);
+    done.set_value(true);
+    return done.get_future();
+  }
+  int fd = file->fd_;
+  return GetAsyncIO()->SubmitRead(fd, offset, page_data, std::move(file));
+}
+
+/**
+ * Start an asynchronous write of the specified page
+ */
+std::future<bool> DiskManager::WritePageAsync(page_id_t page_id, const char *page_data) {
+  off_t offset;
+  FileRef file = IsCompressed(page_id) ? FileRef(nullptr, UnpinFile) : PinFile(page_id, &offset);
+  if (file == nullptr || (direct_io_ && !IsAligned(page_data))) {
+    file.reset();
+    std::promise<bool> done;
+    WritePage(page_id, page_data);
+    done.set_value(true);
+    return done.get_future();
+  }
+  num_writes_ += 1;
+  int fd = file->fd_;
+  return GetAsyncIO()->SubmitWrite(fd, offset, page_data, std::move(file));
+}
+
+AsyncDiskIO *DiskManager::GetAsyncIO() {
+  std::call_once(async_io_started_, [&] { async_io_ = AsyncDiskIO::Create(ASYNC_IO_QUEUE_DEPTH); });
+  return async_io_.get();
+}
+
+/**
+ * Create a tablespace under the lowest id that names no tablespace file yet
+ */
+tablespace_id_t DiskManager::CreateTablespace() {
+  std::scoped_lock lock(spaces_latch_);
+  for (tablespace_id_t space_id = 1; space_id < MAX_TABLESPACES; space_id++) {
+    if (spaces_[space_id].load() != nullptr) {
+      continue;
+    }
+    auto space = OpenTablespace(space_id, true);
+    if (space != nullptr) {
+      spaces_[space_id] = space.get();
+      owned_spaces_.push_back(std::move(space));
+      return space_id;
+    }
+    if (errno != EEXIST) {
+      LOG_DEBUG("can't create tablespace file: %s", strerror(errno));
+      return INVALID_TABLESPACE_ID;
+    }
+  }
+  return INVALID_TABLESPACE_ID;
+}
+
+/**
+ * Drop a tablespace, unlinking its data and map files
+ */
+bool DiskManager::DropTablespace(tablespace_id_t space_id) {
+  if (space_id <= DEFAULT_TABLESPACE_ID || space_id >= MAX_TABLESPACES) {
+    return false;
+  }
+  std::scoped_lock lock(spaces_latch_);
+  Tablespace *space = spaces_[space_id].load();
+  std::unique_ptr<Tablespace> opened;
+  if (space == nullptr) {
+    opened = OpenTablespace(space_id, false);
+    if (opened == nullptr) {
+      return false;
+    }
+    space = opened.get();
+  }
+  spaces_[space_id] = nullptr;
+  // I/O still in flight holds references of its own; the last one closes the file.
+  UnpinFile(space);
+  std::string file_name = GetTablespaceFileName(space_id);
+  unlink(file_name.c_str());
+  unlink((file_name + ".fsm").c_str());
+  return true;
+}
+
+std::string DiskManager::GetTablespaceFileName(tablespace_id_t space_id) const {
+  return space_id == DEFAULT_TABLESPACE_ID ? file_name_ : base_name_ + ".ts" + std::to_string(space_id);
+}
+
+DiskManager::Tablespace *DiskManager::GetTablespace(tablespace_id_t space_id) {
+  if (space_id < 0 || space_id >= MAX_TABLESPACES) {
+    return nullptr;
+  }
+  Tablespace *space = spaces_[space_id].load();
+  if (space != nullptr || space_id == DEFAULT_TABLESPACE_ID) {
+    return space;
+  }
+  std::scoped_lock lock(spaces_latch_);
+  space = spaces_[space_id].load();
+  if (space == nullptr) {
+    auto opened = OpenTablespace(space_id, false);
+    if (opened == nullptr) {
+      return nullptr;
     }
+    space = opened.get();
+    spaces_[space_id] = space;
+    owned_spaces_.push_back(std::move(opened));
+  }
+  return space;
+}
+
+std::unique_ptr<DiskManager::Tablespace> DiskManager::OpenTablespace(tablespace_id_t space_id, bool create) {
+  std::string file_name = GetTablespaceFileName(space_id);
+  int flags = O_RDWR | (create ? O_CREAT | O_EXCL : 0) | (direct_io_ ? O_DIRECT : 0);
+  int fd = open(file_name.c_str(), flags, 0644);
+  if (fd < 0) {
+    return nullptr;
+  }
+  struct stat stat_buf;
+  auto num_file_pages = fstat(fd, &stat_buf) == 0 ? static_cast<page_id_t>(stat_buf.st_size / PAGE_SIZE) : 0;
+  auto space = std::make_unique<Tablespace>();
+  space->fd_ = fd;
+  space->free_page_map_ = std::make_unique<FreePageMap>(file_name + ".fsm", num_file_pages);
+  return space;
+}
+
+DiskManager::FileRef DiskManager::PinFile(page_id_t page_id, off_t *offset) {
+  Tablespace *space = GetTablespace(TablespaceOf(page_id));
+  if (space == nullptr) {
+    return FileRef(nullptr, UnpinFile);
+  }
+  // A file whose last reference went is closed for good, so only take one while others are left.
+  uint32_t refs = space->refs_.load();
+  do {
+    if (refs == 0) {
+      return FileRef(nullptr, UnpinFile);
+    }
+  } while (!space->refs_.compare_exchange_weak(refs, refs + 1));
+  *offset = static_cast<off_t>(PageNumberOf(page_id)) * PAGE_SIZE;
+  return FileRef(space, UnpinFile);
+}
+
+void DiskManager::UnpinFile(Tablespace *space) {
+  if (space->refs_.fetch_sub(1) == 1) {
+    close(space->fd_);
+    space->fd_ = -1;
   }
 }
 
@@ -0,0 +1,211 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// free_page_map.cpp
+//
+// Identification: src/storage/disk/free_page_map.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "storage/disk/free_page_map.h"
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <cstdio>
+#include <fstream>
+#include <utility>
+
+#include "common/exception.h"
+#include "common/logger.h"
+
+namespace bustub {
+
+static constexpr uint32_t MAP_MAGIC = 0x4D534642;  // "BFSM"
+
+/** Makes a rename within the directory of a file durable. */
+static bool SyncDirectoryOf(const std::string &file) {
+  size_t slash = file.rfind('/');
+  std::string dir = slash == std::string::npos ? "." : file.substr(0, slash + 1);
+  int fd = open(dir.c_str(), O_RDONLY | O_DIRECTORY);
+  if (fd < 0) {
+    return false;
+  }
+  bool ok = fsync(fd) == 0;
+  close(fd);
+  return ok;
+}
+
+/** Header of the map file, followed by the allocation bitmap, eight page ids per byte. */
+struct FreePageMapHeader {
+  uint32_t magic_;
+  uint32_t page_size_;
+  page_id_t end_page_id_;
+};
+
+FreePageMap::FreePageMap(std::string map_file, page_id_t num_file_pages) : map_file_(std::move(map_file)) {
+  if (num_file_pages == 0) {
+    // the map of an earlier database of the same name
+    remove(map_file_.c_str());
+    return;
+  }
+  std::ifstream in(map_file_, std::ios::binary);
+  if (in.is_open()) {
+    FreePageMapHeader header{};
+    in.read(reinterpret_cast<char *>(&header), sizeof(header));
+    if (!in || header.magic_ != MAP_MAGIC || header.end_page_id_ < 0) {
+      throw Exception("corrupt free page map file");
+    }
+    if (header.page_size_ != PAGE_SIZE) {
+      throw Exception("database was created with a different page size");
+    }
+    std::vector<char> bitmap((header.end_page_id_ + 7) / 8);
+    in.read(bitmap.data(), bitmap.size());
+    if (!in) {
+      throw Exception("corrupt free page map file");
+    }
+    end_page_id_ = header.end_page_id_;
+    allocated_.resize(end_page_id_);
+    for (page_id_t page_id = 0; page_id < end_page_id_; page_id++) {
+      allocated_[page_id] = ((bitmap[page_id / 8] >> (page_id % 8)) & 1) != 0;
+      if (!allocated_[page_id]) {
+        AddFreePage(page_id);
+      }
+    }
+  }
+  // Pages written after the map was persisted are allocated.
+  if (num_file_pages > end_page_id_) {
+    end_page_id_ = num_file_pages;
+    allocated_.resize(end_page_id_, true);
+  }
+}
+
+page_id_t FreePageMap::Allocate(uint32_t stride, uint32_t index) {
+  std::scoped_lock lock(latch_);
+  const std::set<page_id_t> &candidates = stride == 1 ? free_pages_ : FreePagesOf(stride)[index];
+  if (!candidates.empty()) {
+    page_id_t page_id = *candidates.begin();
+    RemoveFreePage(page_id);
+    allocated_[page_id] = true;
+    return page_id;
+  }
+  // Extend the file; the page ids skipped on the way belong to others and are free for them.
+  page_id_t page_id = end_page_id_ + (index + stride - end_page_id_ % stride) % stride;
+  for (page_id_t skipped = end_page_id_; skipped < page_id; skipped++) {
+    AddFreePage(skipped);
+  }
+  end_page_id_ = page_id + 1;
+  allocated_.resize(end_page_id_);
+  allocated_[page_id] = true;
+  return page_id;
+}
+
+void FreePageMap::Deallocate(page_id_t page_id) {
+  std::scoped_lock lock(latch_);
+  if (page_id < 0 || page_id >= end_page_id_ || !allocated_[page_id]) {
+    return;
+  }
+  pending_free_pages_.insert(page_id);
+}
+
+void FreePageMap::Sync(const std::function<void()> &sync_data) {
+  std::scoped_lock sync_lock(sync_latch_);
+  std::set<page_id_t> releasing;
+  {
+    std::scoped_lock lock(latch_);
+    releasing.swap(pending_free_pages_);
+  }
+  // The map goes first, so that synced data never lives in a page the persisted map shows as free.
+  bool persisted = Persist();
+  sync_data();
+
+  std::scoped_lock lock(latch_);
+  if (!persisted) {
+    pending_free_pages_.insert(releasing.begin(), releasing.end());
+    return;
+  }
+  for (auto page_id : releasing) {
+    allocated_[page_id] = false;
+    AddFreePage(page_id);
+  }
+}
+
+void FreePageMap::Close() {
+  std::scoped_lock sync_lock(sync_latch_);
+  Persist();
+}
+
+bool FreePageMap::IsAllocated(page_id_t page_id) {
+  std::scoped_lock lock(latch_);
+  return page_id >= 0 && page_id < end_page_id_ && allocated_[page_id];
+}
+
+size_t FreePageMap::GetNumFreePages() {
+  std::scoped_lock lock(latch_);
+  return free_pages_.size();
+}
+
+page_id_t FreePageMap::GetEndPageId() {
+  std::scoped_lock lock(latch_);
+  return end_page_id_;
+}
+
+bool FreePageMap::Persist() {
+  std::vector<char> bitmap;
+  FreePageMapHeader header{MAP_MAGIC, PAGE_SIZE, 0};
+  {
+    std::scoped_lock lock(latch_);
+    header.end_page_id_ = end_page_id_;
+    bitmap.resize((end_page_id_ + 7) / 8);
+    for (page_id_t page_id = 0; page_id < end_page_id_; page_id++) {
+      if (allocated_[page_id]) {
+        bitmap[page_id / 8] |= static_cast<char>(1 << (page_id % 8));
+      }
+    }
+  }
+
+  std::string tmp_file = map_file_ + ".tmp";
+  FILE *out = fopen(tmp_file.c_str(), "wb");
+  if (out == nullptr) {
+    LOG_DEBUG("can't open free page map file");
+    return false;
+  }
+  bool ok = fwrite(&header, sizeof(header), 1, out) == 1 &&
+            (bitmap.empty() || fwrite(bitmap.data(), bitmap.size(), 1, out) == 1) && fflush(out) == 0 &&
+            fsync(fileno(out)) == 0;
+  ok = fclose(out) == 0 && ok;
+  // Replacing the map is atomic, so a crash leaves either the old or the new one.
+  if (!ok || rename(tmp_file.c_str(), map_file_.c_str()) != 0 || !SyncDirectoryOf(map_file_)) {
+    LOG_DEBUG("I/O error while writing free page map");
+    return false;
+  }
+  return true;
+}
+
+std::vector<std::set<page_id_t>> &FreePageMap::FreePagesOf(uint32_t stride) {
+  auto [it, inserted] = free_pages_by_residue_.try_emplace(stride, stride);
+  if (inserted) {
+    for (auto page_id : free_pages_) {
+      it->second[static_cast<uint32_t>(page_id) % stride].insert(page_id);
+    }
+  }
+  return it->second;
+}
+
+void FreePageMap::AddFreePage(page_id_t page_id) {
+  free_pages_.insert(page_id);
+  for (auto &[stride, residues] : free_pages_by_residue_) {
+    residues[static_cast<uint32_t>(page_id) % stride].insert(page_id);
+  }
+}
+
+void FreePageMap::RemoveFreePage(page_id_t page_id) {
+  free_pages_.erase(page_id);
+  for (auto &[stride, residues] : free_pages_by_residue_) {
+    residues[static_cast<uint32_t>(page_id) % stride].erase(page_id);
+  }
+}
+
+}  // namespace bustub
@@ -0,0 +1,169 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// page_compressor.cpp
+//
+// Identification: src/storage/disk/page_compressor.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "storage/disk/page_compressor.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+namespace bustub {
+
+/*
+ * A sequence is a token byte, whose high nibble is the literal length and whose low nibble is the match length minus
+ * MIN_MATCH, followed by the literals, a two byte little-endian match offset and any length extension bytes. A nibble
+ * of 15 means that the length continues in extension bytes, each adding up to 255. The last sequence has literals
+ * only; the input ends right after them.
+ */
+static constexpr size_t MIN_MATCH = 4;
+static constexpr size_t MAX_OFFSET = 65535;
+static constexpr int HASH_BITS = 12;
+
+static uint32_t Load32(const char *p) {
+  uint32_t value;
+  memcpy(&value, p, sizeof(value));
+  return value;
+}
+
+static uint32_t Hash(uint32_t sequence) { return (sequence * 2654435761U) >> (32 - HASH_BITS); }
+
+/** Appends a length beyond what fits into a nibble. @return false if it does not fit */
+static bool WriteLengthExtension(size_t length, char *dst, size_t dst_capacity, size_t *op) {
+  while (length >= 255) {
+    if (*op >= dst_capacity) {
+      return false;
+    }
+    dst[(*op)++] = static_cast<char>(255);
+    length -= 255;
+  }
+  if (*op >= dst_capacity) {
+    return false;
+  }
+  dst[(*op)++] = static_cast<char>(length);
+  return true;
+}
+
+/** Appends one sequence; match_length 0 marks the last one. @return false if it does not fit */
+static bool WriteSequence(const char *literals, size_t literal_length, size_t offset, size_t match_length, char *dst,
+                          size_t dst_capacity, size_t *op) {
+  size_t match_code = match_length == 0 ? 0 : match_length - MIN_MATCH;
+  if (*op >= dst_capacity) {
+    return false;
+  }
+  dst[(*op)++] = static_cast<char>((std::min<size_t>(literal_length, 15) << 4) | std::min<size_t>(match_code, 15));
+  if (literal_length >= 15 && !WriteLengthExtension(literal_length - 15, dst, dst_capacity, op)) {
+    return false;
+  }
+  if (*op + literal_length > dst_capacity) {
+    return false;
+  }
+  memcpy(dst + *op, literals, literal_length);
+  *op += literal_length;
+  if (match_length == 0) {
+    return true;
+  }
+  if (*op + 2 > dst_capacity) {
+    return false;
+  }
+  dst[(*op)++] = static_cast<char>(offset & 0xFF);
+  dst[(*op)++] = static_cast<char>(offset >> 8);
+  return match_code < 15 || WriteLengthExtension(match_code - 15, dst, dst_capacity, op);
+}
+
+size_t PageCompressor::Compress(const char *src, size_t src_size, char *dst, size_t dst_capacity) {
+  // Positions of recent four byte sequences, plus one so that zero means none.
+  std::vector<uint32_t> table(static_cast<size_t>(1) << HASH_BITS, 0);
+  size_t op = 0;
+  size_t anchor = 0;
+  size_t ip = 0;
+  while (ip + MIN_MATCH <= src_size) {
+    uint32_t sequence = Load32(src + ip);
+    uint32_t &slot = table[Hash(sequence)];
+    size_t candidate = slot;
+    slot = static_cast<uint32_t>(ip + 1);
+    if (candidate == 0 || ip - (candidate - 1) > MAX_OFFSET || Load32(src + candidate - 1) != sequence) {
+      ip++;
+      continue;
+    }
+    size_t ref = candidate - 1;
+    size_t match_length = MIN_MATCH;
+    while (ip + match_length < src_size && src[ref + match_length] == src[ip + match_length]) {
+      match_length++;
+    }
+    if (!WriteSequence(src + anchor, ip - anchor, ip - ref, match_length, dst, dst_capacity, &op)) {
+      return 0;
+    }
+    ip += match_length;
+    anchor = ip;
+  }
+  if (!WriteSequence(src + anchor, src_size - anchor, 0, 0, dst, dst_capacity, &op)) {
+    return 0;
+  }
+  return op;
+}
+
+/** Reads a length extension. @return false on truncated input */
+static bool ReadLengthExtension(const unsigned char *src, size_t src_size, size_t *ip, size_t *length) {
+  unsigned char byte;
+  do {
+    if (*ip >= src_size) {
+      return false;
+    }
+    byte = src[(*ip)++];
+    *length += byte;
+  } while (byte == 255);
+  return true;
+}
+
+bool PageCompressor::Decompress(const char *src, size_t src_size, char *dst, size_t dst_size) {
+  const auto *in = reinterpret_cast<const unsigned char *>(src);
+  size_t ip = 0;
+  size_t op = 0;
+  // Every block ends with a literal-only sequence, so running out of input anywhere else means it was truncated.
+  while (ip < src_size) {
+    unsigned char token = in[ip++];
+    size_t literal_length = token >> 4;
+    if (literal_length == 15 && !ReadLengthExtension(in, src_size, &ip, &literal_length)) {
+      return false;
+    }
+    if (literal_length > src_size - ip || literal_length > dst_size - op) {
+      return false;
+    }
+    memcpy(dst + op, src + ip, literal_length);
+    ip += literal_length;
+    op += literal_length;
+    if (ip == src_size) {
+      return op == dst_size;
+    }
+    if (src_size - ip < 2) {
+      return false;
+    }
+    size_t offset = in[ip] | (static_cast<size_t>(in[ip + 1]) << 8);
+    ip += 2;
+    size_t match_length = token & 0x0F;
+    if (match_length == 15 && !ReadLengthExtension(in, src_size, &ip, &match_length)) {
+      return false;
+    }
+    match_length += MIN_MATCH;
+    if (offset == 0 || offset > op || match_length > dst_size - op) {
+      return false;
+    }
+    // Byte by byte, since a match may overlap the output it is producing.
+    for (size_t i = 0; i < match_length; i++, op++) {
+      dst[op] = dst[op - offset];
+    }
+  }
+  return false;
+}
+
+}  // namespace bustub
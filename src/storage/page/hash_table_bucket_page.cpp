@@ -11,71 +11,214 @@
 //===----------------------------------------------------------------------===//
 
 #include "storage/page/hash_table_bucket_page.h"
+
+#include <algorithm>
+
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
 #include "common/logger.h"
 #include "common/util/hash_util.h"
+#include "murmur3/MurmurHash3.h"
 #include "storage/index/generic_key.h"
 #include "storage/index/hash_comparator.h"
 #include "storage/table/tmp_tuple.h"
 
 namespace bustub {
 
+namespace {
+
+/** Number of slots whose fingerprints MatchFingerprint compares at once. */
+#if defined(__AVX2__)
+constexpr uint32_t FINGERPRINT_GROUP_SIZE = 32;
+#elif defined(__SSE2__)
+constexpr uint32_t FINGERPRINT_GROUP_SIZE = 16;
+#else
+constexpr uint32_t FINGERPRINT_GROUP_SIZE = 8;
+#endif
+
+/** Seed of the fingerprint hash, which must differ from the hash function of the table. */
+constexpr uint32_t FINGERPRINT_SEED = 0x9e3779b9;
+
+}  // namespace
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+uint8_t HASH_TABLE_BUCKET_TYPE::Fingerprint(const KeyType &key) {
+  return static_cast<uint8_t>(murmur3::MurmurHash3_x86_32(&key, sizeof(KeyType), FINGERPRINT_SEED) >> 24);
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+uint32_t HASH_TABLE_BUCKET_TYPE::MatchFingerprint(uint32_t group_idx, uint8_t fingerprint) const {
+  // A group may run past the last slot. The vector loads then read into array_, which still lies within the page, and
+  // the readable bits below drop those slots.
+#if defined(__AVX2__)
+  __m256i fingerprints = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(fingerprints_ + group_idx));
+  __m256i equal = _mm256_cmpeq_epi8(fingerprints, _mm256_set1_epi8(static_cast<char>(fingerprint)));
+  auto matches = static_cast<uint32_t>(_mm256_movemask_epi8(equal));
+#elif defined(__SSE2__)
+  __m128i fingerprints = _mm_loadu_si128(reinterpret_cast<const __m128i *>(fingerprints_ + group_idx));
+  __m128i equal = _mm_cmpeq_epi8(fingerprints, _mm_set1_epi8(static_cast<char>(fingerprint)));
+  auto matches = static_cast<uint32_t>(_mm_movemask_epi8(equal));
+#else
+  uint32_t matches = 0;
+  for (uint32_t i = 0; i < FINGERPRINT_GROUP_SIZE && group_idx + i < BUCKET_ARRAY_SIZE; i++) {
+    matches |= static_cast<uint32_t>(fingerprints_[group_idx + i] == fingerprint) << i;
+  }
+#endif
+  // Groups start at a multiple of 8 slots, so their readable bits are whole bytes of readable_.
+  uint32_t readable = 0;
+  uint32_t first_byte = group_idx / 8;
+  uint32_t end_byte = std::min<uint32_t>(sizeof(readable_), first_byte + FINGERPRINT_GROUP_SIZE / 8);
+  for (uint32_t byte = first_byte; byte < end_byte; byte++) {
+    readable |= static_cast<uint32_t>(static_cast<uint8_t>(readable_[byte])) << ((byte - first_byte) * 8);
+  }
+  return matches & readable;
+}
+
 template <typename KeyType, typename ValueType, typename KeyComparator>
 bool HASH_TABLE_BUCKET_TYPE::GetValue(KeyType key, KeyComparator cmp, std::vector<ValueType> *result) {
-  return false;
+  const uint32_t num_slots = BUCKET_ARRAY_SIZE;
+  uint8_t fingerprint = Fingerprint(key);
+  bool found = false;
+  for (uint32_t group_idx = 0; group_idx < num_slots; group_idx += FINGERPRINT_GROUP_SIZE) {
+    for (uint32_t matches = MatchFingerprint(group_idx, fingerprint); matches != 0; matches &= matches - 1) {
+      uint32_t bucket_idx = group_idx + __builtin_ctz(matches);
+      if (cmp(key, array_[bucket_idx].first) == 0) {
+        result->push_back(array_[bucket_idx].second);
+        found = true;
+      }
+    }
+    // Slots are taken front to back, so a group that ends in a never occupied slot ends the scan.
+    if (!IsOccupied(std::min(group_idx + FINGERPRINT_GROUP_SIZE, num_slots) - 1)) {
+      break;
+    }
+  }
+  return found;
 }
 
 template <typename KeyType, typename ValueType, typename KeyComparator>
 bool HASH_TABLE_BUCKET_TYPE::Insert(KeyType key, ValueType value, KeyComparator cmp) {
+  uint8_t fingerprint = Fingerprint(key);
+  uint32_t free_idx = BUCKET_ARRAY_SIZE;
+  uint32_t bucket_idx = 0;
+  for (; bucket_idx < BUCKET_ARRAY_SIZE && IsOccupied(bucket_idx); bucket_idx++) {
+    if (!IsReadable(bucket_idx)) {
+      free_idx = std::min(free_idx, bucket_idx);
+    } else if (fingerprints_[bucket_idx] == fingerprint && value == array_[bucket_idx].second &&
+               cmp(key, array_[bucket_idx].first) == 0) {
+      return false;
+    }
+  }
+  if (free_idx == BUCKET_ARRAY_SIZE) {
+    if (bucket_idx == BUCKET_ARRAY_SIZE) {
+      return false;
+    }
+    free_idx = bucket_idx;
+  }
+  array_[free_idx] = MappingType(key, value);
+  fingerprints_[free_idx] = fingerprint;
+  SetOccupied(free_idx);
+  SetReadable(free_idx);
   return true;
 }
 
+template <typename KeyType, typename ValueType, typename KeyComparator>
+bool HASH_TABLE_BUCKET_TYPE::Contains(KeyType key, ValueType value, KeyComparator cmp) const {
+  const uint32_t num_slots = BUCKET_ARRAY_SIZE;
+  uint8_t fingerprint = Fingerprint(key);
+  for (uint32_t group_idx = 0; group_idx < num_slots; group_idx += FINGERPRINT_GROUP_SIZE) {
+    for (uint32_t matches = MatchFingerprint(group_idx, fingerprint); matches != 0; matches &= matches - 1) {
+      uint32_t bucket_idx = group_idx + __builtin_ctz(matches);
+      // Duplicate keys all match the fingerprint, so the cheaper value comparison goes first.
+      if (value == array_[bucket_idx].second && cmp(key, array_[bucket_idx].first) == 0) {
+        return true;
+      }
+    }
+    if (!IsOccupied(std::min(group_idx + FINGERPRINT_GROUP_SIZE, num_slots) - 1)) {
+      break;
+    }
+  }
+  return false;
+}
+
 template <typename KeyType, typename ValueType, typename KeyComparator>
 bool HASH_TABLE_BUCKET_TYPE::Remove(KeyType key, ValueType value, KeyComparator cmp) {
+  const uint32_t num_slots = BUCKET_ARRAY_SIZE;
+  uint8_t fingerprint = Fingerprint(key);
+  for (uint32_t group_idx = 0; group_idx < num_slots; group_idx += FINGERPRINT_GROUP_SIZE) {
+    for (uint32_t matches = MatchFingerprint(group_idx, fingerprint); matches != 0; matches &= matches - 1) {
+      uint32_t bucket_idx = group_idx + __builtin_ctz(matches);
+      if (value == array_[bucket_idx].second && cmp(key, array_[bucket_idx].first) == 0) {
+        RemoveAt(bucket_idx);
+        return true;
+      }
+    }
+    if (!IsOccupied(std::min(group_idx + FINGERPRINT_GROUP_SIZE, num_slots) - 1)) {
+      break;
+    }
+  }
   return false;
 }
 
 template <typename KeyType, typename ValueType, typename KeyComparator>
 KeyType HASH_TABLE_BUCKET_TYPE::KeyAt(uint32_t bucket_idx) const {
-  return {};
+  return array_[bucket_idx].first;
 }
 
 template <typename KeyType, typename ValueType, typename KeyComparator>
 ValueType HASH_TABLE_BUCKET_TYPE::ValueAt(uint32_t bucket_idx) const {
-  return {};
+  return array_[bucket_idx].second;
 }
 
 template <typename KeyType, typename ValueType, typename KeyComparator>
-void HASH_TABLE_BUCKET_TYPE::RemoveAt(uint32_t bucket_idx) {}
+void HASH_TABLE_BUCKET_TYPE::RemoveAt(uint32_t bucket_idx) {
+  // The slot stays occupied as a tombstone, so that scans go on past it.
+  readable_[bucket_idx / 8] &= static_cast<char>(~(1 << (bucket_idx % 8)));
+}
 
 template <typename KeyType, typename ValueType, typename KeyComparator>
 bool HASH_TABLE_BUCKET_TYPE::IsOccupied(uint32_t bucket_idx) const {
-  return false;
+  return (occupied_[bucket_idx / 8] & (1 << (bucket_idx % 8))) != 0;
 }
 
 template <typename KeyType, typename ValueType, typename KeyComparator>
-void HASH_TABLE_BUCKET_TYPE::SetOccupied(uint32_t bucket_idx) {}
+void HASH_TABLE_BUCKET_TYPE::SetOccupied(uint32_t bucket_idx) {
+  occupied_[bucket_idx / 8] |= static_cast<char>(1 << (bucket_idx % 8));
+}
 
 template <typename KeyType, typename ValueType, typename KeyComparator>
 bool HASH_TABLE_BUCKET_TYPE::IsReadable(uint32_t bucket_idx) const {
-  return false;
+  return (readable_[bucket_idx / 8] & (1 << (bucket_idx % 8))) != 0;
 }
 
 template <typename KeyType, typename ValueType, typename KeyComparator>
-void HASH_TABLE_BUCKET_TYPE::SetReadable(uint32_t bucket_idx) {}
+void HASH_TABLE_BUCKET_TYPE::SetReadable(uint32_t bucket_idx) {
+  readable_[bucket_idx / 8] |= static_cast<char>(1 << (bucket_idx % 8));
+}
 
 template <typename KeyType, typename ValueType, typename KeyComparator>
 bool HASH_TABLE_BUCKET_TYPE::IsFull() {
-  return false;
+  return NumReadable() == BUCKET_ARRAY_SIZE;
 }
 
 template <typename KeyType, typename ValueType, typename KeyComparator>
 uint32_t HASH_TABLE_BUCKET_TYPE::NumReadable() {
-  return 0;
+  uint32_t num_readable = 0;
+  for (size_t i = 0; i < sizeof(readable_); i++) {
+    num_readable += __builtin_popcount(static_cast<unsigned char>(readable_[i]));
+  }
+  return num_readable;
 }
 
 template <typename KeyType, typename ValueType, typename KeyComparator>
 bool HASH_TABLE_BUCKET_TYPE::IsEmpty() {
-  return false;
+  for (char bits : readable_) {
+    if (bits != 0) {
+      return false;
+    }
+  }
+  return true;
 }
 
 template <typename KeyType, typename ValueType, typename KeyComparator>
@@ -13,6 +13,7 @@
 #include "storage/page/table_page.h"
 
 #include <cassert>
+#include <memory>
 
 namespace bustub {
 
@@ -305,6 +306,42 @@ bool TablePage::GetTuple(const RID &rid, Tuple *tuple, Transaction *txn, LockMan
   return true;
 }
 
+bool TablePage::TryGetTupleOptimistic(const RID &rid, Tuple *tuple, bool *exists) {
+  uint64_t version;
+  if (!TryOptimisticRead(&version)) {
+    return false;
+  }
+  uint32_t slot_num = rid.GetSlotNum();
+  // Everything read here may be torn, so check that it stays within the page before using it to address the page.
+  if (slot_num >= GetTupleCount() || OFFSET_TUPLE_SIZE + SIZE_TUPLE * slot_num + sizeof(uint32_t) > PAGE_SIZE) {
+    *exists = false;
+    return ValidateOptimisticRead(version);
+  }
+  uint32_t tuple_size = GetTupleSize(slot_num);
+  if (IsDeleted(tuple_size)) {
+    *exists = false;
+    return ValidateOptimisticRead(version);
+  }
+  uint32_t tuple_offset = GetTupleOffsetAtSlot(slot_num);
+  if (tuple_offset > PAGE_SIZE || tuple_size > PAGE_SIZE - tuple_offset) {
+    return false;
+  }
+  std::unique_ptr<char[]> data(new char[tuple_size]);
+  memcpy(data.get(), GetData() + tuple_offset, tuple_size);
+  if (!ValidateOptimisticRead(version)) {
+    return false;
+  }
+  if (tuple->allocated_) {
+    delete[] tuple->data_;
+  }
+  tuple->size_ = tuple_size;
+  tuple->data_ = data.release();
+  tuple->rid_ = rid;
+  tuple->allocated_ = true;
+  *exists = true;
+  return true;
+}
+
 bool TablePage::GetFirstTupleRid(RID *first_rid) {
   // Find and return the first valid tuple.
   for (uint32_t i = 0; i < GetTupleCount(); ++i) {
@@ -10,19 +10,35 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include <algorithm>
 #include <cassert>
 
 #include "storage/table/table_heap.h"
 
 namespace bustub {
 
-TableIterator::TableIterator(TableHeap *table_heap, RID rid, Transaction *txn)
-    : table_heap_(table_heap), tuple_(new Tuple(rid)), txn_(txn) {
+/** Follows the page chain of a table heap for the prefetcher. */
+static page_id_t NextTablePageId(Page *page) { return static_cast<TablePage *>(page)->GetNextPageId(); }
+
+TableIterator::TableIterator(TableHeap *table_heap, RID rid, Transaction *txn, BufferAccessStrategy *strategy,
+                             size_t read_ahead)
+    : table_heap_(table_heap), tuple_(new Tuple(rid)), txn_(txn), strategy_(strategy), read_ahead_(read_ahead) {
   if (rid.GetPageId() != INVALID_PAGE_ID) {
+    ReadAhead(rid.GetPageId());
     table_heap_->GetTuple(tuple_->rid_, tuple_, txn_);
   }
 }
 
+void TableIterator::ReadAhead(page_id_t page_id) {
+  if (read_ahead_ == 0) {
+    return;
+  }
+  // Top up the window once half of it has been consumed, so the prefetcher stays ahead of the scan without
+  // re-walking the chain for every page.
+  table_heap_->buffer_pool_manager_->PrefetchPage(page_id, read_ahead_, NextTablePageId);
+  pages_until_read_ahead_ = std::max<size_t>(read_ahead_ / 2, 1);
+}
+
 const Tuple &TableIterator::operator*() {
   assert(*this != table_heap_->End());
   return *tuple_;
@@ -35,7 +51,7 @@ Tuple *TableIterator::operator->() {
 
 TableIterator &TableIterator::operator++() {
   BufferPoolManager *buffer_pool_manager = table_heap_->buffer_pool_manager_;
-  auto cur_page = static_cast<TablePage *>(buffer_pool_manager->FetchPage(tuple_->rid_.GetPageId()));
+  auto cur_page = static_cast<TablePage *>(buffer_pool_manager->FetchPage(tuple_->rid_.GetPageId(), strategy_));
   cur_page->RLatch();
   assert(cur_page != nullptr);  // all pages are pinned
 
@@ -43,10 +59,13 @@ TableIterator &TableIterator::operator++() {
   if (!cur_page->GetNextTupleRid(tuple_->rid_,
                                  &next_tuple_rid)) {  // end of this page
     while (cur_page->GetNextPageId() != INVALID_PAGE_ID) {
-      auto next_page = static_cast<TablePage *>(buffer_pool_manager->FetchPage(cur_page->GetNextPageId()));
+      auto next_page = static_cast<TablePage *>(buffer_pool_manager->FetchPage(cur_page->GetNextPageId(), strategy_));
       cur_page->RUnlatch();
       buffer_pool_manager->UnpinPage(cur_page->GetTablePageId(), false);
       cur_page = next_page;
+      if (read_ahead_ != 0 && --pages_until_read_ahead_ == 0) {
+        ReadAhead(cur_page->GetTablePageId());
+      }
       cur_page->RLatch();
       if (cur_page->GetFirstTupleRid(&next_tuple_rid)) {
         break;
@@ -0,0 +1,100 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// lru_k_replacer_test.cpp
+//
+// Identification: test/buffer/lru_k_replacer_test.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <cstdio>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "buffer/lru_k_replacer.h"
+#include "gtest/gtest.h"
+
+namespace bustub {
+
+TEST(LRUKReplacerTest, SampleTest) {
+  // Every reference counts: there is no correlated reference period.
+  LRUKReplacer lru_k_replacer(7, 2, 0);
+
+  // Scenario: frames 1-5 are referenced once, frame 1 and 2 a second time, then all are unpinned.
+  for (int i = 1; i <= 5; i++) {
+    lru_k_replacer.Pin(i);
+  }
+  lru_k_replacer.Pin(2);
+  lru_k_replacer.Pin(1);
+  for (int i = 1; i <= 5; i++) {
+    lru_k_replacer.Unpin(i);
+  }
+  EXPECT_EQ(5, lru_k_replacer.Size());
+
+  // Scenario: frames with a single reference go first, oldest first reference first.
+  int value;
+  ASSERT_TRUE(lru_k_replacer.Victim(&value));
+  EXPECT_EQ(3, value);
+  ASSERT_TRUE(lru_k_replacer.Victim(&value));
+  EXPECT_EQ(4, value);
+  ASSERT_TRUE(lru_k_replacer.Victim(&value));
+  EXPECT_EQ(5, value);
+
+  // Scenario: then the frame whose second most recent reference is the oldest.
+  ASSERT_TRUE(lru_k_replacer.Victim(&value));
+  EXPECT_EQ(1, value);
+
+  // Scenario: a pinned frame is not a victim.
+  lru_k_replacer.Pin(2);
+  EXPECT_EQ(0, lru_k_replacer.Size());
+  EXPECT_FALSE(lru_k_replacer.Victim(&value));
+  lru_k_replacer.Unpin(2);
+  ASSERT_TRUE(lru_k_replacer.Victim(&value));
+  EXPECT_EQ(2, value);
+}
+
+TEST(LRUKReplacerTest, CorrelatedReferenceTest) {
+  LRUKReplacer lru_k_replacer(7, 3, 2);
+
+  // Scenario: frame 2 has the oldest first reference, but it was referenced again within the correlated reference
+  // period, so frame 1 goes first.
+  lru_k_replacer.Pin(2);
+  lru_k_replacer.Pin(1);
+  lru_k_replacer.Pin(3);
+  lru_k_replacer.Pin(2);
+  lru_k_replacer.Unpin(1);
+  lru_k_replacer.Unpin(2);
+  EXPECT_EQ(std::vector<frame_id_t>({1, 2}), lru_k_replacer.PeekVictims(2));
+
+  int value;
+  ASSERT_TRUE(lru_k_replacer.Victim(&value));
+  EXPECT_EQ(1, value);
+
+  // Scenario: if only recently referenced frames are left, one of them still has to go.
+  ASSERT_TRUE(lru_k_replacer.Victim(&value));
+  EXPECT_EQ(2, value);
+
+  // Scenario: frame 4 is referenced many times in a row, like a page pinned once per tuple by a scan, which counts as
+  // a single reference, so it goes before frame 6 with two references. Counted one by one, it would have three.
+  lru_k_replacer.Pin(5);
+  for (int i = 0; i < 10; i++) {
+    lru_k_replacer.Pin(4);
+  }
+  lru_k_replacer.Pin(6);
+  lru_k_replacer.Pin(5);
+  lru_k_replacer.Pin(6);
+  lru_k_replacer.Pin(6);
+  lru_k_replacer.Pin(5);
+  for (int i = 4; i <= 6; i++) {
+    lru_k_replacer.Unpin(i);
+  }
+  lru_k_replacer.Pin(3);
+  lru_k_replacer.Pin(3);
+  ASSERT_TRUE(lru_k_replacer.Victim(&value));
+  EXPECT_EQ(4, value);
+}
+
+}  // namespace bustub
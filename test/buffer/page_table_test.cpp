@@ -0,0 +1,102 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// page_table_test.cpp
+//
+// Identification: test/buffer/page_table_test.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <atomic>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "buffer/page_table.h"
+#include "gtest/gtest.h"
+
+namespace bustub {
+
+// NOLINTNEXTLINE
+TEST(PageTableTest, SampleTest) {
+  PageTable page_table(10);
+  frame_id_t frame_id;
+
+  // Scenario: an empty table finds nothing.
+  EXPECT_FALSE(page_table.Find(0, &frame_id));
+
+  // Scenario: insert ten mappings and find them again.
+  for (int i = 0; i < 10; i++) {
+    page_table.Insert(i * 7, i);
+  }
+  EXPECT_EQ(10, page_table.Size());
+  for (int i = 0; i < 10; i++) {
+    ASSERT_TRUE(page_table.Find(i * 7, &frame_id));
+    EXPECT_EQ(i, frame_id);
+  }
+  EXPECT_FALSE(page_table.Find(1, &frame_id));
+
+  // Scenario: removed pages are no longer found, the others still are.
+  EXPECT_TRUE(page_table.Remove(0));
+  EXPECT_FALSE(page_table.Remove(0));
+  EXPECT_FALSE(page_table.Find(0, &frame_id));
+  ASSERT_TRUE(page_table.Find(7, &frame_id));
+  EXPECT_EQ(1, frame_id);
+  EXPECT_EQ(9, page_table.Size());
+}
+
+// NOLINTNEXTLINE
+TEST(PageTableTest, ChurnTest) {
+  // Scenario: a long stream of insert/remove pairs must not fill the table up with tombstones.
+  const size_t max_entries = 16;
+  PageTable page_table(max_entries);
+  frame_id_t frame_id;
+  for (int i = 0; i < 10000; i++) {
+    page_table.Insert(i, i % max_entries);
+    if (i >= static_cast<int>(max_entries) - 1) {
+      ASSERT_TRUE(page_table.Remove(i - max_entries + 1));
+    }
+  }
+  for (int i = 10000 - max_entries + 1; i < 10000; i++) {
+    ASSERT_TRUE(page_table.Find(i, &frame_id));
+    EXPECT_EQ(i % static_cast<int>(max_entries), frame_id);
+  }
+}
+
+// NOLINTNEXTLINE
+TEST(PageTableTest, ConcurrentReadTest) {
+  // Scenario: readers never see a wrong mapping for a page that is never removed, even while a writer churns.
+  const size_t max_entries = 64;
+  PageTable page_table(max_entries);
+  for (int i = 0; i < 8; i++) {
+    page_table.Insert(-i - 2, i);
+  }
+  std::atomic<bool> done{false};
+  std::vector<std::thread> readers;
+  for (int tid = 0; tid < 4; tid++) {
+    readers.emplace_back([&page_table, &done]() {
+      frame_id_t frame_id;
+      while (!done) {
+        for (int i = 0; i < 8; i++) {
+          if (page_table.Find(-i - 2, &frame_id)) {
+            EXPECT_EQ(i, frame_id);
+          }
+        }
+      }
+    });
+  }
+  for (int i = 0; i < 20000; i++) {
+    page_table.Insert(i, 8 + i % 32);
+    if (i >= 31) {
+      page_table.Remove(i - 31);
+    }
+  }
+  done = true;
+  for (auto &reader : readers) {
+    reader.join();
+  }
+}
+
+}  // namespace bustub
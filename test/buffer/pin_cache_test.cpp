@@ -0,0 +1,163 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// pin_cache_test.cpp
+//
+// Identification: test/buffer/pin_cache_test.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <chrono>  // NOLINT
+#include <cstdio>
+#include <string>
+
+#include "buffer/buffer_pool_manager_instance.h"
+#include "buffer/pin_cache.h"
+#include "common/logger.h"
+#include "gtest/gtest.h"
+
+namespace bustub {
+
+// NOLINTNEXTLINE
+TEST(PinCacheTest, SampleTest) {
+  auto *disk_manager = new DiskManager("test.db");
+  auto *bpm = new BufferPoolManagerInstance(3, disk_manager);
+
+  page_id_t root_id;
+  auto *root = bpm->NewPage(&root_id);
+  ASSERT_NE(nullptr, root);
+  ASSERT_TRUE(bpm->UnpinPage(root_id, false));
+
+  {
+    PinCache cache(bpm, 2, 1);
+
+    // Scenario: the first fetch goes to the buffer pool, the following ones are served by the cache.
+    for (int i = 0; i < 10; i++) {
+      EXPECT_EQ(root, cache.FetchPage(root_id));
+      EXPECT_TRUE(cache.UnpinPage(root_id, false));
+    }
+    EXPECT_EQ(1, cache.GetMisses());
+    EXPECT_EQ(9, cache.GetHits());
+    EXPECT_FALSE(cache.UnpinPage(root_id, false));
+
+    // Scenario: the cache keeps the page pinned, but drops its pin when the buffer pool needs to delete the page. A
+    // page in use through the cache is released once it is unpinned.
+    EXPECT_EQ(1, root->GetPinCount());
+    page_id_t doomed_id;
+    ASSERT_NE(nullptr, bpm->NewPage(&doomed_id));
+    ASSERT_TRUE(bpm->UnpinPage(doomed_id, false));
+    ASSERT_NE(nullptr, cache.FetchPage(doomed_id));
+    EXPECT_FALSE(bpm->DeletePage(doomed_id));
+    EXPECT_TRUE(cache.UnpinPage(doomed_id, false));
+    EXPECT_EQ(1, cache.Size());
+    EXPECT_TRUE(bpm->DeletePage(doomed_id));
+    EXPECT_EQ(root, cache.FetchPage(root_id));
+    EXPECT_TRUE(cache.UnpinPage(root_id, false));
+    EXPECT_TRUE(bpm->DeletePage(root_id));
+    EXPECT_EQ(0, cache.Size());
+    ASSERT_NE(nullptr, root = bpm->NewPage(&root_id));
+    ASSERT_TRUE(bpm->UnpinPage(root_id, false));
+    ASSERT_EQ(root, cache.FetchPage(root_id));
+    EXPECT_TRUE(cache.UnpinPage(root_id, false));
+
+    // Scenario: a dirty unpin reaches the buffer pool right away.
+    snprintf(cache.FetchPage(root_id)->GetData(), PAGE_SIZE, "root");
+    EXPECT_TRUE(cache.UnpinPage(root_id, true));
+    EXPECT_TRUE(root->IsDirty());
+    EXPECT_EQ(1, root->GetPinCount());
+
+    // Scenario: an idle page is released once max_idle_epochs epochs have passed without it being used.
+    cache.AdvanceEpoch();
+    EXPECT_EQ(1, cache.Size());
+    cache.AdvanceEpoch();
+    EXPECT_EQ(0, cache.Size());
+    EXPECT_EQ(0, root->GetPinCount());
+
+    // Scenario: beyond its capacity, the cache releases its least recently used idle page.
+    page_id_t page_ids[3];
+    for (auto &page_id : page_ids) {
+      ASSERT_NE(nullptr, bpm->NewPage(&page_id));
+      ASSERT_TRUE(bpm->UnpinPage(page_id, false));
+    }
+    for (auto page_id : page_ids) {
+      ASSERT_NE(nullptr, cache.FetchPage(page_id));
+      EXPECT_TRUE(cache.UnpinPage(page_id, false));
+    }
+    EXPECT_EQ(2, cache.Size());
+    auto *oldest = bpm->FetchPage(page_ids[0]);
+    EXPECT_EQ(1, oldest->GetPinCount());
+    EXPECT_TRUE(bpm->UnpinPage(page_ids[0], false));
+
+    // Scenario: pages referenced through the cache are never released; the cache goes over capacity instead.
+    cache.ReleaseAll();
+    for (auto page_id : page_ids) {
+      ASSERT_NE(nullptr, cache.FetchPage(page_id));
+    }
+    EXPECT_EQ(3, cache.Size());
+    for (auto page_id : page_ids) {
+      EXPECT_TRUE(cache.UnpinPage(page_id, false));
+    }
+    cache.AdvanceEpoch();
+    EXPECT_EQ(2, cache.Size());
+
+    // Scenario: when the cache's own pins fill the buffer pool, a miss releases them instead of failing.
+    page_id_t other_id;
+    ASSERT_NE(nullptr, bpm->NewPage(&other_id));
+    EXPECT_NE(nullptr, cache.FetchPage(root_id));
+    EXPECT_EQ(1, cache.Size());
+    EXPECT_TRUE(cache.UnpinPage(root_id, false));
+    EXPECT_TRUE(bpm->UnpinPage(other_id, false));
+  }
+
+  // Scenario: destroying the cache drops all of its pins.
+  EXPECT_TRUE(bpm->DeletePage(root_id));
+
+  disk_manager->ShutDown();
+  remove("test.db");
+
+  delete bpm;
+  delete disk_manager;
+}
+
+// Benchmark; run it with --gtest_also_run_disabled_tests.
+// NOLINTNEXTLINE
+TEST(PinCacheTest, DISABLED_HotPageTest) {
+  auto *disk_manager = new DiskManager("test.db");
+  auto *bpm = new BufferPoolManagerInstance(64, disk_manager);
+
+  page_id_t root_id;
+  ASSERT_NE(nullptr, bpm->NewPage(&root_id));
+  ASSERT_TRUE(bpm->UnpinPage(root_id, false));
+
+  // Fetch and unpin the same page over and over, as an index does with its root on every operation.
+  const int num_ops = 1000000;
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < num_ops; i++) {
+    bpm->FetchPage(root_id);
+    bpm->UnpinPage(root_id, false);
+  }
+  auto direct = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+  PinCache cache(bpm);
+  start = std::chrono::steady_clock::now();
+  for (int i = 0; i < num_ops; i++) {
+    cache.FetchPage(root_id);
+    cache.UnpinPage(root_id, false);
+    cache.AdvanceEpoch();
+  }
+  auto cached = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+  EXPECT_EQ(num_ops - 1, cache.GetHits());
+  LOG_INFO("%d fetch/unpin pairs of a hot page: buffer pool %.2f ms, pin cache %.2f ms", num_ops, direct, cached);
+
+  cache.ReleaseAll();
+  disk_manager->ShutDown();
+  remove("test.db");
+
+  delete bpm;
+  delete disk_manager;
+}
+
+}  // namespace bustub
@@ -0,0 +1,127 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// replacer_scan_test.cpp
+//
+// Identification: test/buffer/replacer_scan_test.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <cstdio>
+#include <memory>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "buffer/buffer_pool_manager_instance.h"
+#include "buffer/clock_replacer.h"
+#include "buffer/lru_k_replacer.h"
+#include "buffer/lru_replacer.h"
+#include "buffer/two_q_replacer.h"
+#include "common/logger.h"
+#include "concurrency/transaction.h"
+#include "gtest/gtest.h"
+#include "storage/table/table_heap.h"
+#include "type/value_factory.h"
+
+namespace bustub {
+
+/**
+ * Runs point lookups on a hot set of pages next to a full table scan through a buffer pool that uses the given
+ * replacer, and returns the hit ratio of the lookups. The scan goes through TableIterator, which pins the current page
+ * again for every tuple, just like the executors do.
+ */
+static double HotHitRatio(DiskManager *disk_manager, Replacer *replacer, size_t pool_size,
+                          const std::vector<page_id_t> &hot_page_ids, page_id_t first_page_id, int num_rounds) {
+  Transaction transaction(0);
+  BufferPoolManagerInstance bpm(pool_size, disk_manager, nullptr, replacer);
+  TableHeap table(&bpm, nullptr, nullptr, first_page_id);
+
+  std::default_random_engine rng(15445);
+  std::uniform_int_distribution<size_t> hot_dist(0, hot_page_ids.size() - 1);
+  auto itr = table.Begin(&transaction);
+  uint64_t hot_misses = 0;
+  int hot_lookups = 0;
+  for (int round = 0; round < num_rounds; round++) {
+    // A point lookup touches a few hot index pages, while a concurrent full scan streams through cold table pages.
+    for (int i = 0; i < 4; i++) {
+      uint64_t misses_before = bpm.GetStatsSnapshot().fetch_misses_;
+      page_id_t page_id = hot_page_ids[hot_dist(rng)];
+      EXPECT_NE(nullptr, bpm.FetchPage(page_id));
+      EXPECT_TRUE(bpm.UnpinPage(page_id, false));
+      hot_misses += bpm.GetStatsSnapshot().fetch_misses_ - misses_before;
+      hot_lookups++;
+    }
+    for (int i = 0; i < 32; i++) {
+      if (itr == table.End()) {
+        itr = table.Begin(&transaction);
+      }
+      ++itr;
+    }
+  }
+  return 1 - static_cast<double>(hot_misses) / hot_lookups;
+}
+
+// Benchmark; run it with --gtest_also_run_disabled_tests.
+// NOLINTNEXTLINE
+TEST(ReplacerScanTest, DISABLED_HotSetWithScanTest) {
+  const size_t pool_size = 64;
+  const int num_hot_pages = 32;
+  const int num_tuples = 2000;
+  const int num_rounds = 4000;
+
+  // Lay out the hot pages and a table several times the size of the pool on disk.
+  auto *disk_manager = new DiskManager("test.db");
+  std::vector<page_id_t> hot_page_ids(num_hot_pages);
+  page_id_t first_page_id;
+  {
+    Transaction transaction(0);
+    BufferPoolManagerInstance bpm(pool_size, disk_manager);
+    for (auto &page_id : hot_page_ids) {
+      ASSERT_NE(nullptr, bpm.NewPage(&page_id));
+      ASSERT_TRUE(bpm.UnpinPage(page_id, true));
+    }
+    // A few tuples per page, so that the scan moves on to a new page every few steps.
+    Schema schema({Column("a", TypeId::VARCHAR, PAGE_SIZE / 5)});
+    std::string value(PAGE_SIZE / 5, 'x');
+    TableHeap table(&bpm, nullptr, nullptr, &transaction);
+    for (int i = 0; i < num_tuples; i++) {
+      RID rid;
+      ASSERT_TRUE(table.InsertTuple(Tuple({ValueFactory::GetVarcharValue(value)}, &schema), &rid, &transaction));
+    }
+    first_page_id = table.GetFirstPageId();
+    bpm.FlushAllPages();
+  }
+
+  std::vector<std::pair<std::string, Replacer *>> replacers;
+  replacers.emplace_back("LRU", new LRUReplacer(pool_size));
+  replacers.emplace_back("Clock", new ClockReplacer(pool_size));
+  replacers.emplace_back("LRU-2", new LRUKReplacer(pool_size, 2));
+  replacers.emplace_back("2Q", new TwoQReplacer(pool_size));
+
+  std::unordered_map<std::string, double> hit_ratios;
+  for (auto &[name, replacer] : replacers) {
+    // The buffer pool takes ownership of the replacer.
+    hit_ratios[name] = HotHitRatio(disk_manager, replacer, pool_size, hot_page_ids, first_page_id, num_rounds);
+    LOG_INFO("%-6s hot page hit ratio: %.3f", name.c_str(), hit_ratios[name]);
+  }
+
+  // The scan-resistant policies keep the hot set resident, even though the scan references every page many times in
+  // a row; plain LRU does not.
+  EXPECT_GT(hit_ratios["LRU-2"], 0.9);
+  EXPECT_GT(hit_ratios["2Q"], 0.9);
+  EXPECT_GT(hit_ratios["LRU-2"], hit_ratios["LRU"]);
+  EXPECT_GT(hit_ratios["2Q"], hit_ratios["LRU"]);
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  remove("test.log");
+  delete disk_manager;
+}
+
+}  // namespace bustub
@@ -0,0 +1,78 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// two_q_replacer_test.cpp
+//
+// Identification: test/buffer/two_q_replacer_test.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <cstdio>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "buffer/two_q_replacer.h"
+#include "gtest/gtest.h"
+
+namespace bustub {
+
+TEST(TwoQReplacerTest, SampleTest) {
+  TwoQReplacer two_q_replacer(8, 2, 2);
+
+  // Scenario: pages 10-15 are loaded into frames 0-5 and go to A1. Frame 0 is referenced again while in A1, which is
+  // a correlated reference and does not move it.
+  for (int i = 0; i < 6; i++) {
+    two_q_replacer.Load(i, 10 + i);
+    two_q_replacer.Pin(i);
+  }
+  two_q_replacer.Pin(0);
+  for (int i = 0; i < 6; i++) {
+    two_q_replacer.Unpin(i);
+  }
+  EXPECT_EQ(6, two_q_replacer.Size());
+
+  // Scenario: A1 holds more than its share, so it gives up its frames in FIFO order. A1out remembers the last two
+  // evicted pages, 11 and 12.
+  int value;
+  ASSERT_TRUE(two_q_replacer.Victim(&value));
+  EXPECT_EQ(0, value);
+  ASSERT_TRUE(two_q_replacer.Victim(&value));
+  EXPECT_EQ(1, value);
+  ASSERT_TRUE(two_q_replacer.Victim(&value));
+  EXPECT_EQ(2, value);
+
+  // Scenario: page 12 comes back while A1out remembers it and goes to Am; page 10 was forgotten and goes to A1.
+  two_q_replacer.Load(0, 12);
+  two_q_replacer.Pin(0);
+  two_q_replacer.Load(1, 10);
+  two_q_replacer.Pin(1);
+  two_q_replacer.Unpin(0);
+  two_q_replacer.Unpin(1);
+
+  // Scenario: A1 (frames 3, 4, 5, 1) gives up frames until it is within its share, then Am gives up its frame.
+  ASSERT_TRUE(two_q_replacer.Victim(&value));
+  EXPECT_EQ(3, value);
+  ASSERT_TRUE(two_q_replacer.Victim(&value));
+  EXPECT_EQ(4, value);
+  ASSERT_TRUE(two_q_replacer.Victim(&value));
+  EXPECT_EQ(0, value);
+
+  // Scenario: pinned frames are skipped.
+  two_q_replacer.Pin(1);
+  ASSERT_TRUE(two_q_replacer.Victim(&value));
+  EXPECT_EQ(5, value);
+  EXPECT_EQ(0, two_q_replacer.Size());
+  EXPECT_FALSE(two_q_replacer.Victim(&value));
+
+  // Scenario: a removed frame is forgotten.
+  two_q_replacer.Unpin(1);
+  EXPECT_EQ(1, two_q_replacer.Size());
+  two_q_replacer.Remove(1);
+  EXPECT_EQ(0, two_q_replacer.Size());
+  EXPECT_FALSE(two_q_replacer.Victim(&value));
+}
+
+}  // namespace bustub
@@ -10,14 +10,19 @@
 //
 //===----------------------------------------------------------------------===//
 
-#include <thread>  // NOLINT
+#include <atomic>
+#include <chrono>        // NOLINT
+#include <shared_mutex>  // NOLINT
+#include <thread>        // NOLINT
 #include <vector>
 
+#include "common/logger.h"
 #include "common/rwlatch.h"
 #include "gtest/gtest.h"
 
 namespace bustub {
 
+template <typename Latch>
 class Counter {
  public:
   Counter() = default;
@@ -36,13 +41,83 @@ class Counter {
 
  private:
   int count_{0};
-  ReaderWriterLatch mutex_{};
+  Latch mutex_{};
 };
 
+/** std::shared_mutex with the latch interface, as a baseline. */
+class SharedMutexLatch {
+ public:
+  void WLock() { mutex_.lock(); }
+  void WUnlock() { mutex_.unlock(); }
+  void RLock() { mutex_.lock_shared(); }
+  void RUnlock() { mutex_.unlock_shared(); }
+
+ private:
+  std::shared_mutex mutex_;
+};
+
+template <typename Latch>
+void CheckCounter() {
+  int num_threads = 100;
+  Counter<Latch> counter{};
+  counter.Add(5);
+  std::vector<std::thread> threads;
+  for (int tid = 0; tid < num_threads; tid++) {
+    if (tid % 2 == 0) {
+      threads.emplace_back([&counter]() {
+        for (int i = 0; i < 100; i++) {
+          counter.Read();
+        }
+      });
+    } else {
+      threads.emplace_back([&counter]() {
+        for (int i = 0; i < 100; i++) {
+          counter.Add(1);
+        }
+      });
+    }
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  EXPECT_EQ(counter.Read(), 5 + 50 * 100);
+}
+
+/** Runs a read-mostly workload on one latch and returns the time it took, in milliseconds. */
+template <typename Latch>
+double RunLatchWorkload(int num_threads, int ops_per_thread) {
+  Latch latch;
+  int64_t value = 0;
+  std::vector<std::thread> threads;
+  auto start = std::chrono::steady_clock::now();
+  for (int tid = 0; tid < num_threads; tid++) {
+    threads.emplace_back([&] {
+      int64_t sum = 0;
+      for (int i = 0; i < ops_per_thread; i++) {
+        if (i % 16 == 0) {
+          latch.WLock();
+          value++;
+          latch.WUnlock();
+        } else {
+          latch.RLock();
+          sum += value;
+          latch.RUnlock();
+        }
+      }
+      EXPECT_GE(sum, 0);
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  EXPECT_EQ(value, static_cast<int64_t>(num_threads) * ((ops_per_thread + 15) / 16));
+  return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
 // NOLINTNEXTLINE
 TEST(RWLatchTest, BasicTest) {
   int num_threads = 100;
-  Counter counter{};
+  Counter<ReaderWriterLatch> counter{};
   counter.Add(5);
   std::vector<std::thread> threads;
   for (int tid = 0; tid < num_threads; tid++) {
@@ -57,4 +132,58 @@ TEST(RWLatchTest, BasicTest) {
   }
   EXPECT_EQ(counter.Read(), 55);
 }
+
+// NOLINTNEXTLINE
+TEST(RWLatchTest, ManyThreadsTest) {
+  CheckCounter<ReaderWriterLatch>();
+  CheckCounter<ShardedReaderWriterLatch>();
+}
+
+// NOLINTNEXTLINE
+TEST(RWLatchTest, WriterPreferenceTest) {
+  ReaderWriterLatch latch;
+  std::atomic<bool> writer_in{false};
+
+  // Scenario: readers share the latch.
+  latch.RLock();
+  latch.RLock();
+
+  // Scenario: a waiting writer holds off new readers until it got the latch.
+  std::thread writer([&] {
+    latch.WLock();
+    writer_in = true;
+    latch.WUnlock();
+  });
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  std::atomic<bool> reader_in{false};
+  std::thread reader([&] {
+    latch.RLock();
+    EXPECT_TRUE(writer_in);
+    reader_in = true;
+    latch.RUnlock();
+  });
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  EXPECT_FALSE(writer_in);
+  EXPECT_FALSE(reader_in);
+
+  latch.RUnlock();
+  latch.RUnlock();
+  writer.join();
+  reader.join();
+  EXPECT_TRUE(reader_in);
+}
+
+// NOLINTNEXTLINE
+TEST(RWLatchTest, ContentionBenchmarkTest) {
+  // The same number of operations in total at every thread count, one in sixteen a write.
+  const int total_ops = 1 << 17;
+  for (int num_threads = 1; num_threads <= 64; num_threads *= 2) {
+    int ops_per_thread = total_ops / num_threads;
+    double latch = RunLatchWorkload<ReaderWriterLatch>(num_threads, ops_per_thread);
+    double sharded = RunLatchWorkload<ShardedReaderWriterLatch>(num_threads, ops_per_thread);
+    double shared_mutex = RunLatchWorkload<SharedMutexLatch>(num_threads, ops_per_thread);
+    LOG_INFO("%2d threads: ReaderWriterLatch %.2f ms, ShardedReaderWriterLatch %.2f ms, std::shared_mutex %.2f ms",
+             num_threads, latch, sharded, shared_mutex);
+  }
+}
 }  // namespace bustub
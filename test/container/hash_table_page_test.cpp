@@ -10,20 +10,25 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include <algorithm>
+#include <chrono>  // NOLINT
+#include <cstring>
 #include <thread>  // NOLINT
 #include <vector>
 
 #include "buffer/buffer_pool_manager_instance.h"
 #include "common/logger.h"
+#include "container/hash/hash_table_directory.h"
 #include "gtest/gtest.h"
 #include "storage/disk/disk_manager.h"
 #include "storage/page/hash_table_bucket_page.h"
 #include "storage/page/hash_table_directory_page.h"
+#include "test_util.h"  // NOLINT
 
 namespace bustub {
 
 // NOLINTNEXTLINE
-TEST(HashTablePageTest, DISABLED_DirectoryPageSampleTest) {
+TEST(HashTablePageTest, DirectoryPageSampleTest) {
   DiskManager *disk_manager = new DiskManager("test.db");
   auto *bpm = new BufferPoolManagerInstance(5, disk_manager);
 
@@ -57,7 +62,69 @@ TEST(HashTablePageTest, DISABLED_DirectoryPageSampleTest) {
 }
 
 // NOLINTNEXTLINE
-TEST(HashTablePageTest, DISABLED_BucketPageSampleTest) {
+TEST(HashTablePageTest, SegmentedDirectoryTest) {
+  DiskManager *disk_manager = new DiskManager("test.db");
+  const size_t pool_size = 10;
+  auto *bpm = new BufferPoolManagerInstance(pool_size, disk_manager);
+
+  page_id_t directory_page_id = INVALID_PAGE_ID;
+  auto directory_page =
+      reinterpret_cast<HashTableDirectoryPage *>(bpm->NewPage(&directory_page_id, nullptr)->GetData());
+  directory_page->SetBucketPageId(0, 100);
+  directory_page->SetLocalDepth(0, 0);
+
+  {
+    HashTableDirectory directory(bpm, directory_page);
+    // Grow well past the entries the directory page holds; each new half mirrors the old one.
+    const uint32_t global_depth = 12;
+    for (uint32_t depth = 1; depth <= global_depth; depth++) {
+      ASSERT_TRUE(directory.IncrGlobalDepth());
+      EXPECT_EQ(depth, directory.GetGlobalDepth());
+    }
+    EXPECT_EQ(1U << global_depth, directory.Size());
+    for (uint32_t idx = 0; idx < directory.Size(); idx++) {
+      EXPECT_EQ(100, directory.GetBucketPageId(idx));
+      EXPECT_EQ(0, directory.GetLocalDepth(idx));
+    }
+
+    // Split the bucket once: odd entries point to its image.
+    for (uint32_t idx = 0; idx < directory.Size(); idx++) {
+      directory.IncrLocalDepth(idx);
+      if ((idx & 1) != 0) {
+        directory.SetBucketPageId(idx, 101);
+      }
+    }
+    directory.VerifyIntegrity();
+    EXPECT_TRUE(directory.CanShrink());
+    directory.SetLocalDepth(0, global_depth);
+    EXPECT_FALSE(directory.CanShrink());
+    directory.SetLocalDepth(0, 1);
+    EXPECT_TRUE(directory.CanShrink());
+
+    // Shrink back into the directory page, down to the depth of the buckets.
+    while (directory.CanShrink()) {
+      directory.DecrGlobalDepth();
+    }
+    EXPECT_EQ(1, directory.GetGlobalDepth());
+    directory.VerifyIntegrity();
+    EXPECT_EQ(100, directory.GetBucketPageId(0));
+    EXPECT_EQ(101, directory.GetBucketPageId(1));
+  }
+
+  // The directory left no segment page pinned behind.
+  bpm->UnpinPage(directory_page_id, true, nullptr);
+  std::vector<page_id_t> page_ids(pool_size);
+  for (auto &page_id : page_ids) {
+    EXPECT_NE(nullptr, bpm->NewPage(&page_id));
+  }
+  disk_manager->ShutDown();
+  remove("test.db");
+  delete disk_manager;
+  delete bpm;
+}
+
+// NOLINTNEXTLINE
+TEST(HashTablePageTest, BucketPageSampleTest) {
   DiskManager *disk_manager = new DiskManager("test.db");
   auto *bpm = new BufferPoolManagerInstance(5, disk_manager);
 
@@ -114,4 +181,61 @@ TEST(HashTablePageTest, DISABLED_BucketPageSampleTest) {
   delete bpm;
 }
 
+template <size_t KeySize>
+void BenchmarkBucketLookups() {
+  using KeyType = GenericKey<KeySize>;
+  using ValueType = RID;
+  // 4-byte keys hold an integer column, wider ones a bigint padded with zeroes.
+  auto key_schema = ParseCreateStatement(KeySize == 4 ? "a integer" : "a bigint");
+  GenericComparator<KeySize> comparator(key_schema.get());
+  std::vector<char> page(PAGE_SIZE);
+  using BucketPage = HashTableBucketPage<KeyType, ValueType, GenericComparator<KeySize>>;
+  auto bucket_page = reinterpret_cast<BucketPage *>(page.data());
+  auto make_key = [](int64_t i) {
+    KeyType key;
+    memset(key.data_, 0, KeySize);
+    memcpy(key.data_, &i, std::min<size_t>(KeySize, sizeof(int64_t)));
+    return key;
+  };
+
+  const int num_slots = static_cast<int>(BUCKET_ARRAY_SIZE);
+  for (int i = 0; i < num_slots; i++) {
+    ASSERT_TRUE(bucket_page->Insert(make_key(i), RID(i, i), comparator));
+  }
+  ASSERT_TRUE(bucket_page->IsFull());
+
+  // Hits find their one pair; misses have to rule out every slot, and the fingerprints spare them most comparisons.
+  const int rounds = 20;
+  std::vector<RID> res;
+  auto start = std::chrono::steady_clock::now();
+  for (int round = 0; round < rounds; round++) {
+    for (int i = 0; i < num_slots; i++) {
+      res.clear();
+      ASSERT_TRUE(bucket_page->GetValue(make_key(i), comparator, &res));
+      ASSERT_EQ(1, res.size());
+      ASSERT_EQ(RID(i, i), res[0]);
+    }
+  }
+  auto hit_ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+  start = std::chrono::steady_clock::now();
+  for (int round = 0; round < rounds; round++) {
+    for (int i = 0; i < num_slots; i++) {
+      res.clear();
+      ASSERT_FALSE(bucket_page->GetValue(make_key(num_slots + i), comparator, &res));
+    }
+  }
+  auto miss_ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+  LOG_INFO("%zu-byte keys, %d slots: %.0f ns per hit, %.0f ns per miss", KeySize, num_slots,
+           hit_ns / (rounds * num_slots), miss_ns / (rounds * num_slots));
+}
+
+// NOLINTNEXTLINE
+TEST(HashTablePageTest, BucketLookupBenchmarkTest) {
+  BenchmarkBucketLookups<4>();
+  BenchmarkBucketLookups<8>();
+  BenchmarkBucketLookups<16>();
+  BenchmarkBucketLookups<32>();
+  BenchmarkBucketLookups<64>();
+}
+
 }  // namespace bustub
@@ -10,21 +10,28 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include <algorithm>
+#include <chrono>  // NOLINT
+#include <cmath>
+#include <numeric>
+#include <random>
 #include <thread>  // NOLINT
 #include <vector>
 
 #include "buffer/buffer_pool_manager_instance.h"
 #include "common/logger.h"
 #include "container/hash/extendible_hash_table.h"
+#include "execution/executor_context.h"
 #include "gtest/gtest.h"
 #include "murmur3/MurmurHash3.h"
+#include "test_util.h"  // NOLINT
 
 namespace bustub {
 
 // NOLINTNEXTLINE
 
 // NOLINTNEXTLINE
-TEST(HashTableTest, DISABLED_SampleTest) {
+TEST(HashTableTest, SampleTest) {
   auto *disk_manager = new DiskManager("test.db");
   auto *bpm = new BufferPoolManagerInstance(50, disk_manager);
   ExtendibleHashTable<int, int, IntComparator> ht("blah", bpm, IntComparator(), HashFunction<int>());
@@ -117,4 +124,583 @@ TEST(HashTableTest, DISABLED_SampleTest) {
   delete bpm;
 }
 
+// NOLINTNEXTLINE
+TEST(HashTableTest, SplitMergeTest) {
+  auto *disk_manager = new DiskManager("test.db");
+  auto *bpm = new BufferPoolManagerInstance(50, disk_manager);
+  ExtendibleHashTable<int, int, IntComparator> ht("blah", bpm, IntComparator(), HashFunction<int>());
+
+  // Enough keys to split buckets and double the directory several times.
+  const int num_keys = 5000;
+  for (int i = 0; i < num_keys; i++) {
+    EXPECT_TRUE(ht.Insert(nullptr, i, i));
+  }
+  EXPECT_FALSE(ht.Insert(nullptr, 42, 42));
+  EXPECT_GE(ht.GetGlobalDepth(), 3);
+  ht.VerifyIntegrity();
+  for (int i = 0; i < num_keys; i++) {
+    std::vector<int> res;
+    ASSERT_TRUE(ht.GetValue(nullptr, i, &res));
+    ASSERT_EQ(1, res.size());
+    EXPECT_EQ(i, res[0]);
+  }
+
+  // Emptied buckets merge, and the directory shrinks back.
+  for (int i = 0; i < num_keys; i++) {
+    EXPECT_TRUE(ht.Remove(nullptr, i, i));
+  }
+  ht.VerifyIntegrity();
+  EXPECT_EQ(0, ht.GetGlobalDepth());
+  std::vector<int> res;
+  EXPECT_FALSE(ht.GetValue(nullptr, 0, &res));
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  remove("test.log");
+  delete disk_manager;
+  delete bpm;
+}
+
+// NOLINTNEXTLINE
+TEST(HashTableTest, LargeDirectoryTest) {
+  auto key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<64> comparator(key_schema.get());
+  auto *disk_manager = new DiskManager("test.db");
+  auto *bpm = new BufferPoolManagerInstance(50, disk_manager);
+  ExtendibleHashTable<GenericKey<64>, RID, GenericComparator<64>> ht("blah", bpm, comparator,
+                                                                     HashFunction<GenericKey<64>>());
+
+  // Wide keys fill buckets fast, so the directory outgrows the directory page and spills into segment pages.
+  const int num_keys = 12 * PAGE_SIZE;
+  GenericKey<64> key;
+  for (int i = 0; i < num_keys; i++) {
+    key.SetFromInteger(i);
+    ASSERT_TRUE(ht.Insert(nullptr, key, RID(i, i)));
+  }
+  EXPECT_GT(1U << ht.GetGlobalDepth(), DIRECTORY_ARRAY_SIZE);
+  ht.VerifyIntegrity();
+  for (int i = 0; i < num_keys; i++) {
+    std::vector<RID> res;
+    key.SetFromInteger(i);
+    ASSERT_TRUE(ht.GetValue(nullptr, key, &res));
+    ASSERT_EQ(1, res.size());
+    EXPECT_EQ(RID(i, i), res[0]);
+  }
+
+  // Scenario: the pool has a frame for the directory page, but not for its segments. Operations fail instead of
+  // throwing, and release everything they took on the way.
+  std::vector<page_id_t> pinned_page_ids;
+  page_id_t pinned_page_id;
+  while (bpm->NewPage(&pinned_page_id) != nullptr) {
+    pinned_page_ids.push_back(pinned_page_id);
+  }
+  ASSERT_TRUE(bpm->UnpinPage(pinned_page_ids.back(), false));
+  key.SetFromInteger(0);
+  std::vector<RID> res;
+  EXPECT_FALSE(ht.GetValue(nullptr, key, &res));
+  EXPECT_FALSE(ht.Insert(nullptr, key, RID(0, 1)));
+  EXPECT_FALSE(ht.Remove(nullptr, key, RID(0, 0)));
+  for (page_id_t page_id : pinned_page_ids) {
+    bpm->UnpinPage(page_id, false);
+    bpm->DeletePage(page_id);
+  }
+  ht.VerifyIntegrity();
+  EXPECT_TRUE(ht.GetValue(nullptr, key, &res));
+  EXPECT_EQ(std::vector<RID>{RID(0, 0)}, res);
+
+  // Removing all keys merges the buckets back and shrinks the directory into its page, and down to depth 0.
+  for (int i = 0; i < num_keys; i += 2) {
+    key.SetFromInteger(i);
+    ASSERT_TRUE(ht.Remove(nullptr, key, RID(i, i)));
+  }
+  ht.VerifyIntegrity();
+  for (int i = 1; i < num_keys; i += 2) {
+    key.SetFromInteger(i);
+    ASSERT_TRUE(ht.Remove(nullptr, key, RID(i, i)));
+  }
+  ht.VerifyIntegrity();
+  EXPECT_EQ(0, ht.GetGlobalDepth());
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  remove("test.log");
+  delete disk_manager;
+  delete bpm;
+}
+
+// NOLINTNEXTLINE
+TEST(HashTableTest, BulkLoadTest) {
+  auto key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<8> comparator(key_schema.get());
+  auto *disk_manager = new DiskManager("test.db");
+  auto *bpm = new BufferPoolManagerInstance(50, disk_manager);
+  ExtendibleHashTable<GenericKey<8>, RID, GenericComparator<8>> ht("blah", bpm, comparator,
+                                                                   HashFunction<GenericKey<8>>());
+
+  const int num_keys = 20000;
+  std::vector<std::pair<GenericKey<8>, RID>> entries(num_keys);
+  for (int i = 0; i < num_keys; i++) {
+    entries[i].first.SetFromInteger(i);
+    entries[i].second = RID(i, i);
+  }
+  ASSERT_TRUE(ht.BulkLoad(nullptr, entries));
+  EXPECT_GT(ht.GetGlobalDepth(), 0);
+  ht.VerifyIntegrity();
+  for (const auto &[key, rid] : entries) {
+    std::vector<RID> res;
+    ASSERT_TRUE(ht.GetValue(nullptr, key, &res));
+    ASSERT_EQ(1, res.size());
+    EXPECT_EQ(rid, res[0]);
+  }
+  // Only an empty table can be bulk loaded.
+  EXPECT_FALSE(ht.BulkLoad(nullptr, entries));
+
+  // The loaded table grows and shrinks like any other.
+  GenericKey<8> key;
+  for (int i = num_keys; i < 2 * num_keys; i++) {
+    key.SetFromInteger(i);
+    ASSERT_TRUE(ht.Insert(nullptr, key, RID(i, i)));
+  }
+  ht.VerifyIntegrity();
+  for (int i = 0; i < 2 * num_keys; i++) {
+    key.SetFromInteger(i);
+    ASSERT_TRUE(ht.Remove(nullptr, key, RID(i, i)));
+  }
+  ht.VerifyIntegrity();
+  EXPECT_EQ(0, ht.GetGlobalDepth());
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  remove("test.log");
+  delete disk_manager;
+  delete bpm;
+}
+
+// NOLINTNEXTLINE
+TEST(HashTableTest, BulkLoadSkewTest) {
+  auto *disk_manager = new DiskManager("test.db");
+  auto *bpm = new BufferPoolManagerInstance(50, disk_manager);
+
+  // A few hot keys with many values each, many keys with one value, and some pairs that occur twice.
+  const int num_hot_keys = 10;
+  const int num_hot_values = 1000;
+  const int num_cold_keys = 4000;
+  std::vector<std::pair<int, int>> entries;
+  for (int key = 0; key < num_hot_keys; key++) {
+    for (int i = 0; i < num_hot_values; i++) {
+      entries.emplace_back(key, key * num_hot_values + i);
+    }
+  }
+  for (int key = num_hot_keys; key < num_hot_keys + num_cold_keys; key++) {
+    entries.emplace_back(key, key);
+  }
+  entries.emplace_back(3, 3 * num_hot_values);
+  entries.emplace_back(num_hot_keys, num_hot_keys);
+  std::shuffle(entries.begin(), entries.end(), std::default_random_engine(15445));
+
+  // Scenario: a single hot key among a few cold ones fits in one bucket and its chain.
+  {
+    std::vector<std::pair<int, int>> hot_entries;
+    for (int i = 0; i < 2000; i++) {
+      hot_entries.emplace_back(0, i);
+    }
+    for (int key = 1; key <= 100; key++) {
+      hot_entries.emplace_back(key, key);
+    }
+    ExtendibleHashTable<int, int, IntComparator> ht("hot", bpm, IntComparator(), HashFunction<int>());
+    ASSERT_TRUE(ht.BulkLoad(nullptr, hot_entries));
+    EXPECT_EQ(0, ht.GetGlobalDepth());
+    ht.VerifyIntegrity();
+    std::vector<int> res;
+    ASSERT_TRUE(ht.GetValue(nullptr, 0, &res));
+    EXPECT_EQ(2000, res.size());
+  }
+
+  // Scenario: the hot keys get overflow chains, as they do from inserts, so the directory grows no deeper.
+  uint32_t insert_depth;
+  {
+    ExtendibleHashTable<int, int, IntComparator> ht("inserts", bpm, IntComparator(), HashFunction<int>());
+    for (const auto &[key, value] : entries) {
+      ht.Insert(nullptr, key, value);
+    }
+    insert_depth = ht.GetGlobalDepth();
+  }
+  ExtendibleHashTable<int, int, IntComparator> ht("bulk", bpm, IntComparator(), HashFunction<int>());
+  ASSERT_TRUE(ht.BulkLoad(nullptr, entries));
+  EXPECT_LE(ht.GetGlobalDepth(), insert_depth);
+  ht.VerifyIntegrity();
+
+  // Scenario: every pair is loaded once.
+  for (int key = 0; key < num_hot_keys + num_cold_keys; key++) {
+    std::vector<int> res;
+    ASSERT_TRUE(ht.GetValue(nullptr, key, &res));
+    ASSERT_EQ(key < num_hot_keys ? num_hot_values : 1, res.size());
+    std::sort(res.begin(), res.end());
+    EXPECT_EQ(key < num_hot_keys ? key * num_hot_values : key, res[0]);
+  }
+  EXPECT_FALSE(ht.Insert(nullptr, 3, 3 * num_hot_values + 1));
+
+  // Scenario: the loaded chains shrink like the ones of inserts.
+  for (const auto &[key, value] : entries) {
+    ht.Remove(nullptr, key, value);
+  }
+  ht.VerifyIntegrity();
+  EXPECT_EQ(0, ht.GetGlobalDepth());
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  remove("test.log");
+  delete disk_manager;
+  delete bpm;
+}
+
+// Benchmark; run it with --gtest_also_run_disabled_tests.
+// NOLINTNEXTLINE
+TEST(HashTableTest, DISABLED_BulkLoadBenchmarkTest) {
+  auto key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<8> comparator(key_schema.get());
+  const int num_keys = 100000;
+  std::vector<std::pair<GenericKey<8>, RID>> entries(num_keys);
+  for (int i = 0; i < num_keys; i++) {
+    entries[i].first.SetFromInteger(i);
+    entries[i].second = RID(i, i);
+  }
+
+  // Build the same table by inserting the keys one by one, and by loading them at once.
+  for (bool bulk_load : {false, true}) {
+    auto *disk_manager = new DiskManager("test.db");
+    auto *bpm = new BufferPoolManagerInstance(512, disk_manager);
+    ExtendibleHashTable<GenericKey<8>, RID, GenericComparator<8>> ht("bench", bpm, comparator,
+                                                                     HashFunction<GenericKey<8>>());
+    auto start = std::chrono::steady_clock::now();
+    if (bulk_load) {
+      ASSERT_TRUE(ht.BulkLoad(nullptr, entries));
+    } else {
+      for (const auto &[key, rid] : entries) {
+        ASSERT_TRUE(ht.Insert(nullptr, key, rid));
+      }
+    }
+    auto build_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    LOG_INFO("%s of %d keys: %.2f ms (global depth %u, %d disk writes)", bulk_load ? "bulk load" : "inserts", num_keys,
+             build_ms, ht.GetGlobalDepth(), disk_manager->GetNumWrites());
+
+    disk_manager->ShutDown();
+    remove("test.db");
+    remove("test.log");
+    delete bpm;
+    delete disk_manager;
+  }
+}
+
+// NOLINTNEXTLINE
+TEST(HashTableTest, DuplicateKeyTest) {
+  auto *disk_manager = new DiskManager("test.db");
+  auto *bpm = new BufferPoolManagerInstance(50, disk_manager);
+  ExtendibleHashTable<int, int, IntComparator> ht("blah", bpm, IntComparator(), HashFunction<int>());
+
+  // Many more values of one key than a bucket holds: they go to an overflow chain, and the directory does not grow.
+  const int num_values = 5000;
+  for (int i = 0; i < num_values; i++) {
+    EXPECT_TRUE(ht.Insert(nullptr, 7, i));
+  }
+  EXPECT_EQ(0, ht.GetGlobalDepth());
+  EXPECT_FALSE(ht.Insert(nullptr, 7, 42));
+  EXPECT_FALSE(ht.Insert(nullptr, 7, num_values - 1));
+  std::vector<int> res;
+  ASSERT_TRUE(ht.GetValue(nullptr, 7, &res));
+  ASSERT_EQ(num_values, res.size());
+  std::sort(res.begin(), res.end());
+  for (int i = 0; i < num_values; i++) {
+    EXPECT_EQ(i, res[i]);
+  }
+
+  // Other keys split the bucket around the chain.
+  for (int i = 0; i < num_values; i++) {
+    if (i != 7) {
+      EXPECT_TRUE(ht.Insert(nullptr, i, i));
+    }
+  }
+  EXPECT_GE(ht.GetGlobalDepth(), 3);
+  ht.VerifyIntegrity();
+  for (int i = 0; i < num_values; i++) {
+    res.clear();
+    ASSERT_TRUE(ht.GetValue(nullptr, i, &res));
+    ASSERT_EQ(i == 7 ? num_values : 1, res.size());
+  }
+
+  // Removing everything frees the chain, so the buckets merge and the directory shrinks back.
+  for (int i = 0; i < num_values; i++) {
+    EXPECT_TRUE(ht.Remove(nullptr, 7, i));
+    if (i != 7) {
+      EXPECT_TRUE(ht.Remove(nullptr, i, i));
+    }
+  }
+  EXPECT_FALSE(ht.Remove(nullptr, 7, 0));
+  ht.VerifyIntegrity();
+  EXPECT_EQ(0, ht.GetGlobalDepth());
+  res.clear();
+  EXPECT_FALSE(ht.GetValue(nullptr, 7, &res));
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  remove("test.log");
+  delete disk_manager;
+  delete bpm;
+}
+
+// NOLINTNEXTLINE
+TEST(HashTableTest, PinCacheTest) {
+  auto *disk_manager = new DiskManager("test.db");
+  auto *bpm = new BufferPoolManagerInstance(50, disk_manager);
+  ExtendibleHashTable<int, int, IntComparator> ht("blah", bpm, IntComparator(), HashFunction<int>());
+
+  const int num_keys = 100;
+  auto count_fetches = [&](Transaction *transaction) {
+    auto before = bpm->GetStatsSnapshot();
+    std::vector<int> res;
+    for (int i = 0; i < num_keys; i++) {
+      EXPECT_TRUE(ht.GetValue(transaction, i, &res));
+    }
+    auto after = bpm->GetStatsSnapshot();
+    return (after.fetch_hits_ + after.fetch_misses_) - (before.fetch_hits_ + before.fetch_misses_);
+  };
+
+  Transaction txn(0);
+  {
+    ExecutorContext exec_ctx(&txn, nullptr, bpm, nullptr, nullptr);
+    EXPECT_EQ(exec_ctx.GetPinCache(), txn.GetPinCache());
+    for (int i = 0; i < num_keys; i++) {
+      EXPECT_TRUE(ht.Insert(&txn, i, i));
+    }
+
+    // Scenario: the operations of a transaction fetch the directory from the buffer pool once, through the pin cache
+    // of its executor context.
+    uint64_t uncached = count_fetches(nullptr);
+    uint64_t cached = count_fetches(&txn);
+    EXPECT_EQ(num_keys, uncached - cached);
+    EXPECT_GE(exec_ctx.GetPinCache()->GetHits(), 2 * num_keys - 1);
+    EXPECT_EQ(1, bpm->GetStatsSnapshot().pinned_frames_);
+
+    // Scenario: the pinned directory stays writable by other transactions, and the cached transaction sees the change.
+    for (int i = num_keys; i < 2 * num_keys; i++) {
+      EXPECT_TRUE(ht.Insert(nullptr, i, i));
+    }
+    std::vector<int> res;
+    EXPECT_TRUE(ht.GetValue(&txn, 2 * num_keys - 1, &res));
+    ht.VerifyIntegrity();
+  }
+
+  // Scenario: destroying the executor context detaches the cache and drops its pin.
+  EXPECT_EQ(nullptr, txn.GetPinCache());
+  EXPECT_EQ(0, bpm->GetStatsSnapshot().pinned_frames_);
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  remove("test.log");
+  delete disk_manager;
+  delete bpm;
+}
+
+// NOLINTNEXTLINE
+TEST(HashTableTest, SkewedInsertTest) {
+  auto *disk_manager = new DiskManager("test.db");
+  auto *bpm = new BufferPoolManagerInstance(50, disk_manager);
+  ExtendibleHashTable<int, int, IntComparator> ht("blah", bpm, IntComparator(), HashFunction<int>());
+
+  // Scenario: Zipfian keys, so that the hottest keys overflow their buckets while the others split them.
+  const int num_keys = 500;
+  const int num_inserts = 10000;
+  std::vector<double> weights(num_keys);
+  for (int k = 0; k < num_keys; k++) {
+    weights[k] = 1.0 / std::pow(k + 1, 0.99);
+  }
+  std::mt19937 gen(15445);
+  std::discrete_distribution<int> zipf(weights.begin(), weights.end());
+  std::vector<int> counts(num_keys);
+  for (int i = 0; i < num_inserts; i++) {
+    int key = zipf(gen);
+    ASSERT_TRUE(ht.Insert(nullptr, key, i));
+    counts[key]++;
+  }
+  ht.VerifyIntegrity();
+  for (int k = 0; k < num_keys; k++) {
+    std::vector<int> res;
+    ht.GetValue(nullptr, k, &res);
+    EXPECT_EQ(counts[k], res.size());
+  }
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  remove("test.log");
+  delete disk_manager;
+  delete bpm;
+}
+
+// Benchmark; run it with --gtest_also_run_disabled_tests.
+// NOLINTNEXTLINE
+TEST(HashTableTest, DISABLED_SkewedInsertBenchmarkTest) {
+  auto *disk_manager = new DiskManager("test.db");
+  auto *bpm = new BufferPoolManagerInstance(512, disk_manager);
+  ExtendibleHashTable<int, int, IntComparator> ht("bench", bpm, IntComparator(), HashFunction<int>());
+
+  // Keys follow a Zipfian distribution with s = 0.99, so the hottest keys have thousands of values each.
+  const int num_keys = 10000;
+  const int num_inserts = 100000;
+  std::vector<double> weights(num_keys);
+  for (int k = 0; k < num_keys; k++) {
+    weights[k] = 1.0 / std::pow(k + 1, 0.99);
+  }
+  std::mt19937 gen(15445);
+  std::discrete_distribution<int> zipf(weights.begin(), weights.end());
+  std::vector<int> keys(num_inserts);
+  for (auto &key : keys) {
+    key = zipf(gen);
+  }
+
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < num_inserts; i++) {
+    ASSERT_TRUE(ht.Insert(nullptr, keys[i], i));
+  }
+  auto insert_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+  start = std::chrono::steady_clock::now();
+  size_t num_values = 0;
+  for (int k = 0; k < num_keys; k++) {
+    std::vector<int> res;
+    ht.GetValue(nullptr, k, &res);
+    num_values += res.size();
+  }
+  auto lookup_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+  EXPECT_EQ(num_inserts, num_values);
+  LOG_INFO("zipf inserts of %d values: %.2f ms, lookups of %d keys: %.2f ms (global depth %u)", num_inserts, insert_ms,
+           num_keys, lookup_ms, ht.GetGlobalDepth());
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  remove("test.log");
+  delete disk_manager;
+  delete bpm;
+}
+
+// NOLINTNEXTLINE
+TEST(HashTableTest, ConcurrentInsertLookupTest) {
+  auto *disk_manager = new DiskManager("test.db");
+  auto *bpm = new BufferPoolManagerInstance(64, disk_manager);
+  ExtendibleHashTable<int, int, IntComparator> ht("blah", bpm, IntComparator(), HashFunction<int>());
+
+  // Writers insert disjoint key ranges while splits go on; readers look up keys that are already in.
+  const int num_threads = 4;
+  const int keys_per_thread = 2000;
+  for (int i = 0; i < keys_per_thread; i++) {
+    ASSERT_TRUE(ht.Insert(nullptr, -i - 1, i));
+  }
+  std::vector<std::thread> threads;
+  for (int t = 0; t < num_threads; t++) {
+    threads.emplace_back([&, t] {
+      for (int i = 0; i < keys_per_thread; i++) {
+        int key = t * keys_per_thread + i;
+        ASSERT_TRUE(ht.Insert(nullptr, key, key));
+        std::vector<int> res;
+        ASSERT_TRUE(ht.GetValue(nullptr, -(i % keys_per_thread) - 1, &res));
+        ASSERT_EQ(1, res.size());
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  ht.VerifyIntegrity();
+  for (int key = 0; key < num_threads * keys_per_thread; key++) {
+    std::vector<int> res;
+    ASSERT_TRUE(ht.GetValue(nullptr, key, &res));
+    EXPECT_EQ(key, res[0]);
+  }
+
+  // Concurrent removes merge buckets while lookups of the remaining keys go on.
+  threads.clear();
+  for (int t = 0; t < num_threads; t++) {
+    threads.emplace_back([&, t] {
+      for (int i = 0; i < keys_per_thread; i++) {
+        int key = t * keys_per_thread + i;
+        ASSERT_TRUE(ht.Remove(nullptr, key, key));
+        std::vector<int> res;
+        ASSERT_TRUE(ht.GetValue(nullptr, -i - 1, &res));
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  ht.VerifyIntegrity();
+  for (int i = 0; i < keys_per_thread; i++) {
+    std::vector<int> res;
+    ASSERT_TRUE(ht.GetValue(nullptr, -i - 1, &res));
+    EXPECT_EQ(i, res[0]);
+  }
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  remove("test.log");
+  delete disk_manager;
+  delete bpm;
+}
+
+// Benchmark; run it with --gtest_also_run_disabled_tests.
+// NOLINTNEXTLINE
+TEST(HashTableTest, DISABLED_ConcurrentScalingBenchmarkTest) {
+  auto key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<8> comparator(key_schema.get());
+  const int num_keys = 8192;
+  std::vector<GenericKey<8>> keys(num_keys);
+  for (int i = 0; i < num_keys; i++) {
+    keys[i].SetFromInteger(i);
+  }
+
+  // Each round builds a fresh table: every thread inserts its share of the keys, then looks up random ones.
+  for (int num_threads : {1, 2, 4, 8, 16, 32}) {
+    auto *disk_manager = new DiskManager("test.db");
+    auto *bpm = new BufferPoolManagerInstance(512, disk_manager);
+    ExtendibleHashTable<GenericKey<8>, RID, GenericComparator<8>> ht("bench", bpm, comparator,
+                                                                       HashFunction<GenericKey<8>>());
+    const int keys_per_thread = num_keys / num_threads;
+    const int lookups_per_thread = 2 * keys_per_thread;
+    std::vector<std::thread> threads;
+    auto start = std::chrono::steady_clock::now();
+    for (int t = 0; t < num_threads; t++) {
+      threads.emplace_back([&, t] {
+        for (int i = t * keys_per_thread; i < (t + 1) * keys_per_thread; i++) {
+          ASSERT_TRUE(ht.Insert(nullptr, keys[i], RID(i, i)));
+        }
+      });
+    }
+    for (auto &thread : threads) {
+      thread.join();
+    }
+    auto insert_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    threads.clear();
+    start = std::chrono::steady_clock::now();
+    for (int t = 0; t < num_threads; t++) {
+      threads.emplace_back([&, t] {
+        std::mt19937 rng(t);
+        std::vector<RID> res;
+        for (int i = 0; i < lookups_per_thread; i++) {
+          res.clear();
+          ASSERT_TRUE(ht.GetValue(nullptr, keys[rng() % num_keys], &res));
+        }
+      });
+    }
+    for (auto &thread : threads) {
+      thread.join();
+    }
+    auto lookup_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    LOG_INFO("%d threads: %d inserts %.2f ms, %d lookups %.2f ms (global depth %u)", num_threads, num_keys, insert_ms,
+             2 * num_keys, lookup_ms, ht.GetGlobalDepth());
+
+    disk_manager->ShutDown();
+    remove("test.db");
+    remove("test.log");
+    delete bpm;
+    delete disk_manager;
+  }
+}
+
 }  // namespace bustub
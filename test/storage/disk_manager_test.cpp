@@ -10,10 +10,25 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include <fcntl.h>
+#include <unistd.h>
+#include <algorithm>
+#include <chrono>  // NOLINT
+#include <cstdio>
+#include <cstdlib>
 #include <cstring>
+#include <future>  // NOLINT
+#include <limits>
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>  // NOLINT
+#include <utility>
+#include <vector>
 
 #include "common/exception.h"
 #include "gtest/gtest.h"
+#include "storage/disk/async_disk_io.h"
 #include "storage/disk/disk_manager.h"
 
 namespace bustub {
@@ -23,13 +38,26 @@ class DiskManagerTest : public ::testing::Test {
   // This function is called before every test.
   void SetUp() override {
     remove("test.db");
+    remove("test.fsm");
     remove("test.log");
+    remove("test.pmap");
+    RemoveTablespaceFiles();
+  }
+
+  static void RemoveTablespaceFiles() {
+    for (int i = 1; i < 4; i++) {
+      remove(("test.ts" + std::to_string(i)).c_str());
+      remove(("test.ts" + std::to_string(i) + ".fsm").c_str());
+    }
   }
 
   // This function is called after every test.
   void TearDown() override {
     remove("test.db");
+    remove("test.fsm");
     remove("test.log");
+    remove("test.pmap");
+    RemoveTablespaceFiles();
   };
 };
 
@@ -55,6 +83,433 @@ TEST_F(DiskManagerTest, ReadWritePageTest) {
   dm.ShutDown();
 }
 
+// NOLINTNEXTLINE
+TEST_F(DiskManagerTest, WritePagesTest) {
+  char buf[PAGE_SIZE] = {0};
+  std::vector<std::vector<char>> data(10, std::vector<char>(PAGE_SIZE));
+  std::string db_file("test.db");
+  auto dm = DiskManager(db_file);
+
+  // Two runs of adjacent pages and a single page, out of order.
+  std::vector<page_id_t> page_ids{7, 2, 3, 9, 1, 8};
+  std::vector<std::pair<page_id_t, const char *>> pages;
+  for (auto page_id : page_ids) {
+    std::snprintf(data[page_id].data(), PAGE_SIZE, "page %d", page_id);
+    pages.emplace_back(page_id, data[page_id].data());
+  }
+  EXPECT_TRUE(dm.WritePages(&pages));
+  EXPECT_EQ(6, dm.GetNumWrites());
+  EXPECT_TRUE(std::is_sorted(pages.begin(), pages.end()));
+
+  for (auto page_id : page_ids) {
+    dm.ReadPage(page_id, buf);
+    EXPECT_EQ(std::memcmp(buf, data[page_id].data(), sizeof(buf)), 0);
+  }
+
+  // Scenario: a page of a tablespace that does not exist cannot be written. The other pages still are, and only they
+  // are left in the batch.
+  pages.clear();
+  pages.emplace_back(MakePageId(1, 0), data[0].data());
+  pages.emplace_back(4, data[4].data());
+  EXPECT_FALSE(dm.WritePages(&pages));
+  ASSERT_EQ(1, pages.size());
+  EXPECT_EQ(4, pages[0].first);
+
+  dm.ShutDown();
+}
+
+// NOLINTNEXTLINE
+TEST_F(DiskManagerTest, FreePageMapTest) {
+  char data[PAGE_SIZE] = {0};
+  std::string db_file("test.db");
+  auto dm = std::make_unique<DiskManager>(db_file);
+  auto *map = dm->GetFreePageMap();
+  for (page_id_t page_id = 0; page_id < 4; page_id++) {
+    EXPECT_EQ(page_id, dm->AllocatePage());
+  }
+
+  // Deallocated pages are reused only after a sync point.
+  dm->DeallocatePage(1);
+  dm->DeallocatePage(2);
+  dm->DeallocatePage(2);
+  EXPECT_EQ(4, dm->AllocatePage());
+  EXPECT_TRUE(map->IsAllocated(1));
+  dm->Sync();
+  EXPECT_FALSE(map->IsAllocated(1));
+  EXPECT_EQ(2, map->GetNumFreePages());
+  EXPECT_EQ(1, dm->AllocatePage());
+
+  // Page ids of a stride only come from their own residue; the ones skipped are free for the others.
+  EXPECT_EQ(2, dm->AllocatePage(2, 0));
+  EXPECT_EQ(5, dm->AllocatePage(2, 1));
+  EXPECT_EQ(8, dm->AllocatePage(4, 0));
+  EXPECT_EQ(6, dm->AllocatePage(2, 0));
+  EXPECT_EQ(7, dm->AllocatePage());
+  EXPECT_EQ(9, dm->GetFreePageMap()->GetEndPageId());
+
+  // Pages freed once a stride is in use are reused by the allocations of their residue.
+  dm->DeallocatePage(6);
+  dm->DeallocatePage(5);
+  dm->Sync();
+  EXPECT_EQ(5, dm->AllocatePage(2, 1));
+  EXPECT_EQ(6, dm->AllocatePage(4, 2));
+  EXPECT_EQ(0, map->GetNumFreePages());
+
+  // The map survives a restart.
+  dm->DeallocatePage(3);
+  dm->WritePage(8, data);
+  dm->Sync();
+  dm->ShutDown();
+  dm = std::make_unique<DiskManager>(db_file);
+  map = dm->GetFreePageMap();
+  EXPECT_FALSE(map->IsAllocated(3));
+  EXPECT_TRUE(map->IsAllocated(4));
+  EXPECT_EQ(3, dm->AllocatePage());
+  EXPECT_EQ(9, dm->AllocatePage());
+  dm->ShutDown();
+
+  // Without a map file, all pages of the file are allocated.
+  remove("test.fsm");
+  dm = std::make_unique<DiskManager>(db_file);
+  EXPECT_EQ(9, dm->AllocatePage());
+  EXPECT_EQ(0, dm->GetFreePageMap()->GetNumFreePages());
+  dm->ShutDown();
+
+  // A new database ignores the map of an old one.
+  remove("test.db");
+  dm = std::make_unique<DiskManager>(db_file);
+  EXPECT_EQ(0, dm->AllocatePage());
+  dm->ShutDown();
+}
+
+// NOLINTNEXTLINE
+TEST_F(DiskManagerTest, PageSizeCheckTest) {
+  char data[PAGE_SIZE] = {0};
+  std::string db_file("test.db");
+  auto dm = std::make_unique<DiskManager>(db_file);
+  dm->WritePage(dm->AllocatePage(), data);
+  dm->ShutDown();
+
+  // A database that never deallocated a page still records its page size in the map file.
+  FILE *map_file = fopen("test.fsm", "r+b");
+  ASSERT_NE(nullptr, map_file);
+  uint32_t page_size = 2 * PAGE_SIZE;
+  ASSERT_EQ(0, fseek(map_file, sizeof(uint32_t), SEEK_SET));
+  ASSERT_EQ(1, fwrite(&page_size, sizeof(page_size), 1, map_file));
+  ASSERT_EQ(0, fclose(map_file));
+  EXPECT_THROW(DiskManager{db_file}, Exception);
+}
+
+// NOLINTNEXTLINE
+TEST_F(DiskManagerTest, TablespaceTest) {
+  std::string db_file("test.db");
+  auto dm = std::make_unique<DiskManager>(db_file);
+  tablespace_id_t space_id = dm->CreateTablespace();
+  ASSERT_EQ(1, space_id);
+  EXPECT_EQ("test.ts1", dm->GetTablespaceFileName(space_id));
+  EXPECT_EQ(2, dm->CreateTablespace());
+  EXPECT_TRUE(dm->DropTablespace(2));
+
+  // Page ids of a tablespace carry its id, and pages of different tablespaces do not collide.
+  EXPECT_EQ(0, dm->AllocatePage());
+  EXPECT_EQ(MakePageId(space_id, 0), dm->AllocatePage(1, 0, space_id));
+  EXPECT_EQ(MakePageId(space_id, 3), dm->AllocatePage(4, 3, space_id));
+  EXPECT_EQ(INVALID_PAGE_ID, dm->AllocatePage(1, 0, 2));
+  char data[PAGE_SIZE] = {0};
+  char buf[PAGE_SIZE] = {0};
+  std::strncpy(data, "default", sizeof(data));
+  dm->WritePage(0, data);
+  std::strncpy(data, "tablespace", sizeof(data));
+  dm->WritePage(MakePageId(space_id, 0), data);
+  dm->ReadPage(0, buf);
+  EXPECT_STREQ("default", buf);
+  dm->ReadPage(MakePageId(space_id, 0), buf);
+  EXPECT_STREQ("tablespace", buf);
+  dm->Sync();
+  dm->ShutDown();
+
+  // The tablespace is opened again on first use.
+  dm = std::make_unique<DiskManager>(db_file);
+  std::memset(buf, 0, sizeof(buf));
+  dm->ReadPage(MakePageId(space_id, 0), buf);
+  EXPECT_STREQ("tablespace", buf);
+  EXPECT_TRUE(dm->GetFreePageMap(space_id)->IsAllocated(3));
+  EXPECT_EQ(MakePageId(space_id, 1), dm->AllocatePage(1, 0, space_id));
+
+  // Dropping unlinks the file and frees the id.
+  EXPECT_FALSE(dm->DropTablespace(DEFAULT_TABLESPACE_ID));
+  EXPECT_TRUE(dm->DropTablespace(space_id));
+  EXPECT_FALSE(dm->DropTablespace(space_id));
+  EXPECT_EQ(nullptr, dm->GetFreePageMap(space_id));
+  EXPECT_NE(0, access("test.ts1", F_OK));
+  EXPECT_EQ(space_id, dm->CreateTablespace());
+  EXPECT_EQ(MakePageId(space_id, 0), dm->AllocatePage(1, 0, space_id));
+
+  // Scenario: a tablespace is dropped while writes to it are in flight. Its file stays open until they are done.
+  std::vector<std::future<bool>> writes;
+  for (page_id_t page_number = 0; page_number < 64; page_number++) {
+    writes.push_back(dm->WritePageAsync(MakePageId(space_id, page_number), data));
+  }
+  EXPECT_TRUE(dm->DropTablespace(space_id));
+  for (auto &write : writes) {
+    EXPECT_TRUE(write.get());
+  }
+
+  // Scenario: the default tablespace owns almost all page ids, far more than the other tablespaces.
+  EXPECT_EQ(DEFAULT_TABLESPACE_ID, TablespaceOf(FIRST_TABLESPACE_PAGE_ID - 1));
+  EXPECT_EQ(1, TablespaceOf(FIRST_TABLESPACE_PAGE_ID));
+  EXPECT_EQ(MAX_TABLESPACES - 1, TablespaceOf(std::numeric_limits<page_id_t>::max()));
+  EXPECT_EQ(INVALID_TABLESPACE_ID, TablespaceOf(INVALID_PAGE_ID));
+  EXPECT_GT(FIRST_TABLESPACE_PAGE_ID, 64 * TABLESPACE_MAX_PAGES);
+  std::strncpy(data, "past a tablespace", sizeof(data));
+  dm->WritePage(TABLESPACE_MAX_PAGES, data);
+  std::memset(buf, 0, sizeof(buf));
+  dm->ReadPage(TABLESPACE_MAX_PAGES, buf);
+  EXPECT_STREQ("past a tablespace", buf);
+  dm->ShutDown();
+}
+
+// NOLINTNEXTLINE
+TEST_F(DiskManagerTest, DirectIOTest) {
+  std::string db_file("test.db");
+  auto dm = DiskManager(db_file, false, true);
+  // An aligned page goes to the file as is, an unaligned one through the staging buffer.
+  auto aligned = std::unique_ptr<char[]>(static_cast<char *>(std::aligned_alloc(PAGE_SIZE, 2 * PAGE_SIZE)));
+  std::vector<char> unaligned(PAGE_SIZE + 1);
+  std::snprintf(aligned.get(), PAGE_SIZE, "aligned");
+  std::snprintf(unaligned.data() + 1, PAGE_SIZE, "unaligned");
+  dm.WritePage(0, aligned.get());
+  dm.WritePage(1, unaligned.data() + 1);
+  dm.Sync();
+
+  std::vector<char> buf(PAGE_SIZE + 1);
+  dm.ReadPage(0, buf.data() + 1);
+  EXPECT_STREQ("aligned", buf.data() + 1);
+  dm.ReadPage(1, aligned.get() + PAGE_SIZE);
+  EXPECT_STREQ("unaligned", aligned.get() + PAGE_SIZE);
+  EXPECT_TRUE(dm.ReadPageAsync(0, buf.data() + 1).get());
+  EXPECT_STREQ("aligned", buf.data() + 1);
+  dm.ShutDown();
+  std::free(aligned.release());
+}
+
+// NOLINTNEXTLINE
+TEST_F(DiskManagerTest, ConcurrentReadWriteTest) {
+  const int num_threads = 4;
+  const int pages_per_thread = 64;
+  std::string db_file("test.db");
+  auto dm = DiskManager(db_file);
+
+  // Every thread writes and reads back its own pages, interleaved with the others.
+  std::vector<std::thread> threads;
+  for (int t = 0; t < num_threads; t++) {
+    threads.emplace_back([&, t] {
+      std::vector<char> data(PAGE_SIZE);
+      std::vector<char> buf(PAGE_SIZE);
+      for (int round = 0; round < 4; round++) {
+        for (int i = 0; i < pages_per_thread; i++) {
+          page_id_t page_id = i * num_threads + t;
+          std::snprintf(data.data(), PAGE_SIZE, "page %d round %d", page_id, round);
+          dm.WritePage(page_id, data.data());
+          dm.ReadPage(page_id, buf.data());
+          EXPECT_EQ(data, buf);
+        }
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  EXPECT_EQ(4 * num_threads * pages_per_thread, dm.GetNumWrites());
+  dm.ShutDown();
+}
+
+// NOLINTNEXTLINE
+TEST_F(DiskManagerTest, CompressedReadWritePageTest) {
+  char buf[PAGE_SIZE] = {0};
+  std::vector<std::vector<char>> data(3, std::vector<char>(PAGE_SIZE));
+  std::string db_file("test.db");
+  auto dm = std::make_unique<DiskManager>(db_file, true);
+  auto *store = dm->GetPageStore();
+  ASSERT_NE(nullptr, store);
+
+  dm->ReadPage(4, buf);  // never written pages read as zeroes
+  EXPECT_TRUE(std::all_of(buf, buf + PAGE_SIZE, [](char c) { return c == 0; }));
+
+  // A mostly empty page, a page of incompressible noise, and a page in between.
+  std::snprintf(data[0].data(), PAGE_SIZE, "A test string.");
+  std::mt19937 rng(15445);
+  std::generate(data[1].begin(), data[1].end(), rng);
+  std::generate(data[2].begin(), data[2].begin() + PAGE_SIZE / 2, rng);
+  for (page_id_t page_id = 0; page_id < 3; page_id++) {
+    dm->WritePage(page_id, data[page_id].data());
+  }
+  EXPECT_EQ(3 * PAGE_SIZE, store->GetLogicalBytes());
+  EXPECT_LT(store->GetStoredBytes(), store->GetLogicalBytes());
+  for (page_id_t page_id = 0; page_id < 3; page_id++) {
+    dm->ReadPage(page_id, buf);
+    EXPECT_EQ(std::memcmp(buf, data[page_id].data(), sizeof(buf)), 0);
+  }
+
+  // Rewrites that grow and shrink pages move them to other extents.
+  std::swap(data[0], data[1]);
+  std::vector<std::pair<page_id_t, const char *>> pages;
+  for (page_id_t page_id = 0; page_id < 3; page_id++) {
+    pages.emplace_back(page_id, data[page_id].data());
+  }
+  dm->WritePages(&pages);
+  EXPECT_EQ(6, dm->GetNumWrites());
+  dm->ShutDown();
+
+  // The extent map survives a restart.
+  dm = std::make_unique<DiskManager>(db_file, true);
+  for (page_id_t page_id = 0; page_id < 3; page_id++) {
+    dm->ReadPage(page_id, buf);
+    EXPECT_EQ(std::memcmp(buf, data[page_id].data(), sizeof(buf)), 0);
+  }
+  dm->ShutDown();
+}
+
+// NOLINTNEXTLINE
+TEST_F(DiskManagerTest, CompressedCrashTest) {
+  char buf[PAGE_SIZE] = {0};
+  std::vector<std::vector<char>> data(2, std::vector<char>(PAGE_SIZE, 0));
+  // Two mostly empty pages that compress to different sizes within the same number of slots.
+  std::mt19937 rng(15445);
+  std::generate(data[0].begin(), data[0].begin() + 100, rng);
+  std::generate(data[1].begin(), data[1].begin() + 200, rng);
+  auto store = std::make_unique<CompressedPageStore>("test.db", "test.pmap");
+  store->WritePage(0, data[0].data());
+  store->Sync();
+  size_t stored_bytes = store->GetStoredBytes();
+  EXPECT_LT(stored_bytes, static_cast<size_t>(PAGE_SIZE));
+
+  // Scenario: the page is rewritten, but the store crashes before the next Sync. The persisted map still points to
+  // the first version, which must be intact.
+  store->WritePage(0, data[1].data());
+  EXPECT_EQ(stored_bytes, store->GetStoredBytes());
+  store.reset();
+  store = std::make_unique<CompressedPageStore>("test.db", "test.pmap");
+  store->ReadPage(0, buf);
+  EXPECT_EQ(std::memcmp(buf, data[0].data(), sizeof(buf)), 0);
+
+  // Scenario: once synced, the rewrite survives a crash too.
+  store->WritePage(0, data[1].data());
+  store->Sync();
+  store.reset();
+  store = std::make_unique<CompressedPageStore>("test.db", "test.pmap");
+  store->ReadPage(0, buf);
+  EXPECT_EQ(std::memcmp(buf, data[1].data(), sizeof(buf)), 0);
+  store->Close();
+}
+
+// NOLINTNEXTLINE
+TEST_F(DiskManagerTest, AsyncReadWritePageTest) {
+  const int num_pages = 64;
+  std::vector<std::vector<char>> data(num_pages, std::vector<char>(PAGE_SIZE));
+  std::vector<std::vector<char>> bufs(num_pages, std::vector<char>(PAGE_SIZE, 1));
+  std::string db_file("test.db");
+  auto dm = DiskManager(db_file);
+
+  // Reads past the end of the file complete with zeroes.
+  ASSERT_TRUE(dm.ReadPageAsync(3, bufs[0].data()).get());
+  EXPECT_TRUE(std::all_of(bufs[0].begin(), bufs[0].end(), [](char c) { return c == 0; }));
+
+  // More I/Os than the queue is deep, mixed with synchronous ones.
+  std::vector<std::future<bool>> writes;
+  for (int i = 0; i < num_pages; i++) {
+    std::snprintf(data[i].data(), PAGE_SIZE, "page %d", i);
+    if (i % 4 == 0) {
+      dm.WritePage(i, data[i].data());
+    } else {
+      writes.push_back(dm.WritePageAsync(i, data[i].data()));
+    }
+  }
+  for (auto &write : writes) {
+    EXPECT_TRUE(write.get());
+  }
+  EXPECT_EQ(num_pages, dm.GetNumWrites());
+  std::vector<std::future<bool>> reads;
+  for (int i = 0; i < num_pages; i++) {
+    reads.push_back(dm.ReadPageAsync(i, bufs[i].data()));
+  }
+  for (int i = 0; i < num_pages; i++) {
+    EXPECT_TRUE(reads[i].get());
+    EXPECT_EQ(data[i], bufs[i]);
+  }
+  dm.ShutDown();
+
+  // The thread pool fallback behaves the same.
+  int fd = open(db_file.c_str(), O_RDWR);
+  ASSERT_GE(fd, 0);
+  {
+    auto io = AsyncDiskIO::Create(4, false);
+    EXPECT_STREQ("thread pool", io->GetName());
+    reads.clear();
+    for (int i = 0; i < num_pages; i++) {
+      reads.push_back(io->SubmitRead(fd, static_cast<off_t>(i) * PAGE_SIZE, bufs[i].data()));
+    }
+    for (int i = 0; i < num_pages; i++) {
+      EXPECT_TRUE(reads[i].get());
+      EXPECT_EQ(data[i], bufs[i]);
+    }
+  }
+  close(fd);
+}
+
+// NOLINTNEXTLINE
+TEST_F(DiskManagerTest, RandomReadBenchmarkTest) {
+  const int num_pages = 2048;
+  const int num_reads = 8192;
+  const int num_threads = 4;
+  std::string db_file("test.db");
+  auto dm = DiskManager(db_file);
+  std::vector<char> data(PAGE_SIZE);
+  for (int i = 0; i < num_pages; i++) {
+    std::snprintf(data.data(), PAGE_SIZE, "page %d", i);
+    dm.WritePage(i, data.data());
+  }
+  std::mt19937 rng(15445);
+  std::vector<page_id_t> page_ids(num_reads);
+  std::generate(page_ids.begin(), page_ids.end(), [&] { return rng() % num_pages; });
+
+  // Several threads reading through the synchronous path.
+  auto start = std::chrono::steady_clock::now();
+  std::vector<std::thread> threads;
+  for (int t = 0; t < num_threads; t++) {
+    threads.emplace_back([&, t] {
+      std::vector<char> buf(PAGE_SIZE);
+      for (int i = t; i < num_reads; i += num_threads) {
+        dm.ReadPage(page_ids[i], buf.data());
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  double sync_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+  // One thread keeping the async queue full.
+  std::vector<std::vector<char>> bufs(ASYNC_IO_QUEUE_DEPTH, std::vector<char>(PAGE_SIZE));
+  std::vector<std::future<bool>> reads(ASYNC_IO_QUEUE_DEPTH);
+  start = std::chrono::steady_clock::now();
+  for (int i = 0; i < num_reads; i++) {
+    auto slot = i % ASYNC_IO_QUEUE_DEPTH;
+    if (reads[slot].valid()) {
+      EXPECT_TRUE(reads[slot].get());
+    }
+    reads[slot] = dm.ReadPageAsync(page_ids[i], bufs[slot].data());
+  }
+  for (auto &read : reads) {
+    EXPECT_TRUE(read.get());
+  }
+  double async_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+  std::printf("random reads: sync %.0f IOPS, %s %.0f IOPS\n", num_reads / sync_seconds, dm.GetAsyncIO()->GetName(),
+              num_reads / async_seconds);
+  dm.ShutDown();
+}
+
 // NOLINTNEXTLINE
 TEST_F(DiskManagerTest, ReadWriteLogTest) {
   char buf[16] = {0};
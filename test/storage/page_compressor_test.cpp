@@ -0,0 +1,168 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// page_compressor_test.cpp
+//
+// Identification: test/storage/page_compressor_test.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <algorithm>
+#include <chrono>  // NOLINT
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "buffer/buffer_pool_manager_instance.h"
+#include "catalog/catalog.h"
+#include "catalog/table_generator.h"
+#include "concurrency/transaction.h"
+#include "execution/executor_context.h"
+#include "gtest/gtest.h"
+#include "storage/disk/disk_manager.h"
+#include "storage/disk/page_compressor.h"
+#include "storage/table/table_heap.h"
+
+namespace bustub {
+
+/** Compresses and decompresses a page. @return the compressed size, 0 if it did not fit into a page */
+static size_t RoundTrip(const std::vector<char> &page) {
+  std::vector<char> compressed(PAGE_SIZE);
+  std::vector<char> decompressed(PAGE_SIZE);
+  size_t size = PageCompressor::Compress(page.data(), PAGE_SIZE, compressed.data(), PAGE_SIZE);
+  if (size != 0) {
+    EXPECT_TRUE(PageCompressor::Decompress(compressed.data(), size, decompressed.data(), PAGE_SIZE));
+    EXPECT_EQ(page, decompressed);
+  }
+  return size;
+}
+
+// NOLINTNEXTLINE
+TEST(PageCompressorTest, RoundTripTest) {
+  std::mt19937 rng(15445);
+
+  // Zeroes shrink to a handful of bytes per KB.
+  std::vector<char> page(PAGE_SIZE);
+  size_t size = RoundTrip(page);
+  EXPECT_NE(0, size);
+  EXPECT_LT(size, PAGE_SIZE / 64);
+
+  // So do short repeating patterns.
+  for (size_t i = 0; i < PAGE_SIZE; i++) {
+    page[i] = static_cast<char>(i % 7);
+  }
+  size = RoundTrip(page);
+  EXPECT_NE(0, size);
+  EXPECT_LT(size, PAGE_SIZE / 64);
+
+  // Serial integers with random payloads compress somewhat.
+  for (size_t i = 0; i < PAGE_SIZE / 8; i++) {
+    auto key = static_cast<int32_t>(i);
+    auto payload = static_cast<int32_t>(rng() % 10);
+    std::memcpy(&page[i * 8], &key, sizeof(key));
+    std::memcpy(&page[i * 8 + 4], &payload, sizeof(payload));
+  }
+  size = RoundTrip(page);
+  EXPECT_NE(0, size);
+  EXPECT_LT(size, PAGE_SIZE);
+
+  // Noise does not fit.
+  std::generate(page.begin(), page.end(), rng);
+  EXPECT_EQ(0, RoundTrip(page));
+
+  // Every short prefix round-trips as well.
+  std::vector<char> compressed(2 * PAGE_SIZE);
+  std::vector<char> decompressed(PAGE_SIZE);
+  for (size_t len = 0; len < 32; len++) {
+    size = PageCompressor::Compress(page.data(), len, compressed.data(), compressed.size());
+    ASSERT_NE(0, size);
+    ASSERT_TRUE(PageCompressor::Decompress(compressed.data(), size, decompressed.data(), len));
+    EXPECT_EQ(0, std::memcmp(page.data(), decompressed.data(), len));
+  }
+}
+
+// NOLINTNEXTLINE
+TEST(PageCompressorTest, CorruptInputTest) {
+  std::vector<char> page(PAGE_SIZE);
+  std::snprintf(page.data(), PAGE_SIZE, "A test string.");
+  std::vector<char> compressed(PAGE_SIZE);
+  std::vector<char> decompressed(PAGE_SIZE);
+  size_t size = PageCompressor::Compress(page.data(), PAGE_SIZE, compressed.data(), PAGE_SIZE);
+  ASSERT_NE(0, size);
+
+  // Truncated input and a wrong output size are rejected.
+  EXPECT_FALSE(PageCompressor::Decompress(compressed.data(), size - 1, decompressed.data(), PAGE_SIZE));
+  EXPECT_FALSE(PageCompressor::Decompress(compressed.data(), size, decompressed.data(), PAGE_SIZE - 1));
+
+  // Random garbage never reads or writes out of bounds.
+  std::mt19937 rng(15445);
+  for (int i = 0; i < 1000; i++) {
+    std::generate(compressed.begin(), compressed.begin() + 64, rng);
+    PageCompressor::Decompress(compressed.data(), 64, decompressed.data(), PAGE_SIZE);
+  }
+}
+
+/** Generates the test tables into db_file and scans test_1 cold a number of times. @return the scan time in ms */
+static double GenerateAndScan(const std::string &db_file, bool compress_pages, size_t *stored_bytes,
+                              size_t *logical_bytes) {
+  const int rounds = 20;
+  page_id_t first_page_id;
+  {
+    auto disk_manager = std::make_unique<DiskManager>(db_file, compress_pages);
+    auto bpm = std::make_unique<BufferPoolManagerInstance>(256, disk_manager.get());
+    auto catalog = std::make_unique<Catalog>(bpm.get(), nullptr, nullptr);
+    Transaction txn{0};
+    auto exec_ctx = std::make_unique<ExecutorContext>(&txn, catalog.get(), bpm.get(), nullptr, nullptr);
+    TableGenerator gen{exec_ctx.get()};
+    gen.GenerateTestTables();
+    first_page_id = catalog->GetTable("test_1")->table_->GetFirstPageId();
+    bpm->FlushAllPages();
+    disk_manager->ShutDown();
+  }
+
+  auto disk_manager = std::make_unique<DiskManager>(db_file, compress_pages);
+  if (compress_pages) {
+    *stored_bytes = disk_manager->GetPageStore()->GetStoredBytes();
+    *logical_bytes = disk_manager->GetPageStore()->GetLogicalBytes();
+  }
+  size_t num_tuples = 0;
+  auto start = std::chrono::steady_clock::now();
+  for (int round = 0; round < rounds; round++) {
+    // A fresh buffer pool per round, so that every page comes from disk.
+    auto bpm = std::make_unique<BufferPoolManagerInstance>(16, disk_manager.get());
+    TableHeap table{bpm.get(), nullptr, nullptr, first_page_id};
+    Transaction txn{0};
+    for (auto it = table.Begin(&txn); it != table.End(); ++it) {
+      num_tuples++;
+    }
+  }
+  auto elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+  EXPECT_EQ(rounds * TEST1_SIZE, num_tuples);
+  disk_manager->ShutDown();
+  return elapsed;
+}
+
+// NOLINTNEXTLINE
+TEST(PageCompressorTest, TableScanBenchmarkTest) {
+  size_t stored_bytes = 0;
+  size_t logical_bytes = 0;
+  double raw_ms = GenerateAndScan("compressor_test_raw.db", false, &stored_bytes, &logical_bytes);
+  double compressed_ms = GenerateAndScan("compressor_test.db", true, &stored_bytes, &logical_bytes);
+  for (const auto *file : {"compressor_test_raw.db", "compressor_test_raw.log", "compressor_test.db",
+                           "compressor_test.log", "compressor_test.pmap"}) {
+    remove(file);
+  }
+
+  EXPECT_LT(stored_bytes, logical_bytes);
+  std::printf("stored %zu of %zu bytes (ratio %.2f)\n", stored_bytes, logical_bytes,
+              static_cast<double>(logical_bytes) / stored_bytes);
+  std::printf("cold scans: raw %.2f ms, compressed %.2f ms\n", raw_ms, compressed_ms);
+}
+
+}  // namespace bustub
@@ -10,17 +10,22 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include <unistd.h>
 #include <algorithm>
+#include <chrono>  // NOLINT
 #include <cstdio>
 #include <iostream>
 #include <string>
+#include <thread>  // NOLINT
 #include <vector>
 
 #include "buffer/buffer_pool_manager_instance.h"
+#include "common/logger.h"
 #include "gtest/gtest.h"
 #include "logging/common.h"
 #include "storage/table/table_heap.h"
 #include "storage/table/tuple.h"
+#include "type/value_factory.h"
 
 namespace bustub {
 // NOLINTNEXTLINE
@@ -71,4 +76,306 @@ TEST(TupleTest, DISABLED_TableHeapTest) {
   delete disk_manager;
 }
 
+// Benchmark; run it with --gtest_also_run_disabled_tests.
+// NOLINTNEXTLINE
+TEST(TupleTest, DISABLED_TableHeapReadAheadTest) {
+  Column col1{"a", TypeId::VARCHAR, 20};
+  Column col2{"b", TypeId::SMALLINT};
+  Column col3{"c", TypeId::BIGINT};
+  Column col4{"d", TypeId::BOOLEAN};
+  Column col5{"e", TypeId::VARCHAR, 16};
+  std::vector<Column> cols{col1, col2, col3, col4, col5};
+  Schema schema{cols};
+  Tuple tuple = ConstructTuple(&schema);
+
+  auto *transaction = new Transaction(0);
+  auto *disk_manager = new DiskManager("test.db");
+  auto *lock_manager = new LockManager();
+  auto *log_manager = new LogManager(disk_manager);
+
+  // Build a table much larger than the buffer pools used for scanning, and write it out.
+  const int num_tuples = 10000;
+  page_id_t first_page_id;
+  {
+    BufferPoolManagerInstance buffer_pool_manager(50, disk_manager);
+    TableHeap table(&buffer_pool_manager, lock_manager, log_manager, transaction);
+    for (int i = 0; i < num_tuples; ++i) {
+      RID rid;
+      ASSERT_TRUE(table.InsertTuple(tuple, &rid, transaction));
+    }
+    first_page_id = table.GetFirstPageId();
+    buffer_pool_manager.FlushAllPages();
+  }
+
+  // Scan the table cold, through a fresh buffer pool, with and without read-ahead.
+  for (size_t read_ahead : {0, 8}) {
+    BufferPoolManagerInstance buffer_pool_manager(32, disk_manager);
+    TableHeap table(&buffer_pool_manager, lock_manager, log_manager, first_page_id);
+    auto start = std::chrono::steady_clock::now();
+    int count = 0;
+    for (auto itr = table.Begin(transaction, nullptr, read_ahead); itr != table.End(); ++itr) {
+      EXPECT_EQ(tuple.GetLength(), itr->GetLength());
+      count++;
+    }
+    auto elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    EXPECT_EQ(num_tuples, count);
+    LOG_INFO("Cold scan with read-ahead %zu: %.2f ms", read_ahead, elapsed);
+  }
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  remove("test.log");
+  delete log_manager;
+  delete lock_manager;
+  delete disk_manager;
+  delete transaction;
+}
+
+// Benchmark; run it with --gtest_also_run_disabled_tests.
+// NOLINTNEXTLINE
+TEST(TupleTest, DISABLED_PageSizeBenchmarkTest) {
+  // Run with builds of different BUSTUB_PAGE_SIZE to compare scans and point lookups on a table that does not fit
+  // into the buffer pool.
+  Column col1{"a", TypeId::VARCHAR, 20};
+  Column col2{"b", TypeId::SMALLINT};
+  Column col3{"c", TypeId::BIGINT};
+  Column col4{"d", TypeId::BOOLEAN};
+  Column col5{"e", TypeId::VARCHAR, 16};
+  std::vector<Column> cols{col1, col2, col3, col4, col5};
+  Schema schema{cols};
+  Tuple tuple = ConstructTuple(&schema);
+
+  auto *transaction = new Transaction(0);
+  auto *disk_manager = new DiskManager("test.db");
+  auto *lock_manager = new LockManager();
+  auto *log_manager = new LogManager(disk_manager);
+
+  const int num_tuples = 20000;
+  const int num_lookups = 20000;
+  const size_t pool_bytes = 128 * 1024;
+  page_id_t first_page_id;
+  std::vector<RID> rids;
+  {
+    BufferPoolManagerInstance buffer_pool_manager(pool_bytes / PAGE_SIZE, disk_manager);
+    TableHeap table(&buffer_pool_manager, lock_manager, log_manager, transaction);
+    for (int i = 0; i < num_tuples; ++i) {
+      RID rid;
+      ASSERT_TRUE(table.InsertTuple(tuple, &rid, transaction));
+      rids.push_back(rid);
+    }
+    first_page_id = table.GetFirstPageId();
+    buffer_pool_manager.FlushAllPages();
+  }
+  std::shuffle(rids.begin(), rids.end(), std::default_random_engine(15445));
+  rids.resize(num_lookups);
+
+  // Both workloads run with the same buffer pool memory, whatever the page size.
+  BufferPoolManagerInstance buffer_pool_manager(pool_bytes / PAGE_SIZE, disk_manager);
+  TableHeap table(&buffer_pool_manager, lock_manager, log_manager, first_page_id);
+  uint64_t reads_before = buffer_pool_manager.GetStatsSnapshot().fetch_misses_;
+  auto start = std::chrono::steady_clock::now();
+  int count = 0;
+  for (auto itr = table.Begin(transaction); itr != table.End(); ++itr) {
+    count++;
+  }
+  auto scan_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+  size_t scan_reads = buffer_pool_manager.GetStatsSnapshot().fetch_misses_ - reads_before;
+  EXPECT_EQ(num_tuples, count);
+
+  reads_before = buffer_pool_manager.GetStatsSnapshot().fetch_misses_;
+  start = std::chrono::steady_clock::now();
+  for (const auto &rid : rids) {
+    Tuple result;
+    ASSERT_TRUE(table.GetTuple(rid, &result, transaction));
+  }
+  auto lookup_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+  size_t lookup_reads = buffer_pool_manager.GetStatsSnapshot().fetch_misses_ - reads_before;
+  LOG_INFO("Page size %d: scan %.2f ms (%zu page reads), %d point lookups %.2f ms (%zu page reads)", PAGE_SIZE,
+           scan_ms, scan_reads, num_lookups, lookup_ms, lookup_reads);
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  remove("test.log");
+  delete log_manager;
+  delete lock_manager;
+  delete disk_manager;
+  delete transaction;
+}
+
+// NOLINTNEXTLINE
+TEST(TupleTest, TableHeapTablespaceTest) {
+  Column col1{"a", TypeId::VARCHAR, 20};
+  Column col2{"b", TypeId::BIGINT};
+  std::vector<Column> cols{col1, col2};
+  Schema schema{cols};
+  Tuple tuple = ConstructTuple(&schema);
+
+  auto *transaction = new Transaction(0);
+  auto *disk_manager = new DiskManager("test.db");
+  auto *buffer_pool_manager = new BufferPoolManagerInstance(10, disk_manager);
+  auto *lock_manager = new LockManager();
+  auto *log_manager = new LogManager(disk_manager);
+
+  // A table in a tablespace of its own keeps all of its pages there.
+  tablespace_id_t space_id = disk_manager->CreateTablespace();
+  ASSERT_NE(INVALID_TABLESPACE_ID, space_id);
+  std::string space_file = disk_manager->GetTablespaceFileName(space_id);
+  auto *table = new TableHeap(buffer_pool_manager, lock_manager, log_manager, transaction, space_id);
+  const int num_tuples = 5000;
+  for (int i = 0; i < num_tuples; ++i) {
+    RID rid;
+    ASSERT_TRUE(table->InsertTuple(tuple, &rid, transaction));
+    EXPECT_EQ(space_id, TablespaceOf(rid.GetPageId()));
+  }
+  int count = 0;
+  for (auto itr = table->Begin(transaction); itr != table->End(); ++itr) {
+    count++;
+  }
+  EXPECT_EQ(num_tuples, count);
+  EXPECT_GT(disk_manager->GetFreePageMap(space_id)->GetEndPageId(), 10);
+  EXPECT_EQ(0, disk_manager->GetFreePageMap()->GetEndPageId());
+
+  // Dropping the table drops its pages from the pool and removes its file, without writing anything back.
+  int num_writes = disk_manager->GetNumWrites();
+  EXPECT_TRUE(buffer_pool_manager->DiscardTablespace(space_id));
+  EXPECT_TRUE(disk_manager->DropTablespace(space_id));
+  EXPECT_EQ(num_writes, disk_manager->GetNumWrites());
+  EXPECT_NE(0, access(space_file.c_str(), F_OK));
+  page_id_t page_id;
+  EXPECT_EQ(nullptr, buffer_pool_manager->NewPage(&page_id, space_id));
+  for (size_t i = 0; i < 10; i++) {
+    EXPECT_NE(nullptr, buffer_pool_manager->NewPage(&page_id));
+  }
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  remove("test.log");
+  delete table;
+  delete buffer_pool_manager;
+  delete log_manager;
+  delete lock_manager;
+  delete disk_manager;
+  delete transaction;
+}
+
+// NOLINTNEXTLINE
+TEST(TupleTest, OptimisticReadTest) {
+  // Every column of a tuple holds the same value, so a torn read shows up as differing columns.
+  const uint32_t num_columns = 8;
+  std::vector<Column> cols;
+  for (uint32_t i = 0; i < num_columns; i++) {
+    cols.emplace_back("c" + std::to_string(i), TypeId::BIGINT);
+  }
+  Schema schema{cols};
+  auto make_tuple = [&](int64_t value) {
+    return Tuple(std::vector<Value>(num_columns, ValueFactory::GetBigIntValue(value)), &schema);
+  };
+
+  auto *transaction = new Transaction(0);
+  auto *disk_manager = new DiskManager("test.db");
+  auto *buffer_pool_manager = new BufferPoolManagerInstance(10, disk_manager);
+  auto *lock_manager = new LockManager();
+  auto *log_manager = new LogManager(disk_manager);
+  auto *table = new TableHeap(buffer_pool_manager, lock_manager, log_manager, transaction);
+
+  RID rid;
+  ASSERT_TRUE(table->InsertTuple(make_tuple(0), &rid, transaction));
+  auto *page = static_cast<TablePage *>(buffer_pool_manager->FetchPage(rid.GetPageId()));
+
+  // Scenario: without writers, optimistic reads succeed and see the tuple; missing slots are reported as such.
+  Tuple tuple;
+  bool exists = false;
+  ASSERT_TRUE(page->TryGetTupleOptimistic(rid, &tuple, &exists));
+  EXPECT_TRUE(exists);
+  EXPECT_EQ(0, tuple.GetValue(&schema, 0).GetAs<int64_t>());
+  ASSERT_TRUE(page->TryGetTupleOptimistic(RID(rid.GetPageId(), 5), &tuple, &exists));
+  EXPECT_FALSE(exists);
+
+  // Scenario: while a writer holds the latch, optimistic reads fail.
+  page->WLatch();
+  EXPECT_FALSE(page->TryGetTupleOptimistic(rid, &tuple, &exists));
+  page->WUnlatch();
+
+  // Scenario: readers never see a torn tuple while a writer keeps rewriting it.
+  std::atomic<int> readers_left{2};
+  std::atomic<int64_t> last_value{0};
+  std::thread writer([&] {
+    for (int64_t value = 1; readers_left > 0; value++) {
+      Tuple old_tuple;
+      page->WLatch();
+      page->UpdateTuple(make_tuple(value), &old_tuple, rid, transaction, lock_manager, log_manager);
+      page->WUnlatch();
+      last_value = value;
+    }
+  });
+  std::vector<std::thread> readers;
+  for (int i = 0; i < 2; i++) {
+    readers.emplace_back([&] {
+      Tuple read;
+      bool found;
+      for (int reads = 0; reads < 1000;) {
+        if (!page->TryGetTupleOptimistic(rid, &read, &found)) {
+          // Let a preempted writer finish.
+          std::this_thread::yield();
+        } else {
+          ASSERT_TRUE(found);
+          auto first = read.GetValue(&schema, 0).GetAs<int64_t>();
+          for (uint32_t c = 1; c < num_columns; c++) {
+            ASSERT_EQ(first, read.GetValue(&schema, c).GetAs<int64_t>());
+          }
+          reads++;
+        }
+      }
+      readers_left--;
+    });
+  }
+  writer.join();
+  for (auto &reader : readers) {
+    reader.join();
+  }
+  ASSERT_TRUE(table->GetTuple(rid, &tuple, transaction));
+  EXPECT_EQ(last_value, tuple.GetValue(&schema, num_columns - 1).GetAs<int64_t>());
+
+  // Read scaling: latched against optimistic reads of the same tuple from a growing number of threads.
+  const int reads_per_thread = 100000;
+  for (int num_threads : {1, 2, 4}) {
+    double elapsed[2];
+    for (int optimistic = 0; optimistic < 2; optimistic++) {
+      auto start = std::chrono::steady_clock::now();
+      std::vector<std::thread> threads;
+      for (int t = 0; t < num_threads; t++) {
+        threads.emplace_back([&, optimistic] {
+          Tuple read;
+          bool found;
+          for (int i = 0; i < reads_per_thread; i++) {
+            if (optimistic == 1 && page->TryGetTupleOptimistic(rid, &read, &found)) {
+              continue;
+            }
+            page->RLatch();
+            page->GetTuple(rid, &read, transaction, lock_manager);
+            page->RUnlatch();
+          }
+        });
+      }
+      for (auto &thread : threads) {
+        thread.join();
+      }
+      elapsed[optimistic] = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+    LOG_INFO("%d threads x %d reads: latched %.2f ms, optimistic %.2f ms", num_threads, reads_per_thread, elapsed[0],
+             elapsed[1]);
+  }
+
+  buffer_pool_manager->UnpinPage(rid.GetPageId(), false);
+  disk_manager->ShutDown();
+  remove("test.db");
+  remove("test.log");
+  delete table;
+  delete log_manager;
+  delete lock_manager;
+  delete buffer_pool_manager;
+  delete disk_manager;
+  delete transaction;
+}
+
 }  // namespace bustub